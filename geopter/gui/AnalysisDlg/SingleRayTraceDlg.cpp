@@ -100,7 +100,8 @@ void SingleRayTraceDlg::doPupilRayTrace()
 
     // trace
     SequentialTrace *tracer = new SequentialTrace(m_opticalSystem);
-    SequentialPath seq_path = tracer->CreateSequentialPath(wvl);
+    auto seq_path_ptr = tracer->GetSequentialPath(wvl);
+    const SequentialPath& seq_path = *seq_path_ptr;
     auto ray_trace_result = std::make_shared<Ray>(seq_path.Size());
     tracer->TracePupilRay(ray_trace_result, seq_path, pupil_crd, fld, wvl);
     delete tracer;
@@ -139,7 +140,8 @@ void SingleRayTraceDlg::doObjectRayTrace()
     double wvl = m_opticalSystem->GetOpticalSpec()->GetWavelengthSpec()->GetWavelength(wi)->Value();
 
     SequentialTrace *tracer = new SequentialTrace(m_opticalSystem);
-    SequentialPath seq_path = tracer->CreateSequentialPath(wvl);
+    auto seq_path_ptr = tracer->GetSequentialPath(wvl);
+    const SequentialPath& seq_path = *seq_path_ptr;
     auto ray_trace_result = std::make_shared<Ray>(seq_path.Size());
     tracer->TraceRayThroughoutPath(ray_trace_result, seq_path, p0, dir0);
     delete tracer;
@@ -0,0 +1,467 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+/**
+ * geopter-bench
+ *
+ * Times the main trace and analysis paths over the bundled example lenses.
+ * Each benchmark is run several times and the fastest run is reported, which is the most stable figure on a busy machine.
+ *
+ * Usage: geopter-bench [--root DIR] [--json FILE] [--repeat N] [--threads N] [--nrd N]
+ *   --root     directory holding "example" and "AGF" (or "data/AGF"). Defaults to the current directory.
+ *   --json     write the results to FILE for comparison across commits
+ *   --repeat   number of runs per benchmark (default 5)
+ *   --threads  number of threads of the shared pool (default: hardware concurrency)
+ *   --nrd      pupil sampling used for the ray trace benchmarks (default 64)
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <functional>
+#include <filesystem>
+#include <algorithm>
+#include <limits>
+
+#include "nlohmann/json.hpp"
+
+#include "optical.h"
+
+using namespace geopter;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct BenchResult
+{
+    std::string lens;
+    std::string name;
+    double ms;
+    long long rays;
+};
+
+struct BenchConfig
+{
+    std::string root = ".";
+    std::string json_path;
+    int repeat  = 5;
+    int threads = 0;
+    int nrd     = 64;
+};
+
+class BenchRunner
+{
+public:
+    explicit BenchRunner(int repeat) : repeat_(std::max(1, repeat)) {}
+
+    /** Run fn repeatedly and record the fastest run */
+    void Run(const std::string& lens, const std::string& name, long long rays, const std::function<void()>& fn)
+    {
+        double best = std::numeric_limits<double>::max();
+        for(int i = 0; i < repeat_; i++){
+            auto t0 = std::chrono::steady_clock::now();
+            fn();
+            auto t1 = std::chrono::steady_clock::now();
+            best = std::min(best, std::chrono::duration<double, std::milli>(t1 - t0).count());
+        }
+        results_.push_back(BenchResult{lens, name, best, rays});
+        Print(results_.back());
+    }
+
+    const std::vector<BenchResult>& Results() const { return results_; }
+
+    static void PrintHeader()
+    {
+        std::cout << std::setw(28) << std::left << "lens"
+                  << std::setw(16) << std::left << "benchmark"
+                  << std::setw(12) << std::right << "ms"
+                  << std::setw(10) << std::right << "rays"
+                  << std::setw(12) << std::right << "ns/ray"
+                  << std::setw(14) << std::right << "rays/s"
+                  << std::endl;
+    }
+
+private:
+    static void Print(const BenchResult& r)
+    {
+        std::cout << std::setw(28) << std::left << r.lens.substr(0, 27)
+                  << std::setw(16) << std::left << r.name
+                  << std::setw(12) << std::right << std::fixed << std::setprecision(3) << r.ms;
+        if(r.rays > 0){
+            std::cout << std::setw(10) << std::right << r.rays
+                      << std::setw(12) << std::right << std::setprecision(1) << r.ms * 1.0e6 / r.rays
+                      << std::setw(14) << std::right << std::setprecision(0) << r.rays / (r.ms * 1.0e-3);
+        }else{
+            std::cout << std::setw(10) << std::right << "-"
+                      << std::setw(12) << std::right << "-"
+                      << std::setw(14) << std::right << "-";
+        }
+        std::cout << std::endl;
+    }
+
+    int repeat_;
+    std::vector<BenchResult> results_;
+};
+
+bool ParseArgs(int argc, char** argv, BenchConfig& cfg)
+{
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if(i + 1 >= argc){
+            std::cerr << "Missing value for " << arg << std::endl;
+            return false;
+        }
+
+        std::string val = argv[++i];
+        try{
+            if(arg == "--root"){
+                cfg.root = val;
+            }else if(arg == "--json"){
+                cfg.json_path = val;
+            }else if(arg == "--repeat"){
+                cfg.repeat = std::stoi(val);
+            }else if(arg == "--threads"){
+                cfg.threads = std::stoi(val);
+            }else if(arg == "--nrd"){
+                cfg.nrd = std::max(2, std::stoi(val));
+            }else{
+                std::cerr << "Unknown option: " << arg << std::endl;
+                return false;
+            }
+        }catch(...){
+            std::cerr << "Invalid value for " << arg << ": " << val << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<std::string> FindFiles(const fs::path& dir, const std::string& ext, bool recursive)
+{
+    std::vector<std::string> files;
+    std::error_code ec;
+    if(!fs::is_directory(dir, ec)){
+        return files;
+    }
+
+    auto accept = [&](const fs::directory_entry& e){
+        if(!e.is_regular_file()) return;
+        std::string e_ext = e.path().extension().u8string();
+        std::transform(e_ext.begin(), e_ext.end(), e_ext.begin(), ::tolower);
+        if(e_ext == ext){
+            files.push_back(e.path().u8string());
+        }
+    };
+
+    if(recursive){
+        for(auto& e : fs::recursive_directory_iterator(dir, ec)) accept(e);
+    }else{
+        for(auto& e : fs::directory_iterator(dir, ec)) accept(e);
+    }
+
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+std::vector<std::string> FindLenses(const fs::path& root)
+{
+    const fs::path example = root / "example";
+
+    std::vector<std::string> lenses;
+    if(fs::exists(example / "dbgauss.json")){
+        lenses.push_back((example / "dbgauss.json").u8string());
+    }
+
+    for(auto& f : FindFiles(example / "book", ".json", false)){
+        lenses.push_back(f);
+    }
+    for(auto& f : FindFiles(example / "patent_data", ".json", true)){
+        lenses.push_back(f);
+    }
+    return lenses;
+}
+
+std::vector<std::string> FindAgfFiles(const fs::path& root)
+{
+    std::vector<std::string> agfs = FindFiles(root / "AGF", ".agf", false);
+    if(agfs.empty()){
+        agfs = FindFiles(root / "data" / "AGF", ".agf", false);
+    }
+    return agfs;
+}
+
+/** Copy the AGF files to a scratch directory so that cold loads do not touch the binary caches next to the originals */
+std::vector<std::string> CopyAgfFiles(const std::vector<std::string>& agfs, const fs::path& dir)
+{
+    std::vector<std::string> copies;
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    for(auto& f : agfs){
+        fs::path dst = dir / fs::path(f).filename();
+        fs::copy_file(f, dst, fs::copy_options::overwrite_existing, ec);
+        if(!ec){
+            copies.push_back(dst.u8string());
+        }
+    }
+    return copies;
+}
+
+/** Number of rays traced by fn, counted in an untimed run with trace statistics attached to the system */
+long long CountRays(OpticalSystem& sys, const std::function<void()>& fn)
+{
+    auto stats = std::make_shared<TraceStatistics>();
+    sys.SetTraceStatistics(stats);
+    fn();
+    sys.SetTraceStatistics(nullptr);
+    return stats->NumberOfRays();
+}
+
+/** Run fn as an analysis benchmark, reporting the rays it traces */
+void RunAnalysis(BenchRunner& runner, OpticalSystem& sys, const std::string& lens, const std::string& name, const std::function<void()>& fn)
+{
+    runner.Run(lens, name, CountRays(sys, fn), fn);
+}
+
+void BenchmarkLens(BenchRunner& runner, OpticalSystem& sys, const std::string& lens_path, const BenchConfig& cfg)
+{
+    sys.LoadFile(lens_path);
+
+    const std::string lens = fs::path(lens_path).stem().u8string();
+
+    FieldSpec* fld_spec = sys.GetOpticalSpec()->GetFieldSpec();
+    const int num_flds = fld_spec->NumberOfFields();
+    if(num_flds == 0){
+        std::cerr << "No field in " << lens_path << std::endl;
+        return;
+    }
+    const Field* fld = fld_spec->GetField(num_flds - 1);
+    const double wvl = sys.GetOpticalSpec()->GetWavelengthSpec()->ReferenceWavelength();
+
+    SequentialTrace tracer(&sys);
+    auto p = tracer.GetSequentialPath(wvl);
+    const SequentialPath& seq_path = *p;
+
+    const std::vector<Eigen::Vector2d> pupils = SequentialTrace::GridPupils(cfg.nrd);
+    const long long num_pupils = pupils.size();
+
+    runner.Run(lens, "update_model", 0, [&](){
+        sys.UpdateModel();
+    });
+
+    runner.Run(lens, "single_ray", num_pupils, [&](){
+        auto ray = std::make_shared<Ray>(seq_path.Size());
+        for(auto& pupil : pupils){
+            tracer.TracePupilRay(ray, seq_path, pupil, fld, wvl);
+        }
+    });
+
+    runner.Run(lens, "bundle", num_pupils, [&](){
+        RayBundle bundle(num_pupils, seq_path.Size(), true);
+        tracer.TracePupilBundle(bundle, seq_path, pupils, fld, wvl);
+    });
+
+    constexpr int reps = 100;
+    runner.Run(lens, "reference_rays", 5LL*reps*num_flds, [&](){
+        std::vector<RayPtr> ref_rays;
+        for(int r = 0; r < reps; r++){
+            for(int fi = 0; fi < num_flds; fi++){
+                tracer.TraceReferenceRays(ref_rays, fld_spec->GetField(fi), wvl);
+            }
+        }
+    });
+
+    RunAnalysis(runner, sys, lens, "spot", [&](){
+        SpotDiagram spot(&sys);
+        spot.plot(fld, 0, cfg.nrd, 1.0);
+    });
+
+    RunAnalysis(runner, sys, lens, "geometric_mtf", [&](){
+        GeometricalMTF geo_mtf;
+        geo_mtf.plot(&sys, cfg.nrd);
+    });
+
+    RunAnalysis(runner, sys, lens, "wavefront", [&](){
+        WavefrontMap wavefront(&sys);
+        wavefront.Create(fld, wvl, cfg.nrd);
+    });
+
+    RunAnalysis(runner, sys, lens, "fft_psf", [&](){
+        DiffractivePSF psf(&sys);
+        psf.Create(fld, wvl, cfg.nrd);
+    });
+
+    RunAnalysis(runner, sys, lens, "fft_mtf", [&](){
+        DiffractiveMTF mtf(&sys);
+        mtf.plot(&sys, cfg.nrd);
+    });
+}
+
+bool WriteJson(const std::string& path, const BenchConfig& cfg, const std::vector<BenchResult>& results)
+{
+    nlohmann::json j;
+    j["Threads"] = ThreadPool::GlobalThreadCount();
+    j["Repeat"]  = cfg.repeat;
+    j["Nrd"]     = cfg.nrd;
+    j["InstructionSet"] = ConicKernel::InstructionSetName(ConicKernel::InstructionSet());
+
+    nlohmann::json arr = nlohmann::json::array();
+    for(auto& r : results){
+        nlohmann::json item;
+        item["Lens"] = r.lens;
+        item["Benchmark"] = r.name;
+        item["Milliseconds"] = r.ms;
+        item["Rays"] = r.rays;
+        if(r.rays > 0){
+            item["NsPerRay"] = r.ms * 1.0e6 / r.rays;
+            item["RaysPerSec"] = r.rays / (r.ms * 1.0e-3);
+        }
+        arr.push_back(item);
+    }
+    j["Results"] = arr;
+
+    std::ofstream ofs(path);
+    if(!ofs){
+        std::cerr << "Failed to write " << path << std::endl;
+        return false;
+    }
+    ofs << std::setw(4) << j << std::endl;
+    return true;
+}
+
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+    BenchConfig cfg;
+    if(!ParseArgs(argc, argv, cfg)){
+        return 1;
+    }
+
+    if(cfg.threads > 0){
+        ThreadPool::SetGlobalThreadCount(cfg.threads);
+    }
+
+    const fs::path root = cfg.root;
+    const std::vector<std::string> agfs   = FindAgfFiles(root);
+    const std::vector<std::string> lenses = FindLenses(root);
+
+    if(agfs.empty()){
+        std::cerr << "No AGF file found under " << root.u8string() << std::endl;
+        return 1;
+    }
+    if(lenses.empty()){
+        std::cerr << "No example lens found under " << root.u8string() << std::endl;
+        return 1;
+    }
+
+    std::cout << "Threads: " << ThreadPool::GlobalThreadCount()
+              << ", instruction set: " << ConicKernel::InstructionSetName(ConicKernel::InstructionSet())
+              << ", repeat: " << cfg.repeat
+              << ", nrd: " << cfg.nrd << std::endl;
+
+    BenchRunner runner(cfg.repeat);
+    BenchRunner::PrintHeader();
+
+    // AGF loading, from the text and from the binary cache.
+    // All loads read the copies, so the caches are written to the scratch directory only.
+    const fs::path scratch = fs::temp_directory_path() / "geopter-bench-agf";
+    const std::vector<std::string> agf_copies = CopyAgfFiles(agfs, scratch);
+
+    const bool cache_enabled = GlassCatalog::CacheEnabled();
+
+    GlassCatalog::SetCacheEnabled(false);
+    runner.Run("-", "agf_parse", 0, [&](){
+        MaterialLibrary lib;
+        lib.LoadAgfFiles(agf_copies);
+    });
+
+    GlassCatalog::SetCacheEnabled(true);
+    {
+        MaterialLibrary lib;
+        lib.LoadAgfFiles(agf_copies); // writes the caches
+    }
+    runner.Run("-", "agf_cached", 0, [&](){
+        MaterialLibrary lib;
+        lib.LoadAgfFiles(agf_copies);
+    });
+
+    OpticalSystem sys;
+    sys.GetMaterialLib()->LoadAgfFiles(agf_copies);
+
+    // refractive indices of all catalog glasses, one index per wavelength and glass in the rays column.
+    // 64 wavelengths overflow the per-glass index cache, so the scalar path computes every index.
+    {
+        std::vector<std::shared_ptr<Glass>> glasses;
+        for(int ci = 0; ci < sys.GetMaterialLib()->NumberOfCatalogs(); ci++){
+            GlassCatalog* cat = MaterialLibrary::GetGlassCatalog(ci);
+            for(int gi = 0; gi < cat->NumberOfGlasses(); gi++){
+                glasses.push_back(cat->GetGlass(gi));
+            }
+        }
+
+        std::vector<double> wvls_nm(64);
+        for(int i = 0; i < 64; i++){
+            wvls_nm[i] = 400.0 + 5.0*i;
+        }
+        const long long num_indices = (long long)glasses.size()*wvls_nm.size();
+
+        // keeps the loops from being optimized away
+        volatile double sink = 0.0;
+
+        runner.Run("-", "index_scalar", num_indices, [&](){
+            for(auto& g : glasses){
+                for(double w : wvls_nm){
+                    sink = g->RefractiveIndex(w);
+                }
+            }
+        });
+        runner.Run("-", "index_batch", num_indices, [&](){
+            for(auto& g : glasses){
+                sink = g->RefractiveIndices(wvls_nm).back();
+            }
+        });
+    }
+
+    GlassCatalog::SetCacheEnabled(cache_enabled);
+
+    for(auto& lens_path : lenses){
+        BenchmarkLens(runner, sys, lens_path, cfg);
+    }
+
+    std::error_code ec;
+    fs::remove_all(scratch, ec);
+
+    if(!cfg.json_path.empty()){
+        if(!WriteJson(cfg.json_path, cfg, runner.Results())){
+            return 1;
+        }
+    }
+
+    return 0;
+}
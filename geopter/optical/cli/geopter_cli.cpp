@@ -0,0 +1,718 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+/**
+ * geopter-cli
+ *
+ * Headless batch runner. Runs the analyses listed in a job file on each lens and writes the results as CSV, NPY or JSON.
+ * Lenses are processed in parallel on the shared thread pool.
+ *
+ * Usage: geopter-cli [--out DIR] [--format csv|npy|json] [--threads N] [--agf PATH]... JOB.json [LENS.json|DIR]...
+ *
+ * Job file:
+ * {
+ *     "AGF":      ["path/to/AGF"],          AGF files or directories. Defaults to AGF next to the executable.
+ *     "Lenses":   ["lens.json", "dir"],     lenses in addition to the command line. Directories are searched recursively.
+ *     "Output":   "results",                output directory
+ *     "Format":   "csv",                    csv, npy or json
+ *     "Analyses": [
+ *         {"Type": "FirstOrder"},
+ *         {"Type": "Spot", "Fields": [0, 2], "Nrd": 20, "Pattern": "Grid"},
+ *         {"Type": "RayFan", "Nrd": 20, "PupilDir": 1, "AbrDir": 1},
+ *         {"Type": "OpdFan", "Nrd": 20},
+ *         {"Type": "GeometricalMTF", "Nrd": 20, "MaxFreq": 100, "FreqStep": 5},
+ *         {"Type": "DiffractiveMTF", "Samples": 64},
+ *         {"Type": "AutocorrelationMTF", "Samples": 64, "MaxFreq": 100, "FreqStep": 5},
+ *         {"Type": "Wavefront", "Wavelengths": [0, 1], "Samples": 64},
+ *         {"Type": "PSF", "Samples": 64},
+ *         {"Type": "Zernike", "Samples": 64, "Terms": 37},
+ *         {"Type": "ThroughFocus", "Nrd": 20, "FocusMin": -0.1, "FocusMax": 0.1, "Steps": 21, "MtfFreq": 30}
+ *     ]
+ * }
+ *
+ * "Fields" and "Wavelengths" are indices. Fields default to all of them, wavelengths to the reference one.
+ * Results are written to OUT/<lens>/<analysis>[_f<field>][_w<wavelength>].<ext>, and OUT/summary.json records the status of each lens.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <filesystem>
+#include <algorithm>
+#include <mutex>
+#include <map>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "nlohmann/json.hpp"
+
+#include "optical.h"
+
+using namespace geopter;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+enum class OutputFormat
+{
+    Csv,
+    Npy,
+    Json
+};
+
+struct CliConfig
+{
+    std::string job_path;
+    std::vector<std::string> lens_args;
+    std::vector<std::string> agf_args;
+    std::string out_dir;
+    std::string format;
+    int threads = 0;
+};
+
+struct LensResult
+{
+    std::string lens_path;
+    std::string name;
+    bool success = false;
+    std::string message;
+    double ms = 0.0;
+    int num_outputs = 0;
+};
+
+bool ParseArgs(int argc, char** argv, CliConfig& cfg)
+{
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+
+        if(arg.size() > 2 && arg.compare(0, 2, "--") == 0){
+            if(i + 1 >= argc){
+                std::cerr << "Missing value for " << arg << std::endl;
+                return false;
+            }
+            std::string val = argv[++i];
+
+            if(arg == "--out"){
+                cfg.out_dir = val;
+            }else if(arg == "--format"){
+                cfg.format = val;
+            }else if(arg == "--agf"){
+                cfg.agf_args.push_back(val);
+            }else if(arg == "--threads"){
+                try{
+                    cfg.threads = std::stoi(val);
+                }catch(...){
+                    std::cerr << "Invalid value for " << arg << ": " << val << std::endl;
+                    return false;
+                }
+            }else{
+                std::cerr << "Unknown option: " << arg << std::endl;
+                return false;
+            }
+        }else if(cfg.job_path.empty()){
+            cfg.job_path = arg;
+        }else{
+            cfg.lens_args.push_back(arg);
+        }
+    }
+
+    if(cfg.job_path.empty()){
+        std::cerr << "Usage: geopter-cli [--out DIR] [--format csv|npy|json] [--threads N] [--agf PATH]... JOB.json [LENS.json|DIR]..." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool ParseFormat(const std::string& str, OutputFormat& format)
+{
+    std::string s = str;
+    std::transform(s.begin(), s.end(), s.begin(), ::tolower);
+    if(s == "csv"){
+        format = OutputFormat::Csv;
+    }else if(s == "npy"){
+        format = OutputFormat::Npy;
+    }else if(s == "json"){
+        format = OutputFormat::Json;
+    }else{
+        return false;
+    }
+    return true;
+}
+
+/** Expand files and directories into a sorted list of files with the given extension */
+std::vector<std::string> CollectFiles(const std::vector<std::string>& paths, const std::string& ext)
+{
+    std::vector<std::string> files;
+    std::error_code ec;
+
+    auto has_ext = [&](const fs::path& p){
+        std::string e = p.extension().u8string();
+        std::transform(e.begin(), e.end(), e.begin(), ::tolower);
+        return e == ext;
+    };
+
+    for(auto& path : paths){
+        if(fs::is_directory(path, ec)){
+            std::vector<std::string> found;
+            for(auto& e : fs::recursive_directory_iterator(path, ec)){
+                if(e.is_regular_file() && has_ext(e.path())){
+                    found.push_back(e.path().u8string());
+                }
+            }
+            std::sort(found.begin(), found.end());
+            files.insert(files.end(), found.begin(), found.end());
+        }else{
+            // missing files are kept so that they are reported as failures
+            files.push_back(path);
+        }
+    }
+    return files;
+}
+
+std::vector<std::string> ToStringList(const nlohmann::json& j)
+{
+    std::vector<std::string> list;
+    if(j.is_string()){
+        list.push_back(j.get<std::string>());
+    }else if(j.is_array()){
+        for(auto& v : j){
+            list.push_back(v.get<std::string>());
+        }
+    }
+    return list;
+}
+
+/** Indices given by the key, or the default when absent */
+std::vector<int> Indices(const nlohmann::json& job, const std::string& key, int count, const std::vector<int>& default_indices)
+{
+    if(job.find(key) == job.end()){
+        return default_indices;
+    }
+
+    std::vector<int> indices;
+    for(auto& v : job[key]){
+        int i = v.get<int>();
+        if(i >= 0 && i < count){
+            indices.push_back(i);
+        }else{
+            std::cerr << key << " index out of range: " << i << std::endl;
+        }
+    }
+    return indices;
+}
+
+/** Output names derived from the file names, with a suffix for duplicates */
+std::vector<std::string> UniqueNames(const std::vector<std::string>& lens_paths)
+{
+    std::vector<std::string> names;
+    std::map<std::string, int> counts;
+    for(auto& p : lens_paths){
+        std::string stem = fs::path(p).stem().u8string();
+        int n = counts[stem]++;
+        names.push_back(n == 0 ? stem : stem + "_" + std::to_string(n));
+    }
+    return names;
+}
+
+
+/** Writes PlotData and DataGrid in the selected format */
+class ResultWriter
+{
+public:
+    ResultWriter(const fs::path& dir, OutputFormat format) : dir_(dir), format_(format), num_outputs_(0) {}
+
+    int NumberOfOutputs() const { return num_outputs_; }
+
+    bool Write(const std::string& name, const std::shared_ptr<PlotData>& plot_data)
+    {
+        if(!plot_data){
+            return false;
+        }
+
+        switch(format_){
+        case OutputFormat::Csv:
+        {
+            std::ofstream ofs = Open(name + ".csv");
+            ofs << std::setprecision(15);
+            ofs << "graph," << CsvField(plot_data->XLabel()) << "," << CsvField(plot_data->YLabel()) << std::endl;
+            for(int gi = 0; gi < plot_data->NumberOfGraphs(); gi++){
+                auto graph = plot_data->GetGraph(gi);
+                const std::string graph_name = CsvField(graph->Name());
+                for(int i = 0; i < graph->NumberOfData(); i++){
+                    ofs << graph_name << "," << graph->XData()[i] << "," << graph->YData()[i] << "\n";
+                }
+            }
+            return Close(ofs);
+        }
+        case OutputFormat::Npy:
+        {
+            bool ok = true;
+            for(int gi = 0; gi < plot_data->NumberOfGraphs(); gi++){
+                auto graph = plot_data->GetGraph(gi);
+                const int n = graph->NumberOfData();
+                std::vector<double> xy(2*n);
+                for(int i = 0; i < n; i++){
+                    xy[2*i]     = graph->XData()[i];
+                    xy[2*i + 1] = graph->YData()[i];
+                }
+                ok &= WriteNpy(name + "_g" + std::to_string(gi) + ".npy", xy.data(), n, 2);
+            }
+            return ok;
+        }
+        case OutputFormat::Json:
+        {
+            nlohmann::json j;
+            j["Title"]  = plot_data->title();
+            j["XLabel"] = plot_data->XLabel();
+            j["YLabel"] = plot_data->YLabel();
+            j["Graphs"] = nlohmann::json::array();
+            for(int gi = 0; gi < plot_data->NumberOfGraphs(); gi++){
+                auto graph = plot_data->GetGraph(gi);
+                nlohmann::json g;
+                g["Name"] = graph->Name();
+                g["X"] = graph->XData();
+                g["Y"] = graph->YData();
+                j["Graphs"].push_back(g);
+            }
+            return WriteJson(name, j);
+        }
+        }
+        return false;
+    }
+
+    bool Write(const std::string& name, const std::shared_ptr<DataGrid>& grid)
+    {
+        if(!grid){
+            return false;
+        }
+
+        const Eigen::MatrixXd& m = grid->ValueData();
+
+        switch(format_){
+        case OutputFormat::Csv:
+        {
+            std::ofstream ofs = Open(name + ".csv");
+            ofs << std::setprecision(15);
+            for(int i = 0; i < m.rows(); i++){
+                for(int j = 0; j < m.cols(); j++){
+                    if(j > 0) ofs << ",";
+                    ofs << m(i,j);
+                }
+                ofs << "\n";
+            }
+            return Close(ofs);
+        }
+        case OutputFormat::Npy:
+        {
+            // row-major copy
+            Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> rm = m;
+            return WriteNpy(name + ".npy", rm.data(), rm.rows(), rm.cols());
+        }
+        case OutputFormat::Json:
+        {
+            nlohmann::json j;
+            j["Description"] = grid->Description();
+            j["Dx"] = grid->Dx();
+            j["Dy"] = grid->Dy();
+            j["Values"] = nlohmann::json::array();
+            for(int i = 0; i < m.rows(); i++){
+                nlohmann::json row = nlohmann::json::array();
+                for(int j = 0; j < m.cols(); j++){
+                    if(std::isfinite(m(i,j))){
+                        row.push_back(m(i,j));
+                    }else{
+                        row.push_back(nullptr);
+                    }
+                }
+                j["Values"].push_back(row);
+            }
+            return WriteJson(name, j);
+        }
+        }
+        return false;
+    }
+
+    /** Scalar values are written as CSV (name,value) unless JSON is selected */
+    bool Write(const std::string& name, const std::vector<std::pair<std::string, double>>& values)
+    {
+        if(format_ == OutputFormat::Json){
+            nlohmann::json j;
+            for(auto& v : values){
+                j[v.first] = v.second;
+            }
+            return WriteJson(name, j);
+        }
+
+        std::ofstream ofs = Open(name + ".csv");
+        ofs << std::setprecision(15);
+        ofs << "name,value" << std::endl;
+        for(auto& v : values){
+            ofs << v.first << "," << v.second << "\n";
+        }
+        return Close(ofs);
+    }
+
+private:
+    std::ofstream Open(const std::string& filename)
+    {
+        std::ofstream ofs(dir_ / filename, std::ios::binary);
+        if(!ofs){
+            std::cerr << "Failed to open " << (dir_ / filename).u8string() << std::endl;
+        }
+        return ofs;
+    }
+
+    bool Close(std::ofstream& ofs)
+    {
+        if(!ofs){
+            return false;
+        }
+        ofs.close();
+        num_outputs_++;
+        return true;
+    }
+
+    bool WriteJson(const std::string& name, const nlohmann::json& j)
+    {
+        std::ofstream ofs = Open(name + ".json");
+        ofs << std::setw(4) << j << std::endl;
+        return Close(ofs);
+    }
+
+    /** NPY version 1.0, float64 in the host byte order */
+    bool WriteNpy(const std::string& filename, const double* data, int rows, int cols)
+    {
+        const uint16_t one = 1;
+        const bool little_endian = (*reinterpret_cast<const unsigned char*>(&one) == 1);
+
+        std::string header = std::string("{'descr': '") + (little_endian ? "<f8" : ">f8") + "', 'fortran_order': False, 'shape': ("
+                             + std::to_string(rows) + ", " + std::to_string(cols) + "), }";
+
+        // magic(6) + version(2) + length(2) + header, padded to a multiple of 64 and terminated by a newline
+        const size_t preamble = 10;
+        const size_t total = ((preamble + header.size() + 1 + 63)/64)*64;
+        header.append(total - preamble - header.size() - 1, ' ');
+        header.push_back('\n');
+
+        const uint16_t header_len = static_cast<uint16_t>(header.size());
+        const unsigned char len_bytes[2] = { static_cast<unsigned char>(header_len & 0xff), static_cast<unsigned char>(header_len >> 8) };
+
+        std::ofstream ofs = Open(filename);
+        ofs.write("\x93NUMPY\x01\x00", 8);
+        ofs.write(reinterpret_cast<const char*>(len_bytes), 2);
+        ofs.write(header.data(), header.size());
+        ofs.write(reinterpret_cast<const char*>(data), sizeof(double)*static_cast<size_t>(rows)*cols);
+        return Close(ofs);
+    }
+
+    static std::string CsvField(const std::string& str)
+    {
+        if(str.find_first_of(",\"\n") == std::string::npos){
+            return str;
+        }
+        std::string quoted = "\"";
+        for(char c : str){
+            if(c == '"') quoted.push_back('"');
+            quoted.push_back(c);
+        }
+        quoted.push_back('"');
+        return quoted;
+    }
+
+    fs::path dir_;
+    OutputFormat format_;
+    int num_outputs_;
+};
+
+
+/** Run one analysis entry of the job on the loaded system */
+void RunAnalysis(OpticalSystem& sys, const nlohmann::json& job, ResultWriter& writer)
+{
+    const std::string type = job.value("Type", "");
+
+    FieldSpec* fld_spec = sys.GetOpticalSpec()->GetFieldSpec();
+    WavelengthSpec* wvl_spec = sys.GetOpticalSpec()->GetWavelengthSpec();
+    const int num_flds = fld_spec->NumberOfFields();
+    const int num_wvls = wvl_spec->NumberOfWavelengths();
+
+    std::vector<int> all_flds(num_flds);
+    for(int fi = 0; fi < num_flds; fi++){
+        all_flds[fi] = fi;
+    }
+
+    const std::vector<int> flds = Indices(job, "Fields", num_flds, all_flds);
+    const std::vector<int> wvls = Indices(job, "Wavelengths", num_wvls, std::vector<int>({wvl_spec->ReferenceIndex()}));
+
+    auto fld_name = [](int fi){ return "_f" + std::to_string(fi); };
+    auto wvl_name = [](int wi){ return "_w" + std::to_string(wi); };
+
+    if(type == "FirstOrder"){
+        FirstOrderData* fod = sys.GetFirstOrderData();
+        writer.Write("first_order", std::vector<std::pair<std::string, double>>({
+                         {"EffectiveFocalLength", fod->effective_focal_length},
+                         {"FNumber",              fod->fno},
+                         {"EntrancePupilDistance",fod->entrance_pupil_distance},
+                         {"EntrancePupilRadius",  fod->entrance_pupil_radius},
+                         {"ExitPupilDistance",    fod->exit_pupil_distance},
+                         {"ExitPupilRadius",      fod->exit_pupil_radius},
+                         {"ImageDistance",        fod->image_distance},
+                         {"ObjectDistance",       fod->object_distance},
+                         {"FrontFocalLength",     fod->front_focal_length},
+                         {"BackFocalLength",      fod->back_focal_length},
+                         {"ImageHeight",          fod->image_height},
+                         {"ObjectAngle",          fod->object_angle},
+                         {"ObjectSpaceNA",        fod->object_space_na},
+                         {"ImageSpaceNA",         fod->image_space_na},
+                         {"OpticalInvariant",     fod->optical_invariant}
+                     }));
+    }
+    else if(type == "Spot"){
+        const int nrd = job.value("Nrd", 20);
+        const int pattern = (job.value("Pattern", "Grid") == "Hexapolar") ? SpotDiagram::Hexapolar : SpotDiagram::Grid;
+        SpotDiagram spot(&sys);
+        for(int fi : flds){
+            writer.Write("spot" + fld_name(fi), spot.plot(fld_spec->GetField(fi), pattern, nrd, 1.0));
+        }
+    }
+    else if(type == "RayFan"){
+        const int nrd = job.value("Nrd", 20);
+        const int pupil_dir = job.value("PupilDir", 1);
+        const int abr_dir = job.value("AbrDir", 1);
+        TransverseRayFan ray_fan(&sys);
+        for(int fi : flds){
+            writer.Write("ray_fan" + fld_name(fi), ray_fan.plot(nrd, fld_spec->GetField(fi), pupil_dir, abr_dir));
+        }
+    }
+    else if(type == "OpdFan"){
+        const int nrd = job.value("Nrd", 20);
+        OpdFan opd_fan(&sys);
+        for(int fi : flds){
+            writer.Write("opd_fan" + fld_name(fi), opd_fan.plot(fld_spec->GetField(fi), nrd));
+        }
+    }
+    else if(type == "GeometricalMTF"){
+        GeometricalMTF geo_mtf;
+        writer.Write("geometrical_mtf", geo_mtf.plot(&sys, job.value("Nrd", 20), job.value("MaxFreq", 100.0), job.value("FreqStep", 5.0)));
+    }
+    else if(type == "DiffractiveMTF"){
+        DiffractiveMTF mtf(&sys);
+        writer.Write("diffractive_mtf", mtf.plot(&sys, job.value("Samples", 64)));
+    }
+    else if(type == "AutocorrelationMTF"){
+        AutocorrelationMTF mtf(&sys);
+        writer.Write("autocorrelation_mtf", mtf.plot(job.value("Samples", 64), job.value("MaxFreq", 100.0), job.value("FreqStep", 5.0)));
+    }
+    else if(type == "Wavefront" || type == "Zernike"){
+        const int samples = job.value("Samples", 64);
+        const int num_terms = job.value("Terms", 37);
+        WavefrontMap wavefront(&sys);
+        for(int fi : flds){
+            for(int wi : wvls){
+                auto grid = wavefront.Create(fld_spec->GetField(fi), wvl_spec->GetWavelength(wi)->Value(), samples);
+                if(type == "Wavefront"){
+                    writer.Write("wavefront" + fld_name(fi) + wvl_name(wi), grid);
+                }else{
+                    const std::vector<double> coefs = WavefrontMap::FitZernike(grid.get(), num_terms);
+                    std::vector<std::pair<std::string, double>> values;
+                    for(size_t ti = 0; ti < coefs.size(); ti++){
+                        values.push_back({"Z" + std::to_string(ti + 1), coefs[ti]});
+                    }
+                    writer.Write("zernike" + fld_name(fi) + wvl_name(wi), values);
+                }
+            }
+        }
+    }
+    else if(type == "PSF"){
+        const int samples = job.value("Samples", 64);
+        DiffractivePSF psf(&sys);
+        for(int fi : flds){
+            for(int wi : wvls){
+                writer.Write("psf" + fld_name(fi) + wvl_name(wi), psf.Create(fld_spec->GetField(fi), wvl_spec->GetWavelength(wi)->Value(), samples));
+            }
+        }
+    }
+    else if(type == "ThroughFocus"){
+        ThroughFocus through_focus(&sys);
+        for(int fi : flds){
+            writer.Write("through_focus" + fld_name(fi),
+                         through_focus.Compute(fld_spec->GetField(fi), job.value("Nrd", 20), job.value("FocusMin", -0.1), job.value("FocusMax", 0.1),
+                                               job.value("Steps", 21), job.value("MtfFreq", 30.0)));
+        }
+    }
+    else{
+        throw std::runtime_error("Unknown analysis type: " + type);
+    }
+}
+
+LensResult ProcessLens(const std::string& lens_path, const std::string& name, const nlohmann::json& analyses, const fs::path& out_dir, OutputFormat format)
+{
+    LensResult result;
+    result.lens_path = lens_path;
+    result.name = name;
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    try{
+        OpticalSystem sys;
+        sys.LoadFile(lens_path);
+        if(sys.GetOpticalAssembly()->NumberOfSurfaces() < 3){
+            throw std::runtime_error("Failed to load lens");
+        }
+
+        const fs::path lens_dir = out_dir / name;
+        fs::create_directories(lens_dir);
+
+        ResultWriter writer(lens_dir, format);
+        for(auto& analysis : analyses){
+            RunAnalysis(sys, analysis, writer);
+        }
+
+        result.num_outputs = writer.NumberOfOutputs();
+        result.success = true;
+    }catch(std::exception& e){
+        result.message = e.what();
+    }
+
+    auto t1 = std::chrono::steady_clock::now();
+    result.ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+
+    return result;
+}
+
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+    CliConfig cfg;
+    if(!ParseArgs(argc, argv, cfg)){
+        return 1;
+    }
+
+    nlohmann::json job;
+    {
+        std::ifstream ifs(cfg.job_path);
+        if(!ifs){
+            std::cerr << "Failed to open job file: " << cfg.job_path << std::endl;
+            return 1;
+        }
+        try{
+            ifs >> job;
+        }catch(std::exception& e){
+            std::cerr << "Failed to parse job file: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    // command line takes precedence over the job file
+    OutputFormat format = OutputFormat::Csv;
+    const std::string format_str = cfg.format.empty() ? job.value("Format", "csv") : cfg.format;
+    if(!ParseFormat(format_str, format)){
+        std::cerr << "Unknown format: " << format_str << std::endl;
+        return 1;
+    }
+
+    const fs::path out_dir = cfg.out_dir.empty() ? job.value("Output", std::string(".")) : cfg.out_dir;
+
+    std::vector<std::string> agf_args = cfg.agf_args;
+    if(agf_args.empty()){
+        agf_args = ToStringList(job.value("AGF", nlohmann::json()));
+    }
+    if(agf_args.empty()){
+        agf_args.push_back((fs::absolute(argv[0]).parent_path() / "AGF").u8string());
+    }
+
+    std::vector<std::string> lens_args = cfg.lens_args;
+    for(auto& l : ToStringList(job.value("Lenses", nlohmann::json()))){
+        lens_args.push_back(l);
+    }
+
+    const std::vector<std::string> agfs = CollectFiles(agf_args, ".agf");
+    const std::vector<std::string> lenses = CollectFiles(lens_args, ".json");
+    const std::vector<std::string> names = UniqueNames(lenses);
+    const nlohmann::json analyses = job.value("Analyses", nlohmann::json::array());
+
+    if(lenses.empty()){
+        std::cerr << "No lens to process" << std::endl;
+        return 1;
+    }
+
+    if(cfg.threads > 0){
+        ThreadPool::SetGlobalThreadCount(cfg.threads);
+    }
+
+    // the catalogs are shared by all systems, and kept alive by this library during the run
+    MaterialLibrary material_lib;
+    if(!material_lib.LoadAgfFiles(agfs)){
+        std::cerr << "No glass catalog loaded" << std::endl;
+    }
+
+    std::error_code ec;
+    fs::create_directories(out_dir, ec);
+
+    std::vector<LensResult> results(lenses.size());
+    std::mutex print_mtx;
+
+    ThreadPool::Global()->ParallelFor(lenses.size(), [&](int li){
+        results[li] = ProcessLens(lenses[li], names[li], analyses, out_dir, format);
+
+        std::lock_guard<std::mutex> lk(print_mtx);
+        const LensResult& r = results[li];
+        std::cout << (r.success ? "done   " : "failed ") << r.lens_path
+                  << " (" << std::fixed << std::setprecision(1) << r.ms << " ms)";
+        if(!r.success){
+            std::cout << ": " << r.message;
+        }
+        std::cout << std::endl;
+    });
+
+    // summary
+    int num_failed = 0;
+    nlohmann::json summary = nlohmann::json::array();
+    for(auto& r : results){
+        nlohmann::json item;
+        item["Lens"]    = r.lens_path;
+        item["Name"]    = r.name;
+        item["Success"] = r.success;
+        item["Message"] = r.message;
+        item["Milliseconds"] = r.ms;
+        item["Outputs"] = r.num_outputs;
+        summary.push_back(item);
+        if(!r.success){
+            num_failed++;
+        }
+    }
+
+    std::ofstream ofs(out_dir / "summary.json");
+    ofs << std::setw(4) << summary << std::endl;
+
+    std::cout << lenses.size() - num_failed << " succeeded, " << num_failed << " failed" << std::endl;
+
+    return num_failed == 0 ? 0 : 2;
+}
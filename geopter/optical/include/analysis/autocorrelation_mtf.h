@@ -0,0 +1,68 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#ifndef GEOPTER_AUTOCORRELATION_MTF_H
+#define GEOPTER_AUTOCORRELATION_MTF_H
+
+#include <vector>
+#include <complex>
+
+#include "data/plot_data.h"
+#include "system/optical_system.h"
+
+namespace geopter{
+
+/**
+ * @brief Diffraction MTF by autocorrelation of the pupil function
+ *
+ * The OTF at a frequency is the overlap integral of the pupil function with a copy of itself sheared by lambda*R*frequency.
+ * The pupil is sampled once per field and wavelength and shared by all the requested frequencies.
+ * Shears falling between samples are linearly interpolated from the two neighbouring whole-sample shears.
+ */
+class AutocorrelationMTF
+{
+public:
+    AutocorrelationMTF(OpticalSystem* opt_sys);
+
+    /**
+     * @brief Compute polychromatic tangential and sagittal MTF of the field
+     * @param freqs spatial frequencies on the image (cycles per system unit)
+     * @param pupil_samples number of pupil samples across the diameter
+     */
+    void Compute(const Field* fld, const std::vector<double>& freqs, int pupil_samples, std::vector<double>& mtf_tan, std::vector<double>& mtf_sag);
+
+    /** Returns a plot without graphs if freq_step is not positive or pupil_samples is less than 2 */
+    std::shared_ptr<PlotData> plot(int pupil_samples, double max_freq= 100.0, double freq_step= 5.0);
+
+private:
+    /** Complex OTF of the field for single wavelength, zero if the pupil function cannot be created */
+    void ComputeOtf(const Field* fld, double wvl, const std::vector<double>& freqs, int pupil_samples, std::vector< std::complex<double> >& otf_tan, std::vector< std::complex<double> >& otf_sag);
+
+    OpticalSystem* opt_sys_;
+};
+
+} //namespace geopter
+
+#endif //GEOPTER_AUTOCORRELATION_MTF_H
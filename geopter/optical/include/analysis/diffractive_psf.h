@@ -15,6 +15,20 @@ public:
 
     void CreateFromOpdTrace(OpticalSystem* opt_sys, const Field* fld, double wvl, int M, double L=1.0);
 
+    /**
+     * @brief Compute a PSF window by matrix Fourier transform of the pupil function
+     *
+     * Only the requested image window is evaluated, so the pixel pitch is independent of the pupil sampling and no zero padding is needed.
+     * The window is centered on the chief ray and the values are normalized by the peak of the unaberrated PSF (i.e. the center value is the Strehl ratio).
+     * The window should be smaller than lambda*R/(pupil sample spacing) to avoid replicas.
+     *
+     * @param pupil_samples number of pupil samples across the diameter
+     * @param image_samples number of pixels across the window
+     * @param pixel_pitch pixel pitch on the image plane (system unit)
+     * @return nullptr if the sample counts are invalid or the chief ray cannot be traced
+     */
+    std::shared_ptr<DataGrid> CreateByMft(const Field* fld, double wvl, int pupil_samples, int image_samples, double pixel_pitch);
+
     void CreateFromSpotData();
 
     Eigen::MatrixXd &ConvertToMatrix();
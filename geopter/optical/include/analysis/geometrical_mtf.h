@@ -9,10 +9,36 @@ namespace geopter{
 class GeometricalMTF
 {
 public:
+    enum class Method
+    {
+        /** bin the spot into a line spread histogram per azimuth and transform the histogram */
+        Histogram,
+        /** sum cos/sin over every ray at every frequency, for validation */
+        DirectSum
+    };
+
     GeometricalMTF();
 
     std::shared_ptr<PlotData> plot(OpticalSystem* opt_sys, int nrd, double max_freq= 100.0, double freq_step= 5.0);
 
+    void SetMethod(Method method) { method_ = method; }
+    Method GetMethod() const { return method_; }
+
+    /** Number of histogram bins per period of the highest frequency. Larger values are more accurate. */
+    void SetBinsPerCycle(int bins_per_cycle) { bins_per_cycle_ = bins_per_cycle; }
+    int BinsPerCycle() const { return bins_per_cycle_; }
+
+    /**
+     * @brief MTF along one azimuth from the line spread histogram of the ray coordinates projected on the azimuth
+     *
+     * Each ray is shared linearly between the two nearest bins, and the resulting sinc^2 attenuation is divided out.
+     * The phase factors are advanced by a complex recurrence over the bins, so no transcendental call is made per ray.
+     */
+    static std::vector<double> LineSpreadMtf(const std::vector<double>& freqs, const std::vector<double>& coords, int bins_per_cycle);
+
+private:
+    Method method_;
+    int bins_per_cycle_;
 
 };
 
@@ -37,6 +37,12 @@ public:
     SpotDiagram(OpticalSystem* opt_sys);
     ~SpotDiagram();
 
+    /**
+     * @brief Spot diagram of the field, relative to the chief ray of the reference wavelength
+     *
+     * Only the rays that pass through are plotted, for both patterns. The center of the hexapolar pattern is
+     * dropped as well when it is blocked, where it used to be plotted at the image point of a previously traced ray.
+     */
     std::shared_ptr<PlotData> plot(const Field* fld, int pattern, int nrd, double dot_size);
 
     enum SpotRayPattern{
@@ -46,7 +52,7 @@ public:
 
 private:
     std::vector<double> wvl_weights_;
-    std::vector<SequentialPath> seq_paths_;
+    std::vector< std::shared_ptr<const SequentialPath> > seq_paths_;
 };
 
 }
@@ -0,0 +1,90 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#ifndef GEOPTER_THROUGH_FOCUS_H
+#define GEOPTER_THROUGH_FOCUS_H
+
+#include <vector>
+
+#include "data/data_grid.h"
+#include "system/optical_system.h"
+
+namespace geopter{
+
+/**
+ * @brief Spot and geometric MTF through focus
+ *
+ * The rays are traced once to the image surface. Since the rays travel straight beyond the last surface,
+ * each defocus plane is evaluated by propagating the final segments analytically.
+ */
+class ThroughFocus
+{
+public:
+    /** Columns of the data grid returned by Compute() */
+    enum Metric
+    {
+        Defocus,
+        RmsSpotRadius,
+        GeoSpotRadius,
+        CentroidX,
+        CentroidY,
+        MtfTangential,
+        MtfSagittal,
+        NumberOfMetrics
+    };
+
+    ThroughFocus(OpticalSystem* opt_sys);
+
+    /**
+     * @brief Evaluate the metrics at defocus planes
+     * @param nrd number of pupil samples across the diameter
+     * @param focus_min defocus of the first plane measured from the image surface
+     * @param focus_max defocus of the last plane
+     * @param num_steps number of defocus planes
+     * @param mtf_freq spatial frequency for the geometric MTF
+     * @return grid of num_steps rows and NumberOfMetrics columns. The spot centroid is measured from the chief ray.
+     */
+    std::shared_ptr<DataGrid> Compute(const Field* fld, int nrd, double focus_min, double focus_max, int num_steps, double mtf_freq);
+
+    /** Number of histogram bins per cycle used for the geometric MTF */
+    void SetBinsPerCycle(int bins_per_cycle) { bins_per_cycle_ = bins_per_cycle; }
+
+private:
+    /** Position and slope of the final segments of the rays of all wavelengths, in the image surface coordinate */
+    struct FinalSegments
+    {
+        std::vector<double> x, y, z;
+        std::vector<double> tx, ty;
+    };
+
+    bool TraceFinalSegments(const Field* fld, int nrd, FinalSegments& segs, Eigen::Vector3d& chief_pt, Eigen::Vector2d& chief_slope);
+
+    OpticalSystem* opt_sys_;
+    int bins_per_cycle_;
+};
+
+} //namespace geopter
+
+#endif //GEOPTER_THROUGH_FOCUS_H
@@ -5,16 +5,81 @@
 #include "analysis/reference_sphere.h"
 #include "data/plot_data.h"
 #include "sequential/ray.h"
+#include "sequential/ray_bundle.h"
 
 namespace geopter {
 
+/** Everything of the OPD calculation that depends only on the chief ray, built once per field and wavelength */
+struct WavefrontContext
+{
+    /** index of the last surface before the image */
+    int k;
+    bool decentered;
+
+    Eigen::Vector3d cr_exp_pt;
+    double cr_exp_dist;
+
+    Eigen::Vector3d ref_dir;
+    double ref_sphere_radius;
+    double sign_soln;
+
+    /** chief ray at the first surface, in the object space and at the surface k */
+    Eigen::Vector3d cr_pt1;
+    Eigen::Vector3d cr_dir0;
+    Eigen::Vector3d cr_ptk;
+    Eigen::Vector3d cr_dirk;
+    double cr_op;
+
+    double n_img;
+    double n_obj;
+
+    /** statistics of the thread building the context, used by the OPD calculation on any thread */
+    std::shared_ptr<TraceStatistics> stats;
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
 class WaveAberration
 {
 public:
     WaveAberration(OpticalSystem* opt_sys );
     virtual ~WaveAberration();
 
+    /**
+     * @brief Build the context of the chief ray, with the reference sphere centered at the chief ray on the image
+     * @param wvl wavelength of the chief ray, at which the object and image space indices are evaluated
+     */
+    WavefrontContext CreateWavefrontContext(const std::shared_ptr<Ray>& chief_ray, double wvl);
+
+    /** Wavefront error of the ray in mm, relative to the chief ray of the context */
+    double Opd(const WavefrontContext& ctx, const std::shared_ptr<Ray>& ray) const;
+
+    /**
+     * @brief Wavefront error of the ray in mm with the image surface moved along the axis, without re-tracing
+     *
+     * The reference sphere is centered at the chief ray on the moved image surface.
+     * @param defocus axial shift of the image surface
+     */
+    double Opd(const WavefrontContext& ctx, const std::shared_ptr<Ray>& ray, double defocus) const;
+
 protected:
+    /**
+     * @brief Build the context for the chief ray
+     * @param wvl wavelength at which the object and image space indices are evaluated
+     */
+    WavefrontContext create_wavefront_context(const std::shared_ptr<Ray>& chief_ray, ReferenceSphere& ref_sphere, double wvl);
+
+    /** Build the context with the reference sphere centered at the chief ray on the image */
+    WavefrontContext create_wavefront_context(const std::shared_ptr<Ray>& chief_ray, double wvl);
+
+    double wave_abr_full_calc(const WavefrontContext& ctx, const std::shared_ptr<Ray>& ray) const;
+
+    /**
+     * @brief OPD of all rays of the bundle
+     * @param bundle bundle holding all surfaces (not image-only)
+     * @param opd output for each ray. NaN is written for rays not traced successfully.
+     */
+    void wave_abr_full_calc(const WavefrontContext& ctx, const RayBundle& bundle, double* opd) const;
 
     double wave_abr_full_calc(const std::shared_ptr<Ray>& ray, const std::shared_ptr<Ray>& chief_ray);
 
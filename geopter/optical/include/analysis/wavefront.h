@@ -28,9 +28,26 @@
 
 #include "analysis/wave_aberration.h"
 #include "data/data_grid.h"
+#include "analysis/zernike.h"
 
 namespace geopter{
 
+/** Pupil function sampled over the exit pupil, with the geometry to propagate it to the image */
+struct PupilFunction
+{
+    /** exp(-i*2pi*W) inside the pupil, zero outside */
+    Eigen::MatrixXcd values;
+    int num_valid;
+    /** exit pupil radius */
+    double radius;
+    /** sample spacing on the exit pupil */
+    double sample_step;
+    /** distance from the exit pupil to the chief ray on the image */
+    double distance;
+    /** wavelength in system unit */
+    double wavelength;
+};
+
 /** Wavefront
  *
  *  Wavefront is a grid array of optical path differences of the rays that is referenced to the chief ray on the exit pupil
@@ -43,6 +60,16 @@ public:
     /** create by tracing multiple rays */
     std::shared_ptr<DataGrid> Create(const Field* fld, double wvl, int ndim);
 
+    /**
+     * @brief Sample the pupil function on a square grid over the exit pupil
+     * @param pupil_samples number of samples across the diameter, at least 2
+     * @return false if the sample count is invalid or the chief ray cannot be traced
+     */
+    bool CreatePupilFunction(const Field* fld, double wvl, int pupil_samples, PupilFunction& pf);
+
+    /** Zernike coefficients (in waves) of a grid created by Create(). NaN cells are excluded. */
+    static std::vector<double> FitZernike(DataGrid* wf_grid, int num_terms = 37, ZernikeOrdering ordering = ZernikeOrdering::Fringe);
+
 protected:
     int ndim_;
     double wvl_;
@@ -0,0 +1,94 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#ifndef GEOPTER_ZERNIKE_H
+#define GEOPTER_ZERNIKE_H
+
+#include <vector>
+#include <memory>
+#include <mutex>
+
+#include "Eigen/Core"
+
+namespace geopter {
+
+enum class ZernikeOrdering
+{
+    /** Fringe (University of Arizona) ordering, unnormalized */
+    Fringe,
+    /** Noll ordering, normalized to unit RMS over the unit circle */
+    Noll
+};
+
+/**
+ * @brief Least squares Zernike fit of wavefront grids
+ *
+ * The grid spans [-1, 1] in both directions, with the column index along x and the row index along y, as written by WavefrontMap.
+ * NaN cells are excluded from the fit. The pseudo-inverse of the basis is cached per grid size, mask, number of terms and ordering,
+ * so a repeated fit on the same mask costs one matrix-vector product.
+ */
+class ZernikeFit
+{
+public:
+    /**
+     * @brief Fit the grid
+     * @param num_terms number of terms, starting from the piston
+     * @return coefficients in the unit of the grid values. Empty if the grid has fewer valid cells than the terms.
+     */
+    static std::vector<double> Fit(const Eigen::MatrixXd& grid, int num_terms, ZernikeOrdering ordering = ZernikeOrdering::Fringe);
+
+    /**
+     * Radial order n and azimuthal frequency m of the j-th term (1-based). Negative m stands for the sine term.
+     * @return false if j is less than 1
+     */
+    static bool Indices(int j, ZernikeOrdering ordering, int& n, int& m);
+
+    /** Value of the j-th term (1-based) at polar coordinate (rho, theta). NaN if j is less than 1. */
+    static double Evaluate(int j, ZernikeOrdering ordering, double rho, double theta);
+
+    static void ClearCache();
+
+private:
+    struct Basis
+    {
+        int rows;
+        int cols;
+        int num_terms;
+        ZernikeOrdering ordering;
+        std::vector<char> mask;
+
+        /** num_terms x (number of valid cells) */
+        Eigen::MatrixXd pseudo_inverse;
+    };
+
+    static std::shared_ptr<const Basis> GetBasis(int rows, int cols, int num_terms, ZernikeOrdering ordering, const std::vector<char>& mask);
+
+    static std::vector< std::shared_ptr<const Basis> > cache_;
+    static std::mutex cache_mtx_;
+};
+
+} //namespace geopter
+
+#endif //GEOPTER_ZERNIKE_H
@@ -31,6 +31,7 @@
 #include <math.h>
 
 #include <string>
+#include "common/revision_counter.h"
 
 namespace geopter {
 
@@ -40,11 +41,13 @@ class Circular
 public:
     Circular() : x_dimension_(1.0), y_dimension_(1.0), x_offset_(0.0), y_offset_(0.0), rotation_(0.0){
         radius_ = 1.0;
+        revision_ = RevisionCounter::Next();
     }
 
 
     Circular(double r) : x_dimension_(r), y_dimension_(r), x_offset_(0.0), y_offset_(0.0), rotation_(0.0){
         radius_ = r;
+        revision_ = RevisionCounter::Next();
     }
 
 
@@ -52,10 +55,12 @@ public:
         radius_ = fabs( std::max(x,y) );
         x_dimension_ = radius_;
         y_dimension_ = radius_;
+        revision_ = RevisionCounter::Next();
     }
 
     void SetRadius(double r){
         radius_ = r;
+        revision_ = RevisionCounter::Next();
     }
 
     double Radius() const{
@@ -74,6 +79,12 @@ public:
         x_dimension_ = x;
         y_dimension_ = y;
         radius_ = sqrt(x*x + y*y);
+        revision_ = RevisionCounter::Next();
+    }
+
+    /** Stamp of the last modification */
+    uint64_t Revision() const{
+        return revision_;
     }
 
     bool PointInside(double x, double y) const{
@@ -95,6 +106,7 @@ protected:
 
 private:
     double radius_;
+    uint64_t revision_;
 };
 
 } //namespace
@@ -55,12 +55,18 @@ public:
     Gap(double t, std::shared_ptr<Material> m =nullptr);
     ~Gap();
 
+    /** Returns a copy of the gap. The material is shared with the original, and the solve is copied. */
+    std::unique_ptr<Gap> Clone() const;
+
     double Thickness() const { return thi_; }
-    void SetThickness(double t) { thi_ = t; }
+    void SetThickness(double t);
 
     Material* GetMaterial() const { return material_.get();}
     void SetMaterial(std::shared_ptr<Material> m);
 
+    /** Stamp of the last modification of the gap or its material */
+    uint64_t Revision() const;
+
     template <class T>
     Solve* CreateSolve() {
         solve_ = std::make_unique<T>();
@@ -80,6 +86,7 @@ private:
     std::shared_ptr<Material> material_;
     std::unique_ptr<Solve> solve_;
     int gap_index_;
+    uint64_t revision_;
 };
 
 
@@ -2,6 +2,7 @@
 #define GEOPTER_NONE_APERTURE_H
 
 #include <string>
+#include <cstdint>
 
 namespace geopter {
 
@@ -18,6 +19,10 @@ public:
         return 0.0;
     }
 
+    uint64_t Revision() const{
+        return 0;
+    }
+
     bool PointInside(double /*x*/, double /*y*/) const{
         return true;
     }
@@ -49,6 +49,9 @@ public:
 
     void Clear();
 
+    /** Replace the sequence by a deep copy of the given assembly. Materials are shared. */
+    void CopyFrom(const OpticalAssembly& other);
+
     template<typename ... A>
     void SetupFromText(A... args);
 
@@ -84,7 +87,7 @@ public:
     Gap* ImageSpaceGap() const;
 
     /** Set the given surface as stop */
-    void SetStop(int i) { stop_index_ = i;}
+    void SetStop(int i) { stop_index_ = i; revision_ = RevisionCounter::Next(); }
 
     void CreateMinimumAssembly();
 
@@ -108,6 +111,9 @@ public:
 
     void UpdateSemiDiameters();
 
+    /** Stamp of the last modification of the sequence, including the surfaces, gaps and materials */
+    uint64_t Revision() const;
+
     /** Returns overall length from start to end */
     double OverallLength(int start, int end);
 
@@ -126,7 +132,8 @@ private:
     int current_surface_index_;
 
     int num_surfs_;
-    int num_gaps_;
+
+    uint64_t revision_;
 
 };
 
@@ -29,12 +29,14 @@
 #include <string>
 #include <memory>
 #include <variant>
+#include <algorithm>
 
 #include "assembly/transformation.h"
 #include "assembly/aperture.h"
 #include "assembly/circular.h"
 #include "assembly/decenter_data.h"
 #include "solve/solve.h"
+#include "common/revision_counter.h"
 
 #include "profile/surface_profile.h"
 #include "profile/spherical.h"
@@ -50,6 +52,9 @@ public:
     Surface();
     ~Surface();
 
+    /** Returns a deep copy of the surface, including the decenter and the solve */
+    std::unique_ptr<Surface> Clone() const;
+
     std::string InteractMode() const { return interact_mode_;}
     std::string Label() const { return label_;}
     DecenterData* Decenter() const { return decenter_.get(); }
@@ -57,7 +62,7 @@ public:
     Solve* GetSolve() const { return solve_.get(); }
 
     std::string ProfileName() const{
-        return std::visit([&](auto p){ return p.Name();}, profile_);
+        return std::visit([&](const auto &p){ return p.Name();}, profile_);
     }
 
     double Curvature() const{ return std::visit([](auto &p){ return p.Curvature();}, profile_);}
@@ -70,16 +75,28 @@ public:
         std::visit([&](auto &p){ p.SetRadius(r);}, profile_);
     }
 
+    void SetCurvature(double cv){
+        std::visit([&](auto &p){ p.SetCurvature(cv);}, profile_);
+    }
+
+    /** Stamp of the last modification of the surface, its profile or its aperture */
+    uint64_t Revision() const{
+        uint64_t rev = revision_;
+        rev = std::max(rev, std::visit([](const auto &p){ return p.Revision();}, profile_));
+        rev = std::max(rev, std::visit([](const auto &ap){ return ap.Revision();}, clear_aperture_));
+        return rev;
+    }
+
     bool Intersect(Eigen::Vector3d& pt, double& distance, const Eigen::Vector3d& p0, const Eigen::Vector3d& dir){
-        return std::visit([&](auto p){ return p.Intersect(pt, distance, p0, dir);}, profile_);
+        return std::visit([&](auto &p){ return p.Intersect(pt, distance, p0, dir);}, profile_);
     }
 
     Eigen::Vector3d Normal(const Eigen::Vector3d& pt) const{
-        return std::visit([&](auto p){ return p.Normal(pt);}, profile_);
+        return std::visit([&](const auto &p){ return p.Normal(pt);}, profile_);
     }
 
     double Sag(double x, double y){
-        return std::visit([&](auto p){ return p.Sag(x,y);}, profile_);
+        return std::visit([&](auto &p){ return p.Sag(x,y);}, profile_);
     }
 
     template<class P>
@@ -124,10 +141,10 @@ public:
 
     /** Returns true if the given point(x,y) is inside of aperture */
     bool PointInside(double x, double y) const {
-        return std::visit([&](auto ap){ return ap.PointInside(x,y); }, clear_aperture_);
+        return std::visit([&](const auto &ap){ return ap.PointInside(x,y); }, clear_aperture_);
     }
     bool PointInside(const Eigen::Vector2d& pt) const{
-        return std::visit([&](auto ap){ return ap.PointInside(pt(0), pt(1)); }, clear_aperture_);
+        return std::visit([&](const auto &ap){ return ap.PointInside(pt(0), pt(1)); }, clear_aperture_);
     }
 
     const Transformation& LocalTransform() const { return lcl_tfrm_;}
@@ -140,6 +157,7 @@ public:
         }else {
             profile_ = SurfaceProfile<Profile>(cv, k, coefs);
         }
+        revision_ = RevisionCounter::Next();
     }
 
 
@@ -152,6 +170,7 @@ public:
         }else if(std::is_same_v<Shape, Circular>){
             clear_aperture_ = Aperture<Circular>(x_dimension, y_dimension);
         }
+        revision_ = RevisionCounter::Next();
     }
 
 
@@ -160,7 +179,7 @@ public:
 
     void SetSemiDiameter(double sd){ semi_diameter_ = sd;}
 
-    void SetLocalTransform(const Transformation& tfrm){ lcl_tfrm_ = tfrm; }
+    void SetLocalTransform(const Transformation& tfrm);
     void SetGlobalTransform(const Transformation& tfrm) { gbl_tfrm_ = tfrm;}
 
     void SetSolve(std::unique_ptr<Solve> solve) { solve_ = std::move(solve); }
@@ -188,6 +207,8 @@ protected:
 
     std::unique_ptr<Solve> solve_;
 
+    uint64_t revision_;
+
     /** transform to next interface */
     Transformation lcl_tfrm_;
 
@@ -0,0 +1,53 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#ifndef GEOPTER_DUAL_NUMBER_H
+#define GEOPTER_DUAL_NUMBER_H
+
+#include "Eigen/Core"
+#include "unsupported/Eigen/AutoDiff"
+
+namespace geopter {
+
+/** Maximum number of partial derivatives carried by a DualNumber */
+constexpr int max_dual_parameters = 16;
+
+using DualVector = Eigen::Matrix<double, Eigen::Dynamic, 1, 0, max_dual_parameters, 1>;
+
+/**
+ * @brief Forward mode automatic differentiation scalar
+ *
+ * The derivative vector has a fixed capacity so that arithmetic does not allocate.
+ * Templated geometry code accepts either double or DualNumber.
+ */
+using DualNumber = Eigen::AutoDiffScalar<DualVector>;
+
+/** Value part, used for branches and convergence tests in templated code */
+inline double ScalarValue(double x) { return x; }
+inline double ScalarValue(const DualNumber& x) { return x.value(); }
+
+} //namespace geopter
+
+#endif // GEOPTER_DUAL_NUMBER_H
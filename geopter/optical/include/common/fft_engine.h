@@ -0,0 +1,66 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#ifndef GEOPTER_FFT_ENGINE_H
+#define GEOPTER_FFT_ENGINE_H
+
+#include "Eigen/Core"
+
+namespace geopter {
+
+/**
+ * @brief Two dimensional FFT on Eigen matrices
+ *
+ * Each thread keeps its own transform object, so the twiddle plans of a size are built once per thread and reused by later calls.
+ * The row and column passes are spread over the shared thread pool.
+ * Forward transforms are unscaled and inverse transforms are scaled by 1/(rows*cols).
+ */
+class FftEngine
+{
+public:
+    /** Forward transform in place */
+    static void Forward(Eigen::MatrixXcd& data);
+
+    /** Inverse transform in place */
+    static void Inverse(Eigen::MatrixXcd& data);
+
+    /**
+     * @brief Forward transform of real data
+     * @param in real input, rows x cols
+     * @param out half spectrum along the first dimension, (rows/2+1) x cols. The other half is the conjugate of it.
+     */
+    static void ForwardReal(Eigen::MatrixXcd& out, const Eigen::MatrixXd& in);
+
+    /**
+     * @brief Inverse transform to real data
+     * @param in half spectrum as given by ForwardReal
+     * @param rows number of rows of the real output
+     */
+    static void InverseReal(Eigen::MatrixXd& out, const Eigen::MatrixXcd& in, int rows);
+};
+
+} //namespace geopter
+
+#endif //GEOPTER_FFT_ENGINE_H
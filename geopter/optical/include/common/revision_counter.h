@@ -0,0 +1,55 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#ifndef GEOPTER_REVISION_COUNTER_H
+#define GEOPTER_REVISION_COUNTER_H
+
+#include <cstdint>
+#include <atomic>
+
+namespace geopter {
+
+/**
+ * @brief Source of edit stamps
+ *
+ * Model objects take a new stamp whenever they are modified. As the stamps increase monotonically,
+ * a cache built at stamp N stays valid as long as no object involved has a stamp greater than N.
+ */
+class RevisionCounter
+{
+public:
+    /** Returns a new stamp greater than all stamps issued before */
+    static uint64_t Next();
+
+    /** Returns the latest stamp issued */
+    static uint64_t Current();
+
+private:
+    static std::atomic<uint64_t> count_;
+};
+
+} //namespace geopter
+
+#endif // GEOPTER_REVISION_COUNTER_H
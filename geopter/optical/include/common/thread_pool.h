@@ -0,0 +1,113 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#ifndef GEOPTER_THREAD_POOL_H
+#define GEOPTER_THREAD_POOL_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace geopter {
+
+/**
+ * @brief Work-stealing thread pool
+ *
+ * Each worker owns a task queue and steals from the others when its own queue runs dry.
+ * The calling thread takes part in the work of its own batch while waiting, so ParallelFor may be nested.
+ * Tasks of other batches are never picked up while waiting, which keeps the stack depth within the nesting of the calls.
+ * Tasks are identified by index, and callers write results into slots by index to keep the output order deterministic.
+ */
+class ThreadPool
+{
+public:
+    /** @param num_threads total number of threads including the caller. 0 uses the hardware concurrency. */
+    explicit ThreadPool(int num_threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /** Number of threads including the caller */
+    int NumberOfThreads() const { return static_cast<int>(workers_.size()) + 1; }
+
+    /** Run fn(i) for each i in [0, n) and wait until all of them are finished */
+    void ParallelFor(int n, const std::function<void(int)>& fn);
+
+    /** Shared pool used by the analyses */
+    static ThreadPool* Global();
+
+    /**
+     * @brief Set the number of threads of the shared pool
+     * @param num_threads total number of threads. 0 uses the hardware concurrency, 1 runs everything on the caller.
+     * @note must not be called while the shared pool is running tasks
+     */
+    static void SetGlobalThreadCount(int num_threads);
+
+    static int GlobalThreadCount();
+
+private:
+    struct Batch;
+
+    struct Task
+    {
+        const std::function<void(int)>* fn;
+        int index;
+        Batch* batch;
+    };
+
+    struct WorkQueue
+    {
+        std::mutex mtx;
+        std::deque<Task> tasks;
+    };
+
+    void WorkerLoop(int id);
+    bool PopOwn(int id, Task& task);
+    /** @param batch if not null, only the tasks of this batch are taken */
+    bool Steal(int first, Task& task, const Batch* batch = nullptr);
+    void Run(const Task& task);
+
+    std::vector<std::thread> workers_;
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+
+    std::atomic<int> pending_;
+    std::atomic<unsigned int> next_queue_;
+    std::mutex wake_mtx_;
+    std::condition_variable wake_cv_;
+    bool stop_;
+
+    static std::unique_ptr<ThreadPool> global_;
+    static std::mutex global_mtx_;
+};
+
+} //namespace geopter
+
+#endif // GEOPTER_THREAD_POOL_H
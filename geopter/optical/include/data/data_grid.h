@@ -3,11 +3,14 @@
 
 #include <string>
 #include <vector>
+#include <memory>
 
 #include "Eigen/Core"
 
 namespace geopter {
 
+class TraceStatistics;
+
 class DataGrid
 {
 public:
@@ -44,6 +47,10 @@ public:
 
     void SetValueMatrix(Eigen::MatrixXd& mat){ value_data_ = mat;}
 
+    /** Trace statistics collected while creating the data, nullptr if statistics are disabled */
+    void SetTraceStatistics(std::shared_ptr<const TraceStatistics> stats) { trace_stats_ = stats; }
+    std::shared_ptr<const TraceStatistics> GetTraceStatistics() const { return trace_stats_; }
+
 private:
     std::string description_;
     std::string x_label_;
@@ -54,6 +61,7 @@ private:
     int ny_;
     double dx_;
     double dy_;
+    std::shared_ptr<const TraceStatistics> trace_stats_;
 };
 
 
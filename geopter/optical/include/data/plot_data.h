@@ -34,6 +34,8 @@
 
 namespace geopter {
 
+class TraceStatistics;
+
 class PlotData
 {
 public:
@@ -57,6 +59,10 @@ public:
     std::string YLabel() const { return y_axis_label_;}
     int PlotStyle() const { return plot_style_; }
 
+    /** Trace statistics collected while creating the data, nullptr if statistics are disabled */
+    void SetTraceStatistics(std::shared_ptr<const TraceStatistics> stats) { trace_stats_ = stats; }
+    std::shared_ptr<const TraceStatistics> GetTraceStatistics() const { return trace_stats_; }
+
     void Print(std::ostringstream& oss);
     void Print();
 
@@ -69,6 +75,7 @@ private:
     int plot_style_;
     bool xy_reverse_;
     bool common_x_label_;
+    std::shared_ptr<const TraceStatistics> trace_stats_;
 };
 
 
@@ -27,6 +27,9 @@
 #ifndef ENVIRONMENT_H
 #define ENVIRONMENT_H
 
+#include <atomic>
+#include <cstdint>
+
 namespace geopter{
 
 
@@ -51,9 +54,13 @@ public:
 
     static double AirPressure();
 
+    /** Stamp of the last change of the temperature or the pressure */
+    static uint64_t Revision();
+
 private:
     static double temperature_;
     static double pressure_;
+    static std::atomic<uint64_t> revision_;
 };
 
 }
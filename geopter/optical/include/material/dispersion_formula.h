@@ -39,6 +39,48 @@ namespace geopter {
 class DispersionFormula
 {
 public:
+    /** Formula identifiers. The values up to Unknown follow the formula numbers in AGF files. */
+    enum class Type
+    {
+        None = 0,
+        Schott,
+        Sellmeier1,
+        Herzberger,
+        Sellmeier2,
+        Conrady,
+        Sellmeier3,
+        HandbookOfOptics1,
+        HandbookOfOptics2,
+        Sellmeier4,
+        Extended1,
+        Sellmeier5,
+        Extended2,
+        Unknown,
+        Nikon_Hikari
+    };
+
+    /**
+     * @brief Evaluate one glass at multiple wavelengths
+     *
+     * Powers of the wavelength are computed once per sample and the formula is selected outside of the loop.
+     * Results agree with the scalar formulas to rounding.
+     * @param type formula
+     * @param c dispersion coefficients
+     * @param lambdamicron wavelengths in micron
+     * @param n output indices, one per wavelength
+     * @param count number of wavelengths
+     */
+    static void Evaluate(Type type, const std::vector<double>& c, const double* lambdamicron, double* n, int count);
+
+    /**
+     * @brief Evaluate multiple glasses sharing a formula at one wavelength
+     * @param coefs coefficients of the glasses, stored glass by glass
+     * @param stride distance between the coefficients of consecutive glasses
+     * @param n output indices, one per glass
+     * @param count number of glasses
+     */
+    static void Evaluate(Type type, const double* coefs, int stride, double lambdamicron, double* n, int count);
+
     static double Schott(double lambdamicron, const std::vector<double>& c){
         return sqrt( c[0] + c[1]*pow(lambdamicron,2) + c[2]*pow(lambdamicron,-2) + c[3]*pow(lambdamicron,-4) + c[4]*pow(lambdamicron,-6) + c[5]*pow(lambdamicron,-8) );
     }
@@ -29,8 +29,10 @@
 
 #include <vector>
 #include <string>
+#include <mutex>
 
 #include "material.h"
+#include "dispersion_formula.h"
 
 
 namespace geopter {
@@ -43,12 +45,18 @@ public:
     Glass();
     ~Glass();
 
+    /** Return refractive index at specified wavelength. Results are memoized per (wavelength, temperature, pressure). */
     double RefractiveIndex(double wv_nm) const override;
 
+    /** Return refractive indices at multiple wavelengths, evaluating the dispersion formula in one batch */
+    std::vector<double> RefractiveIndices(const std::vector<double>& wvls_nm) const override;
+
     std::string Name() const override { return product_name_ + "_" + supplier_name_;}
     void SetName(const std::string& /*name*/) override { }
 
     void SetDispersionFormula(int i);
+    DispersionFormula::Type DispersionFormulaType() const { return formula_type_; }
+    const std::vector<double>& DispersionCoefs() const { return coefs_; }
     void SetDispersionCoefs(int i, double val);
 
     double RefractiveIndexRel(double wvl_micron) const;
@@ -73,9 +81,12 @@ private:
     double RelativeWavelength(double lambdainput, double T, double P = 101325.0) const;
     double RefractiveIndexAbs_Tref(double wvl_micron) const;
     double RefractiveIndexRel_Tref(double wvl_micron) const;
+    double ComputeRefractiveIndex(double wv_nm, double T, double P) const;
+    double ThermalIndexChange(double wvl_micron, double t, double n_rel_Tref) const;
 
     /** dispersion formula */
     double (*formula_func_ptr_)(double, const std::vector<double>&);
+    DispersionFormula::Type formula_type_;
 
     /** dispersion coefficients */
     std::vector<double> coefs_;
@@ -98,6 +109,19 @@ private:
     double Tref_;
 
     double Pref_;
+
+    struct IndexCacheEntry
+    {
+        double wv_nm;
+        double temperature;
+        double pressure;
+        double index;
+    };
+
+    /** memoized indices, valid while the material revision equals index_cache_revision_ */
+    mutable std::vector<IndexCacheEntry> index_cache_;
+    mutable uint64_t index_cache_revision_;
+    mutable std::mutex index_cache_mtx_;
 };
 
 } //namespace geopter
@@ -29,6 +29,7 @@
 #include <memory>
 #include <vector>
 #include <string>
+#include <unordered_map>
 
 #include "glass.h"
 
@@ -42,13 +43,34 @@ public:
 
     /**
      * @brief get glass property data from AGF file
+     *
+     * The parsed data are stored in a binary cache, which is read instead of the text on later loads.
+     * The cache is used while the size and modification time of the AGF file are unchanged, or while its FNV-1a hash matches.
+     * See SetCacheEnabled() and SetCacheDirectory() for the location of the cache.
      * @param agf_path AGF file path
      * @return success
      */
     bool LoadAgf(std::string agf_path);
 
+    /** Returns the binary cache path for the given AGF file */
+    static std::string CachePath(const std::string& agf_path);
+
+    /**
+     * @brief Enable or disable the binary cache. Enabled by default.
+     * @note must not be called while catalogs are being loaded
+     */
+    static void SetCacheEnabled(bool state) { cache_enabled_ = state; }
+    static bool CacheEnabled() { return cache_enabled_; }
+
+    /**
+     * @brief Directory to store the binary caches, created on demand. If empty, the cache is placed next to the AGF file (default).
+     * @note must not be called while catalogs are being loaded
+     */
+    static void SetCacheDirectory(const std::string& dir) { cache_dir_ = dir; }
+    static std::string CacheDirectory() { return cache_dir_; }
+
     /** Get glass object pointer.  If not found, return nullptr */
-    std::shared_ptr<Glass> GetGlass(std::string product_name);
+    std::shared_ptr<Glass> GetGlass(const std::string& product_name) const;
 
     /** Return glass ptr at the index */
     std::shared_ptr<Glass> GetGlass(int i);
@@ -68,6 +90,12 @@ private:
     /** supplier name */
     std::string name_;
     std::vector< std::shared_ptr<Glass> > glasses_;
+
+    /** product name to glass, built at loading */
+    std::unordered_map< std::string, std::shared_ptr<Glass> > name_index_;
+
+    static bool cache_enabled_;
+    static std::string cache_dir_;
 };
 
 } //namespace geopter
@@ -28,6 +28,8 @@
 #define MATERIAL_H
 
 #include <string>
+#include <vector>
+#include "common/revision_counter.h"
 #include "spec/spectral_line.h"
 
 namespace geopter {
@@ -39,11 +41,13 @@ public:
     Material(){
         name_ = "";
         n_ = 1.0;
+        revision_ = RevisionCounter::Next();
     }
 
     Material(double nd, std::string name){
         n_ = nd;
         name_ = name;
+        revision_ = RevisionCounter::Next();
     }
 
     virtual ~Material(){}
@@ -54,6 +58,18 @@ public:
     /** Return refractive index at specified wavelength */
     virtual double RefractiveIndex(double /*wv_nm*/) const { return n_; }
 
+    /** Return refractive indices at multiple wavelengths */
+    virtual std::vector<double> RefractiveIndices(const std::vector<double>& wvls_nm) const {
+        std::vector<double> n(wvls_nm.size());
+        for(size_t i = 0; i < wvls_nm.size(); i++){
+            n[i] = RefractiveIndex(wvls_nm[i]);
+        }
+        return n;
+    }
+
+    /** Stamp of the last modification of the dispersion data */
+    uint64_t Revision() const { return revision_; }
+
     /** Returns Abbe number in d-lne */
     virtual double Abbe_d() const {
         double nd = RefractiveIndex(SpectralLine::d);
@@ -66,6 +82,7 @@ public:
 protected:
     std::string name_;
     double n_;
+    uint64_t revision_;
 };
 
 } //namespace geopter
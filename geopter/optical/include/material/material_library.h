@@ -29,6 +29,8 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include <unordered_map>
+#include <mutex>
 
 #include "material/air.h"
 #include "material/glass_catalog.h"
@@ -36,6 +38,12 @@
 namespace geopter{
 
 
+/**
+ * @brief Glass catalogs shared by all optical systems
+ *
+ * The catalogs are static and shared among the instances. They are released when the last instance is destroyed,
+ * so systems may be created and destroyed while others are in use. LoadAgfFiles must not run while other systems are being traced.
+ */
 class MaterialLibrary
 {
 public:
@@ -62,6 +70,12 @@ public:
 private:
     static std::vector< std::unique_ptr<GlassCatalog> > catalogs_;
     static std::shared_ptr<Air> air_;
+
+    /** product name to glass across all catalogs, used for names without supplier */
+    static std::unordered_map< std::string, std::shared_ptr<Glass> > glass_index_;
+
+    static int num_instances_;
+    static std::mutex instances_mtx_;
 };
 
 
@@ -43,9 +43,12 @@
 #include "analysis/transverse_ray_fan.h"
 #include "analysis/opd_fan.h"
 #include "analysis/wavefront.h"
+#include "analysis/zernike.h"
 #include "analysis/diffractive_psf.h"
 #include "analysis/geometrical_mtf.h"
 #include "analysis/diffractive_mtf.h"
+#include "analysis/autocorrelation_mtf.h"
+#include "analysis/through_focus.h"
 
 #include "assembly/optical_assembly.h"
 
@@ -53,6 +56,7 @@
 #include "solve/edge_thickness_solve.h"
 #include "solve/overall_length_solve.h"
 #include "solve/marginal_ray_height_solve.h"
+#include "solve/best_focus_solve.h"
 
 #include "material/material_library.h"
 #include "material/buchdahl_glass.h"
@@ -64,7 +68,16 @@
 
 #include "sequential/sequential_trace.h"
 #include "sequential/ray.h"
+#include "sequential/ray_bundle.h"
+#include "sequential/ray_derivative.h"
+#include "sequential/compiled_sequential_path.h"
+#include "sequential/conic_kernel.h"
 #include "sequential/trace_error.h"
+#include "sequential/trace_statistics.h"
+
+#include "optimization/optimization_variable.h"
+#include "optimization/merit_function.h"
+#include "optimization/dls_optimizer.h"
 
 #include "element/lens.h"
 #include "element/mirror.h"
@@ -78,6 +91,8 @@
 #include "renderer/rgb.h"
 
 #include "common/string_tool.h"
+#include "common/thread_pool.h"
+#include "common/dual_number.h"
 
 #include "environment/environment.h"
 
@@ -0,0 +1,117 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#ifndef GEOPTER_DLS_OPTIMIZER_H
+#define GEOPTER_DLS_OPTIMIZER_H
+
+#include <vector>
+#include <memory>
+
+#include "Eigen/Core"
+
+#include "optimization/optimization_variable.h"
+#include "optimization/merit_function.h"
+
+namespace geopter {
+
+class OpticalSystem;
+
+/**
+ * @brief Damped least squares optimizer
+ *
+ * The merit function is minimized by Levenberg-Marquardt iterations. Each column of the Jacobian is evaluated
+ * by finite difference on an independent copy of the system, so that the columns can be computed in parallel.
+ * The result is written back to the system when the optimization ends.
+ */
+class DlsOptimizer
+{
+public:
+    struct Result
+    {
+        int iterations = 0;
+        double initial_merit = 0.0;
+        double final_merit = 0.0;
+        bool converged = false;
+
+        /** No damped step lowered the merit. The iteration stopped without convergence. */
+        bool stalled = false;
+    };
+
+    explicit DlsOptimizer(OpticalSystem* opt_sys);
+    ~DlsOptimizer();
+
+    void AddVariable(const OptimizationVariable& var);
+    void ClearVariables();
+    int NumberOfVariables() const { return variables_.size(); }
+    const OptimizationVariable& GetVariable(int i) const { return variables_[i]; }
+
+    MeritFunction* GetMeritFunction() { return &merit_func_; }
+
+    void SetMaxIterations(int n) { max_iter_ = n; }
+    int MaxIterations() const { return max_iter_; }
+
+    /** Initial damping factor */
+    void SetDamping(double mu) { damping_ = mu; }
+    double Damping() const { return damping_; }
+
+    /** Finite difference step relative to the scale of each variable */
+    void SetFiniteDifferenceStep(double h) { fd_step_ = h; }
+    double FiniteDifferenceStep() const { return fd_step_; }
+
+    /** Relative decrease of the merit below which the iteration is regarded as converged */
+    void SetTolerance(double tol) { tolerance_ = tol; }
+    double Tolerance() const { return tolerance_; }
+
+    Result Optimize();
+
+    /** Jacobian of the residuals with respect to the variables at the current system */
+    Eigen::MatrixXd Jacobian();
+
+private:
+    void prepare_copies();
+
+    Eigen::VectorXd current_values() const;
+    void apply_values(OpticalSystem* opt_sys, const Eigen::VectorXd& x) const;
+    Eigen::VectorXd residuals_at(OpticalSystem* opt_sys, const Eigen::VectorXd& x) const;
+    Eigen::MatrixXd jacobian_at(const Eigen::VectorXd& x, const Eigen::VectorXd& r0);
+
+    OpticalSystem* opt_sys_;
+    std::vector<OptimizationVariable> variables_;
+    MeritFunction merit_func_;
+
+    /** one system for the trial steps and one for each Jacobian column */
+    std::unique_ptr<OpticalSystem> trial_sys_;
+    std::vector<std::unique_ptr<OpticalSystem>> column_sys_;
+    std::vector<double> scales_;
+
+    int max_iter_;
+    double damping_;
+    double fd_step_;
+    double tolerance_;
+};
+
+} //namespace geopter
+
+#endif //GEOPTER_DLS_OPTIMIZER_H
@@ -0,0 +1,128 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#ifndef GEOPTER_MERIT_FUNCTION_H
+#define GEOPTER_MERIT_FUNCTION_H
+
+#include <vector>
+#include <string>
+
+#include "Eigen/Core"
+
+namespace geopter {
+
+class OpticalSystem;
+
+/** Target value of a real ray quantity */
+class MeritOperand
+{
+public:
+    enum Type
+    {
+        EffectiveFocalLength,
+        RmsSpot,
+        TransverseX,
+        TransverseY,
+        Opd,
+        RmsOpd
+    };
+
+    /**
+     * @param type operand type
+     * @param target target value. Lengths are in mm, and OPD in waves.
+     * @param weight weight in the sum of squares
+     * @param field_index field index, unused for EffectiveFocalLength
+     * @param wvl_index wavelength index. -1 uses all wavelengths with their weights for RmsSpot and RmsOpd, and the reference wavelength for the others.
+     */
+    MeritOperand(int type, double target, double weight = 1.0, int field_index = 0, int wvl_index = -1);
+
+    int GetType() const { return type_; }
+    double Target() const { return target_; }
+    double Weight() const { return weight_; }
+
+    void SetTarget(double t) { target_ = t; }
+    void SetWeight(double w) { weight_ = w; }
+
+    /** Pupil coordinate of the ray for TransverseX, TransverseY and Opd */
+    void SetPupil(double px, double py) { pupil_ = Eigen::Vector2d(px, py); }
+    const Eigen::Vector2d& Pupil() const { return pupil_; }
+
+    /** Number of rays across the pupil diameter for RmsSpot and RmsOpd */
+    void SetGridSize(int nrd) { nrd_ = nrd; }
+    int GridSize() const { return nrd_; }
+
+    bool Check(const OpticalSystem* opt_sys) const;
+
+    /** Evaluate the current value. NaN is returned when the rays cannot be traced. */
+    double Evaluate(OpticalSystem* opt_sys) const;
+
+    std::string Name() const;
+
+private:
+    double rms_spot(OpticalSystem* opt_sys) const;
+    double transverse(OpticalSystem* opt_sys, int axis) const;
+    double wavefront(OpticalSystem* opt_sys, bool rms) const;
+
+    std::vector<int> wavelength_indices(OpticalSystem* opt_sys) const;
+
+    int type_;
+    double target_;
+    double weight_;
+    int field_index_;
+    int wvl_index_;
+    Eigen::Vector2d pupil_;
+    int nrd_;
+};
+
+
+/** Weighted sum of squares of the operand errors */
+class MeritFunction
+{
+public:
+    MeritFunction();
+
+    void AddOperand(const MeritOperand& operand);
+    void RemoveOperand(int i);
+    void Clear();
+
+    int NumberOfOperands() const { return operands_.size(); }
+    MeritOperand* GetOperand(int i) { return &operands_[i]; }
+
+    /** Returns sqrt(weight)*(value - target) of each operand */
+    Eigen::VectorXd Residuals(OpticalSystem* opt_sys) const;
+
+    /** Returns the sum of squared residuals, or infinity if any operand fails */
+    double Value(OpticalSystem* opt_sys) const;
+
+    /** Sum of squares of the given residuals in the same manner as Value() */
+    static double SumOfSquares(const Eigen::VectorXd& residuals);
+
+private:
+    std::vector<MeritOperand> operands_;
+};
+
+} //namespace geopter
+
+#endif //GEOPTER_MERIT_FUNCTION_H
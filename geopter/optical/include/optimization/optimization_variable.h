@@ -0,0 +1,82 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#ifndef GEOPTER_OPTIMIZATION_VARIABLE_H
+#define GEOPTER_OPTIMIZATION_VARIABLE_H
+
+#include <string>
+
+namespace geopter {
+
+class OpticalSystem;
+
+/** Prescription parameter varied by the optimizer */
+class OptimizationVariable
+{
+public:
+    enum Type
+    {
+        Curvature,
+        Thickness,
+        Conic,
+        AsphereCoefficient
+    };
+
+    /**
+     * @param type variable type
+     * @param index surface index, or gap index for Thickness
+     * @param term polynomial term index for AsphereCoefficient
+     */
+    OptimizationVariable(int type, int index, int term = 0);
+
+    int GetType() const { return type_; }
+    int Index() const { return index_; }
+    int Term() const { return term_; }
+
+    /** Returns false if the parameter does not exist in the system, e.g. the conic of a spherical surface */
+    bool Check(const OpticalSystem* opt_sys) const;
+
+    double Value(const OpticalSystem* opt_sys) const;
+    void SetValue(OpticalSystem* opt_sys, double value) const;
+
+    /**
+     * @brief Typical magnitude of the variable, used to scale the finite difference step
+     *
+     * Curvature and thickness are scaled by 1/mm and mm. Aspheric terms are scaled so that the change of the sag
+     * at the semi-diameter is comparable among the terms.
+     */
+    double Scale(const OpticalSystem* opt_sys) const;
+
+    std::string Name() const;
+
+private:
+    int type_;
+    int index_;
+    int term_;
+};
+
+} //namespace geopter
+
+#endif //GEOPTER_OPTIMIZATION_VARIABLE_H
@@ -41,6 +41,9 @@ struct FirstOrderData
 
     void Update();
 
+    /** Copy the values of the given data. The parent system is kept. */
+    void CopyFrom(const FirstOrderData& other);
+
     void Print(std::ostringstream& oss);
 
 private:
@@ -29,6 +29,8 @@
 #include <vector>
 #include <string>
 #include "Eigen/Core"
+#include "common/revision_counter.h"
+#include "profile/newton_intersect.h"
 
 namespace geopter {
 
@@ -45,6 +47,9 @@ public:
         return "ASP";
     }
 
+    /** Stamp of the last modification */
+    uint64_t Revision() const { return revision_; }
+
     /** Returns the conic factor */
     double Conic() const {
         return conic_;
@@ -64,12 +69,37 @@ public:
     double deriv_1st(double h) const;
     double deriv_2nd(double h) const;
 
-    void SetConic(double cc) {  conic_ = cc;}
+    void SetConic(double cc) {  conic_ = cc; revision_ = RevisionCounter::Next(); }
     void SetNthTerm(int i, double val);
     void SetTerms(const std::vector<double>& coefs);
 
     bool Intersect(Eigen::Vector3d& pt, double& distance, const Eigen::Vector3d& p0, const Eigen::Vector3d& dir);
 
+    /** Convergence tolerance of the intersection */
+    double Tolerance() const { return eps_; }
+
+    /** Sag, gradient and intersection evaluated on raw coefficients */
+    static double ComputeSag(double cv, double conic, const double* terms, int num_terms, double x, double y);
+
+    /**
+     * @brief Gradient of f = z - sag
+     * @note T is double or DualNumber, which gives the derivatives with respect to the coefficients
+     */
+    template<typename T>
+    static Eigen::Matrix<T,3,1> ComputeGradient(const T& cv, const T& conic, const T* terms, int num_terms, const Eigen::Matrix<T,3,1>& p);
+
+    /** Sag and gradient evaluated together in one Horner pass. Returns false if the point is outside of the base conic. */
+    template<typename T>
+    static bool ComputeSagAndGradient(const T& cv, const T& conic, const T* terms, int num_terms, const T& x, const T& y, T& sag, Eigen::Matrix<T,3,1>& grad);
+
+    /**
+     * @brief Intersection by Newton iteration starting from the exact intersection with the base conic
+     * @param iterations if not null, receives the number of iterations
+     */
+    template<typename T>
+    static bool ComputeIntersect(Eigen::Matrix<T,3,1>& pt, T& distance, const Eigen::Matrix<T,3,1>& p0, const Eigen::Matrix<T,3,1>& dir,
+                                 const T& cv, const T& conic, const T* terms, int num_terms, double eps, int* iterations = nullptr);
+
     void Print(std::ostringstream& oss);
 
 protected:
@@ -78,8 +108,63 @@ protected:
     double conic_;
     std::vector<double> terms_;
     int num_terms_;
+    uint64_t revision_;
 };
 
+
+template<typename T>
+bool EvenPolynomial::ComputeSagAndGradient(const T& cv, const T& conic, const T* terms, int num_terms, const T& x, const T& y, T& sag, Eigen::Matrix<T,3,1>& grad)
+{
+    using std::sqrt;
+
+    const T r2 = x*x + y*y;
+    const T inside_sqrt = 1.0 - (conic+1.0)*cv*cv*r2;
+    if(ScalarValue(inside_sqrt) < 0.0){
+        return false;
+    }
+    const T t = sqrt(inside_sqrt);
+
+    // polynomial P(r2) = sum(a_i*r2^(i+2)) and dP/d(r2), both in one Horner pass
+    T pol   = T(0.0);
+    T d_pol = T(0.0);
+    for(int i = num_terms - 1; i >= 0; i--){
+        pol   = pol*r2 + terms[i];
+        d_pol = d_pol*r2 + (i+2)*terms[i];
+    }
+
+    sag = cv*r2/(1.0 + t) + pol*r2*r2;
+
+    const T e_tot = cv/t + 2.0*d_pol*r2;
+    grad = Eigen::Matrix<T,3,1>(-e_tot*x, -e_tot*y, T(1.0));
+
+    return true;
+}
+
+template<typename T>
+Eigen::Matrix<T,3,1> EvenPolynomial::ComputeGradient(const T& cv, const T& conic, const T* terms, int num_terms, const Eigen::Matrix<T,3,1>& p)
+{
+    T sag;
+    Eigen::Matrix<T,3,1> grad;
+    if( ! ComputeSagAndGradient(cv, conic, terms, num_terms, p(0), p(1), sag, grad) ){
+        return Eigen::Matrix<T,3,1>(T(NAN), T(NAN), T(1.0));
+    }
+
+    return grad;
+}
+
+template<typename T>
+bool EvenPolynomial::ComputeIntersect(Eigen::Matrix<T,3,1>& pt, T& distance, const Eigen::Matrix<T,3,1>& p0, const Eigen::Matrix<T,3,1>& dir,
+                                      const T& cv, const T& conic, const T* terms, int num_terms, double eps, int* iterations)
+{
+    constexpr int max_iter = 50;
+
+    auto sag_and_grad = [&](const T& x, const T& y, T& sag, Eigen::Matrix<T,3,1>& grad){
+        return ComputeSagAndGradient(cv, conic, terms, num_terms, x, y, sag, grad);
+    };
+
+    return NewtonIntersect(pt, distance, p0, dir, cv, conic, eps, max_iter, sag_and_grad, iterations);
+}
+
 } //namespace
 
 #endif // EVENPOLYNOMIAL_H
@@ -0,0 +1,113 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#ifndef NEWTON_INTERSECT_H
+#define NEWTON_INTERSECT_H
+
+#include <cmath>
+#include "Eigen/Core"
+#include "common/dual_number.h"
+
+namespace geopter {
+
+/**
+ * @brief Ray-surface intersection by Newton iteration, shared by the polynomial profiles
+ *
+ * The iteration starts from the exact intersection with the base conic, c(x^2 + y^2 + (1+k)z^2) - 2z = 0.
+ * If it does not converge, or converges to a crossing from behind the surface (which happens on strongly
+ * curled high order aspheres), the iteration is repeated from the foot of perpendicular as in Spencer's method.
+ *
+ * T is double or DualNumber. With dual numbers the derivatives converge along with the value, as the last
+ * Newton step is taken at the converged point.
+ *
+ * @param sag_and_grad callable bool(T x, T y, T& sag, Eigen::Matrix<T,3,1>& grad)
+ * @param iterations if not null, receives the total number of Newton iterations
+ */
+template<typename T, class SagAndGradient>
+bool NewtonIntersect(Eigen::Matrix<T,3,1>& pt, T& distance, const Eigen::Matrix<T,3,1>& p0, const Eigen::Matrix<T,3,1>& dir,
+                     const T& cv, const T& conic, double eps, int max_iter, const SagAndGradient& sag_and_grad, int* iterations)
+{
+    using std::sqrt;
+    using std::fabs;
+
+    Eigen::Matrix<T,3,1> p;
+    Eigen::Matrix<T,3,1> grad;
+    T sag;
+    int iter = 0;
+
+    // iterate from s, returns true if converged (onto the front side of the surface if front_only)
+    auto iterate = [&](const T& s, bool front_only) -> bool {
+        distance = s;
+        for(int i = 0; i <= max_iter; i++){
+            p = p0 + distance*dir;
+            if( ! sag_and_grad(p(0), p(1), sag, grad) ){
+                return false;
+            }
+
+            const T slope = dir.dot(grad);
+            const T s2 = distance - (p(2) - sag)/slope;
+            const double delta = fabs(ScalarValue(s2) - ScalarValue(distance));
+            distance = s2;
+            iter++;
+
+            if( !std::isfinite(ScalarValue(distance)) ){
+                return false;
+            }
+            if(delta <= eps){
+                return ( !front_only || ScalarValue(slope) > 0.0 );
+            }
+        }
+        return false;
+    };
+
+    bool converged = false;
+
+    const T a  = cv*(1.0 + conic*dir(2)*dir(2));
+    const T b  = cv*(dir.dot(p0) + conic*dir(2)*p0(2)) - dir(2);
+    const T cc = cv*(p0.dot(p0) + conic*p0(2)*p0(2)) - 2.0*p0(2);
+    const T inside_sqrt = b*b - a*cc;
+    if(ScalarValue(inside_sqrt) >= 0.0){
+        const T s_conic = cc/(sqrt(inside_sqrt) - b);
+        if(std::isfinite(ScalarValue(s_conic))){
+            converged = iterate(s_conic, true);
+        }
+    }
+
+    if( !converged ){
+        converged = iterate(T(0.0), false);
+    }
+
+    if(iterations){
+        *iterations = iter;
+    }
+
+    pt = p;
+
+    return converged;
+}
+
+} //namespace geopter
+
+#endif // NEWTON_INTERSECT_H
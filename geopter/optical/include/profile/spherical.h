@@ -28,6 +28,8 @@
 #define SPHERICAL_H
 
 #include "surface_profile.h"
+#include "common/revision_counter.h"
+#include "common/dual_number.h"
 
 namespace geopter {
 
@@ -37,32 +39,65 @@ class Spherical
 public:
     Spherical(){
         cv_ = 0.0;
+        revision_ = RevisionCounter::Next();
     }
     Spherical(double c){
         cv_ = c;
+        revision_ = RevisionCounter::Next();
     }
 
     std::string Name() const{
         return "SPH";
     }
 
+    /** Stamp of the last modification */
+    uint64_t Revision() const { return revision_; }
+
     double f(const Eigen::Vector3d& p) const {
         return p(2) - 0.5*cv_*(p.dot(p));
     }
 
     Eigen::Vector3d df(const Eigen::Vector3d& p) const{
-        Eigen::Vector3d df({-cv_*p(0), -cv_*p(1), 1.0 - cv_*p(2)} );
-        return df;
+        return ComputeGradient(cv_, p);
     }
 
     double Sag(double x, double y) const;
 
     bool Intersect(Eigen::Vector3d& pt, double& distance, const Eigen::Vector3d& p0, const Eigen::Vector3d& dir);
 
+    /** Gradient and intersection on the raw curvature. T is double or DualNumber. */
+    template<typename T>
+    static Eigen::Matrix<T,3,1> ComputeGradient(const T& cv, const Eigen::Matrix<T,3,1>& p){
+        return Eigen::Matrix<T,3,1>(-cv*p(0), -cv*p(1), 1.0 - cv*p(2));
+    }
+
+    template<typename T>
+    static bool ComputeIntersect(Eigen::Matrix<T,3,1>& pt, T& distance, const Eigen::Matrix<T,3,1>& p0, const Eigen::Matrix<T,3,1>& dir, const T& cv)
+    {
+        using std::sqrt;
+        constexpr double z_dir = 1.0; // z direction, currently reflection is not supported
+
+        const T ax2 = cv;
+        const T cx2 = cv*(p0.dot(p0)) - 2.0*p0(2);
+        const T b = cv*(dir.dot(p0)) - dir(2);
+
+        const T inside_sqrt = b*b - ax2*cx2;
+
+        if(ScalarValue(inside_sqrt) < 0.0){
+            return false;
+        }
+
+        distance = cx2/(z_dir*sqrt(inside_sqrt) - b);
+        pt = p0 + distance*dir;
+
+        return true;
+    }
+
     void print(std::ostringstream& oss){};
 
 protected:
     double cv_;
+    uint64_t revision_;
 };
 
 
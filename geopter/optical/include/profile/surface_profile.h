@@ -29,6 +29,7 @@
 #include <sstream>
 #include <vector>
 #include "Eigen/Core"
+#include "common/revision_counter.h"
 #include "spherical.h"
 #include "even_polynomial.h"
 #include "odd_polynomial.h"
@@ -45,6 +46,7 @@ public:
 
     void SetCurvature(double c) {
         Profile::cv_ = c;
+        Profile::revision_ = RevisionCounter::Next();
     }
 
     /** Returns center curvature */
@@ -62,6 +64,7 @@ public:
         }else{
             Profile::cv_ = 1.0/r;
         }
+        Profile::revision_ = RevisionCounter::Next();
     }
 
     /** Returns center radius */
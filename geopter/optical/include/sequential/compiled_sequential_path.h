@@ -0,0 +1,204 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#ifndef COMPILED_SEQUENTIAL_PATH_H
+#define COMPILED_SEQUENTIAL_PATH_H
+
+#include <vector>
+
+#include "Eigen/Core"
+
+#include "profile/spherical.h"
+#include "profile/even_polynomial.h"
+#include "profile/odd_polynomial.h"
+
+namespace geopter {
+
+class Surface;
+class SequentialPath;
+
+enum class CompiledProfileType
+{
+    Spherical,
+    EvenPolynomial,
+    OddPolynomial
+};
+
+enum class CompiledApertureType
+{
+    None,
+    Circular
+};
+
+/**
+ * @brief Flat copy of one sequential path component
+ *
+ * All the data needed in the trace loop are held by value, so that the tracer neither visits the profile variant
+ * nor allocates per call. The shape and the transfer are held in T, which is double for the ordinary trace and
+ * DualNumber for the trace of derivatives.
+ */
+template<typename T>
+struct BasicCompiledSurface
+{
+    static constexpr int max_terms = 10;
+
+    CompiledProfileType profile;
+    T cv;
+    T conic;
+    double tolerance;
+    int num_terms;
+    T terms[max_terms];
+
+    /** transform to the next surface (row-major rotation) */
+    double rotation[9];
+    T transfer[3];
+
+    double distance;
+    double refractive_index;
+
+    CompiledApertureType aperture;
+    double aperture_radius;
+
+    /** original surface */
+    Surface* surface;
+
+    /** @param iterations if not null, receives the number of iterations (0 for spherical surfaces) */
+    bool Intersect(Eigen::Matrix<T,3,1>& pt, T& distance_to_pt, const Eigen::Matrix<T,3,1>& p0, const Eigen::Matrix<T,3,1>& dir, int* iterations = nullptr) const;
+    Eigen::Matrix<T,3,1> Normal(const Eigen::Matrix<T,3,1>& pt) const;
+    double Sag(double x, double y) const;
+
+    bool PointInside(double x, double y) const{
+        if(aperture == CompiledApertureType::Circular){
+            return ( (x*x + y*y) <= (aperture_radius*aperture_radius) );
+        }
+        return true;
+    }
+
+    /** Returns true if the profile has no polynomial term, i.e. spherical or pure conic */
+    bool IsConic() const;
+};
+
+using CompiledSurface = BasicCompiledSurface<double>;
+
+
+template<typename T>
+bool BasicCompiledSurface<T>::Intersect(Eigen::Matrix<T,3,1> &pt, T &distance_to_pt, const Eigen::Matrix<T,3,1> &p0, const Eigen::Matrix<T,3,1> &dir, int* iterations) const
+{
+    switch (profile) {
+    case CompiledProfileType::EvenPolynomial:
+        return EvenPolynomial::ComputeIntersect(pt, distance_to_pt, p0, dir, cv, conic, terms, num_terms, tolerance, iterations);
+    case CompiledProfileType::OddPolynomial:
+        return OddPolynomial::ComputeIntersect(pt, distance_to_pt, p0, dir, cv, conic, terms, num_terms, tolerance, iterations);
+    default:
+        if(iterations){
+            *iterations = 0;
+        }
+        return Spherical::ComputeIntersect(pt, distance_to_pt, p0, dir, cv);
+    }
+}
+
+template<typename T>
+Eigen::Matrix<T,3,1> BasicCompiledSurface<T>::Normal(const Eigen::Matrix<T,3,1> &pt) const
+{
+    Eigen::Matrix<T,3,1> grad;
+    switch (profile) {
+    case CompiledProfileType::EvenPolynomial:
+        grad = EvenPolynomial::ComputeGradient(cv, conic, terms, num_terms, pt);
+        break;
+    case CompiledProfileType::OddPolynomial:
+        grad = OddPolynomial::ComputeGradient(cv, conic, terms, num_terms, pt);
+        break;
+    default:
+        grad = Spherical::ComputeGradient(cv, pt);
+        break;
+    }
+
+    using std::sqrt;
+    const T len2 = grad.squaredNorm();
+    if(ScalarValue(len2) > 0.0){
+        return grad/sqrt(len2);
+    }
+    return grad;
+}
+
+template<typename T>
+double BasicCompiledSurface<T>::Sag(double x, double y) const
+{
+    switch (profile) {
+    case CompiledProfileType::EvenPolynomial:
+        return EvenPolynomial::ComputeSag(cv, conic, terms, num_terms, x, y);
+    case CompiledProfileType::OddPolynomial:
+        return OddPolynomial::ComputeSag(cv, conic, terms, num_terms, x, y);
+    default:
+        return Spherical(cv).Sag(x, y);
+    }
+}
+
+template<typename T>
+bool BasicCompiledSurface<T>::IsConic() const
+{
+    if(profile == CompiledProfileType::Spherical){
+        return true;
+    }else if(profile == CompiledProfileType::EvenPolynomial){
+        return (num_terms == 0);
+    }
+
+    return false;
+}
+
+
+/**
+ * @brief Sequential path flattened into an array of CompiledSurface
+ *
+ * The surfaces are copied when appended, so the compiled path goes stale on any later edit of the prescription.
+ * It is only valid as part of a SequentialPath taken from OpticalSystem::GetSequentialPath().
+ */
+class CompiledSequentialPath
+{
+public:
+    CompiledSequentialPath();
+    explicit CompiledSequentialPath(const SequentialPath& seq_path);
+    ~CompiledSequentialPath();
+
+    int Size() const { return static_cast<int>(surfaces_.size()); }
+
+    const CompiledSurface& At(int i) const { return surfaces_[i]; }
+
+    const CompiledSurface* Data() const { return surfaces_.data(); }
+
+    void Clear();
+
+    void Append(Surface* s, double thi, double n);
+
+    /** Create a flat copy of the given surface */
+    static CompiledSurface Compile(Surface* s, double thi, double n);
+
+private:
+    std::vector<CompiledSurface> surfaces_;
+};
+
+} //namespace geopter
+
+#endif // COMPILED_SEQUENTIAL_PATH_H
@@ -0,0 +1,91 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#ifndef CONIC_KERNEL_H
+#define CONIC_KERNEL_H
+
+#include <string>
+
+#include "sequential/ray_bundle.h"
+#include "sequential/compiled_sequential_path.h"
+
+namespace geopter {
+
+enum class SimdInstructionSet
+{
+    Scalar,
+    AVX2,
+    AVX512
+};
+
+/**
+ * @brief Vectorized intersect-and-refract kernel for spherical and conic surfaces
+ *
+ * The kernel processes one surface of a RayBundle at a time. The instruction set is detected at runtime,
+ * and the scalar implementation is used when neither AVX2 nor AVX-512 is available.
+ */
+class ConicKernel
+{
+public:
+    struct Parameters
+    {
+        /** transform from the previous surface (row-major rotation) */
+        double rotation[9];
+        double transfer[3];
+
+        double cv;
+        double conic;
+        double n_in;
+        double n_out;
+    };
+
+    /** Create parameters from compiled path entries. The transform is taken from the previous surface. */
+    static Parameters CreateParameters(const CompiledSurface& before_srf, const CompiledSurface& cur_srf);
+
+    /**
+     * @brief Intersect and refract all rays of the bundle at the given surface
+     * Only the rays whose bundle status is TRACE_SUCCESS are traced. The rows and the results of the other rays are left untouched.
+     * @param bundle ray bundle, whose data at srf_index-1 are used as the incident rays
+     * @param srf_index surface index in the bundle
+     * @param prm surface parameters
+     * @param result per ray trace result (TRACE_SUCCESS, TRACE_MISSEDSURFACE_ERROR or TRACE_TIR_ERROR)
+     */
+    static void IntersectAndRefract(RayBundle& bundle, int srf_index, const Parameters& prm, TraceError* result);
+
+    /** Instruction set supported by the running CPU */
+    static SimdInstructionSet DetectInstructionSet();
+
+    /** Instruction set currently used */
+    static SimdInstructionSet InstructionSet();
+
+    /** Force the instruction set. Requests beyond the CPU capability fall back to the detected one. */
+    static void SetInstructionSet(SimdInstructionSet isa);
+
+    static std::string InstructionSetName(SimdInstructionSet isa);
+};
+
+} //namespace geopter
+
+#endif // CONIC_KERNEL_H
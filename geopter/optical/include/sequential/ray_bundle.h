@@ -0,0 +1,149 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#ifndef RAY_BUNDLE_H
+#define RAY_BUNDLE_H
+
+#include <vector>
+#include <cstdint>
+
+#include "Eigen/Core"
+#include "sequential/trace_error.h"
+
+namespace geopter {
+
+/**
+ * @brief Structure-of-arrays container for many rays traced through the same path.
+ *
+ * Every per-surface quantity is held in a contiguous array laid out surface by surface,
+ * i.e. the value of ray i at surface s is stored at [s*N + i] where N is the number of rays.
+ *
+ * In image-only mode the bundle holds just two rows used alternately while tracing.
+ * After the trace only the data at the last surface, the accumulated optical path length and the status are valid.
+ * For the rays terminated on the way, the data at the reached surface are kept instead of the last surface.
+ */
+class RayBundle
+{
+public:
+    RayBundle();
+    RayBundle(int num_rays, int num_srfs, bool image_only = false);
+    ~RayBundle();
+
+    /** Reserve arrays for the given number of rays and surfaces. Existing data is discarded. */
+    void Allocate(int num_rays, int num_srfs, bool image_only = false);
+
+    void Clear();
+
+    int NumberOfRays() const { return num_rays_; }
+    int NumberOfSurfaces() const { return num_srfs_; }
+
+    /** Returns true if intermediate surface data are not stored */
+    bool IsImageOnly() const { return image_only_; }
+
+    /** Set starting point and direction at the object surface */
+    void SetInitialRay(int ray_index, const Eigen::Vector3d& pt0, const Eigen::Vector3d& dir0);
+
+    void SetPupilCoordinate(int ray_index, const Eigen::Vector2d& pupil);
+    Eigen::Vector2d PupilCoordinate(int ray_index) const;
+
+    void SetWavelength(double wvl) { wvl_ = wvl; }
+    double Wavelength() const { return wvl_; }
+
+    void SetStatus(int ray_index, TraceError s) { status_[ray_index] = s; }
+    TraceError Status(int ray_index) const { return status_[ray_index]; }
+
+    void SetReachedSurfaceIndex(int ray_index, int srf_index) { reached_[ray_index] = srf_index; }
+    int ReachedSurfaceIndex(int ray_index) const { return reached_[ray_index]; }
+
+    /** Local coordinate at the intersection point */
+    double X(int ray_index, int srf_index) const { return x_[Offset(ray_index, srf_index)]; }
+    double Y(int ray_index, int srf_index) const { return y_[Offset(ray_index, srf_index)]; }
+    double Z(int ray_index, int srf_index) const { return z_[Offset(ray_index, srf_index)]; }
+
+    /** Direction after surface interaction */
+    double L(int ray_index, int srf_index) const { return l_[Offset(ray_index, srf_index)]; }
+    double M(int ray_index, int srf_index) const { return m_[Offset(ray_index, srf_index)]; }
+    double N(int ray_index, int srf_index) const { return n_[Offset(ray_index, srf_index)]; }
+
+    Eigen::Vector3d IntersectPt(int ray_index, int srf_index) const;
+    Eigen::Vector3d Direction(int ray_index, int srf_index) const;
+
+    /** Distance from the previous point to the intersect point */
+    double PathLength(int ray_index, int srf_index) const { return dist_[Offset(ray_index, srf_index)]; }
+
+    /** Optical path length from the previous surface to the current */
+    double SegmentOpticalPathLength(int ray_index, int srf_index) const { return opl_[Offset(ray_index, srf_index)]; }
+
+    /** Total optical path length, summed in the same manner as Ray::OpticalPathLength up to the reached surface */
+    double OpticalPathLength(int ray_index) const;
+
+    /** Add the segment optical path length at the given surface to the running total (image-only mode) */
+    void AccumulateOpticalPathLength(int ray_index, int srf_index) { opl_tot_[ray_index] += opl_[Offset(ray_index, srf_index)]; }
+
+    /** Write one surface interaction */
+    void SetData(int ray_index, int srf_index, const Eigen::Vector3d& pt, const Eigen::Vector3d& dir, double dist, double opl);
+
+    /** Raw access to the contiguous per-surface arrays, each NumberOfRays() long */
+    double* XData(int srf_index) { return x_.data() + Offset(0, srf_index); }
+    double* YData(int srf_index) { return y_.data() + Offset(0, srf_index); }
+    double* ZData(int srf_index) { return z_.data() + Offset(0, srf_index); }
+    double* LData(int srf_index) { return l_.data() + Offset(0, srf_index); }
+    double* MData(int srf_index) { return m_.data() + Offset(0, srf_index); }
+    double* NData(int srf_index) { return n_.data() + Offset(0, srf_index); }
+    double* PathLengthData(int srf_index) { return dist_.data() + Offset(0, srf_index); }
+    double* OpticalPathLengthData(int srf_index) { return opl_.data() + Offset(0, srf_index); }
+    TraceError* StatusData() { return status_.data(); }
+    int* ReachedSurfaceIndexData() { return reached_.data(); }
+
+private:
+    size_t Offset(int ray_index, int srf_index) const {
+        const size_t row = image_only_ ? (size_t)(srf_index & 1) : (size_t)srf_index;
+        return row*(size_t)num_rays_ + (size_t)ray_index;
+    }
+
+    int num_rays_;
+    int num_srfs_;
+    bool image_only_;
+    double wvl_;
+
+    std::vector<double> x_;
+    std::vector<double> y_;
+    std::vector<double> z_;
+    std::vector<double> l_;
+    std::vector<double> m_;
+    std::vector<double> n_;
+    std::vector<double> dist_;
+    std::vector<double> opl_;
+    std::vector<double> opl_tot_;
+
+    std::vector<TraceError> status_;
+    std::vector<int> reached_;
+    std::vector<double> px_;
+    std::vector<double> py_;
+};
+
+} //namespace geopter
+
+#endif // RAY_BUNDLE_H
@@ -0,0 +1,109 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#ifndef RAY_DERIVATIVE_H
+#define RAY_DERIVATIVE_H
+
+#include <vector>
+
+#include "Eigen/Core"
+
+namespace geopter {
+
+class CompiledSequentialPath;
+
+/** Surface parameter of a sequential path, with respect to which the derivatives of a ray are traced */
+struct TraceParameter
+{
+    enum Type
+    {
+        Curvature,
+        Conic,
+        PolynomialTerm,
+        Thickness
+    };
+
+    /**
+     * @param type parameter type
+     * @param index surface index in the path, or the index of the gap following the surface for Thickness
+     * @param term polynomial term index for PolynomialTerm
+     */
+    TraceParameter(int type, int index, int term = 0) : type(type), index(index), term(term){}
+
+    /**
+     * Returns false if the parameter does not exist in the path, e.g. the conic of a spherical surface.
+     * Thickness is also rejected for decentered or tilted gaps, as only the axial transfer is differentiated.
+     */
+    bool Check(const CompiledSequentialPath& path) const;
+
+    int type;
+    int index;
+    int term;
+};
+
+
+/**
+ * @brief Derivatives of the ray data with respect to the trace parameters
+ *
+ * Each quantity has one column per parameter, in the order given to SequentialTrace::TraceRayDerivative().
+ */
+class RayDerivative
+{
+public:
+    RayDerivative();
+    ~RayDerivative();
+
+    void Allocate(int num_segments, int num_params);
+
+    int NumberOfSegments() const { return pts_.size(); }
+    int NumberOfParameters() const { return num_params_; }
+
+    /** Derivatives of the intersect point in the local coordinate, 3 x NumberOfParameters() */
+    const Eigen::Matrix3Xd& IntersectPt(int srf_index) const { return pts_[srf_index]; }
+
+    /** Derivatives of the direction after the surface interaction */
+    const Eigen::Matrix3Xd& Direction(int srf_index) const { return dirs_[srf_index]; }
+
+    /** Derivatives of the optical path length from the previous surface to the current */
+    Eigen::RowVectorXd SegmentOpticalPathLength(int srf_index) const { return opl_.row(srf_index); }
+
+    /** Derivatives of the total optical path length, summed in the same manner as Ray::OpticalPathLength */
+    Eigen::RowVectorXd OpticalPathLength() const;
+
+    /** Write the derivatives of one surface interaction into the columns from col */
+    void SetData(int srf_index, int col, const Eigen::Matrix3Xd& pt, const Eigen::Matrix3Xd& dir, const Eigen::RowVectorXd& opl);
+
+    void Clear();
+
+private:
+    std::vector<Eigen::Matrix3Xd> pts_;
+    std::vector<Eigen::Matrix3Xd> dirs_;
+    Eigen::MatrixXd opl_;
+    int num_params_;
+};
+
+} //namespace geopter
+
+#endif // RAY_DERIVATIVE_H
@@ -28,8 +28,10 @@
 #define SEQUENTIALPATH_H
 
 #include <vector>
+#include <cstdint>
 
 #include "assembly/surface.h"
+#include "sequential/compiled_sequential_path.h"
 
 namespace geopter {
 
@@ -56,6 +58,13 @@ struct SequentialPathComponent
 };
 
 
+/**
+ * @brief Surfaces of the trace from the object to the image, with the distances and indices at a wavelength
+ *
+ * The path and its compiled copy hold the prescription as it was when the path was built, and are not updated by later edits.
+ * Take the paths from OpticalSystem::GetSequentialPath(), which rebuilds them after edits. The tracer asserts in debug builds
+ * that the path is not older than the last edit of the system.
+ */
 class SequentialPath
 {
 public:
@@ -66,7 +75,7 @@ public:
     int Size() const;
 
     /** Access to path component at the given index */
-    SequentialPathComponent At(int i) const;
+    const SequentialPathComponent& At(int i) const;
 
     /** Returns wavelength used to calculate refractive index */
     double Wavelength() const;
@@ -83,10 +92,18 @@ public:
     /** Set wavelength value used to calculate refractive index */
     void SetWavelength(double wvl);
 
+    /** Flat copy of the path used in the trace loop, built along with Append() */
+    const CompiledSequentialPath& Compiled() const { return compiled_; }
+
+    /** Stamp of RevisionCounter taken when the path was constructed or cleared, before the surfaces were appended */
+    uint64_t Revision() const { return revision_; }
+
 private:
     std::vector<SequentialPathComponent> seq_path_comps_;
+    CompiledSequentialPath compiled_;
     double wvl_;
     int array_size_;
+    uint64_t revision_;
 };
 
 }
@@ -30,7 +30,10 @@
 #include "system/optical_system.h"
 #include "sequential/sequential_path.h"
 #include "sequential/ray.h"
+#include "sequential/ray_bundle.h"
+#include "sequential/ray_derivative.h"
 #include "sequential/trace_error.h"
+#include "sequential/trace_statistics.h"
 
 namespace geopter {
 
@@ -40,14 +43,46 @@ public:
     SequentialTrace(OpticalSystem* sys);
     ~SequentialTrace();
 
-    /** Base function for ray tracing. Trace a ray throughout the given sequantial path */
+    /**
+     * @brief Base function for ray tracing. Trace a ray throughout the given sequantial path
+     *
+     * The path must be current, i.e. built after the last edit of the system, as the paths from OpticalSystem::GetSequentialPath().
+     * A stale path is traced with the old prescription. This is asserted in debug builds, here and in the other traces.
+     */
     TraceError TraceRayThroughoutPath(RayPtr ray, const SequentialPath& seq_path, const Eigen::Vector3d& pt0, const Eigen::Vector3d& dir0);
 
+    /**
+     * @brief Trace a ray along with its derivatives with respect to the given surface parameters
+     *
+     * The derivatives are carried by dual numbers through the same trace loop as TraceRayThroughoutPath(), and
+     * the ray data agree with the ordinary trace up to rounding. The starting point and direction are held fixed,
+     * i.e. the ray aiming is not differentiated.
+     *
+     * @param deriv derivatives of the ray data, one column per parameter
+     */
+    TraceError TraceRayDerivative(RayPtr ray, RayDerivative& deriv, const SequentialPath& seq_path, const Eigen::Vector3d& pt0, const Eigen::Vector3d& dir0,
+                                  const std::vector<TraceParameter>& params);
+
     /** Trace a single ray at the given pupil coordinate */
     TraceError TracePupilRay(RayPtr ray, const SequentialPath& seq_path, const Eigen::Vector2d& pupil_crd, const Field* fld, double wvl);
 
+    /**
+     * @brief Trace all rays in the bundle surface by surface
+     * @param bundle ray bundle whose initial points and directions are already set
+     *        If the bundle is image-only, just the data at the last surface and the total optical path length are kept.
+     * @param seq_path sequential path
+     * @return number of rays reaching the last surface
+     */
+    int TraceBundle(RayBundle& bundle, const SequentialPath& seq_path);
+
+    /** Set up the bundle for the given pupil coordinates and trace it. The storage mode of the bundle is preserved. */
+    int TracePupilBundle(RayBundle& bundle, const SequentialPath& seq_path, const std::vector<Eigen::Vector2d>& pupils, const Field* fld, double wvl);
+
     RayPtr CreatePupilRay(const Eigen::Vector2d& pupil_crd, const Field* fld, double wvl);
 
+    /** Pupil coordinates of a square grid of nrd x nrd samples across the diameter, limited to the unit circle. nrd < 2 gives the center only. */
+    static std::vector<Eigen::Vector2d> GridPupils(int nrd);
+
     /** Trace reference rays(chief, meridional upper/lower, sagittal upper/lower */
     bool TraceReferenceRays(std::vector<std::shared_ptr<Ray>>& ref_rays, const Field* fld, double wvl);
 
@@ -64,8 +99,9 @@ public:
 
     bool AimChiefRay(Eigen::Vector2d& aim_pt, Eigen::Vector3d& obj_pt, const Field* fld, double wvl);
 
-    /**  Refract incoming direction, d_in, about normal */
-    bool Bend(Eigen::Vector3d& d_out, const Eigen::Vector3d& d_in, const Eigen::Vector3d& normal, double n_in, double n_out);
+    /**  Refract incoming direction, d_in, about normal. T is double or DualNumber. */
+    template<typename T>
+    bool Bend(Eigen::Matrix<T,3,1>& d_out, const Eigen::Matrix<T,3,1>& d_in, const Eigen::Matrix<T,3,1>& normal, double n_in, double n_out);
 
     /** Get object coordinate for the given field */
     Eigen::Vector3d GetDefaultObjectPt(const Field* fld);
@@ -76,6 +112,9 @@ public:
     /** Get overall sequential path object from object to image */
     SequentialPath CreateSequentialPath(double wvl);
 
+    /** Get overall sequential path shared through the cache of the optical system */
+    std::shared_ptr<const SequentialPath> GetSequentialPath(double wvl);
+
 
     double ComputeVignettingFactorForPupil(const Eigen::Vector2d& full_pupil, const Field& fld);
 
@@ -87,17 +126,52 @@ public:
     void SetApplyVig(bool state) { do_apply_vig_ = state;}
     bool ApplyVigStatus() const { return do_apply_vig_;}
 
+    /** Statistics recorded by this tracer. Taken from TraceStatisticsScope::Current() on construction, nullptr if disabled. */
+    void SetStatistics(std::shared_ptr<TraceStatistics> stats) { stats_ = stats; }
+    std::shared_ptr<TraceStatistics> Statistics() const { return stats_; }
+
 private:
+    /** @param iterations if not null, Newton iterations are added per surface */
+    TraceError TraceRay(RayPtr ray, const SequentialPath& seq_path, const Eigen::Vector3d& pt0, const Eigen::Vector3d& dir0, long long* iterations);
+
+    /** Trace loop shared by the ordinary and the dual number traces. Surface data are passed to the output. */
+    template<typename T, class Output>
+    TraceError trace_path(const BasicCompiledSurface<T>* path, int path_size, const Eigen::Matrix<T,3,1>& pt0, const Eigen::Matrix<T,3,1>& dir0,
+                          Output& output, long long* iterations);
+
     void ConvertCoordinatePupilToObj(Eigen::Vector3d& pt0, Eigen::Vector3d& dir0, const Eigen::Vector2d& pupil_crd, const Field* fld);
     
     OpticalSystem *opt_sys_;
 
     bool do_aperture_check_;
     bool do_apply_vig_;
+
+    std::shared_ptr<TraceStatistics> stats_;
 };
 
 
+template<typename T>
+bool SequentialTrace::Bend(Eigen::Matrix<T,3,1>& d_out, const Eigen::Matrix<T,3,1>& d_in, const Eigen::Matrix<T,3,1>& normal, double n_in, double n_out)
+{
+    using std::sqrt;
+
+    T normal_len = sqrt(normal.squaredNorm());
+    T cosI = d_in.dot(normal)/normal_len;
+    T sinI_sqr = 1.0 - cosI*cosI;
+
+    T inside_sqrt = n_out*n_out - n_in*n_in*sinI_sqr;
+    if(ScalarValue(inside_sqrt) < 0.0){
+        return false;
+    }
 
+    double cosI_sgn = (ScalarValue(cosI) > 0.0) - (ScalarValue(cosI) < 0.0);
+    //double n_cosIp = sqrt(n_out*n_out - n_in*n_in*sinI_sqr) * cosI_sgn;
+    T n_cosIp = sqrt( inside_sqrt ) * cosI_sgn;
+    T alpha = n_cosIp - n_in*cosI;
+    d_out = (n_in*d_in + alpha*normal)/n_out;
+
+    return true;
+}
 
 }
 
@@ -0,0 +1,215 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#ifndef TRACE_STATISTICS_H
+#define TRACE_STATISTICS_H
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <cstdint>
+#include <unordered_map>
+
+#include "sequential/trace_error.h"
+
+namespace geopter {
+
+class OpticalSystem;
+
+/**
+ * @brief Opt-in counters and stage timers for sequential ray tracing
+ *
+ * Counters are kept per surface of the traced path. Tracers record into the statistics attached to the optical system,
+ * and do nothing else when none is attached. Recording is thread-safe, and each thread accumulates into its own counters
+ * without locking. The readings sum up all threads, so they are complete once the recording threads are joined, e.g. after ParallelFor returns.
+ * Stage times are exclusive: a nested stage pauses the enclosing one on the same thread, e.g. the rays traced while aiming count only to Tracing.
+ * The times are summed over the threads, i.e. they are thread times rather than wall-clock time.
+ */
+class TraceStatistics
+{
+public:
+    enum Stage
+    {
+        PathCreation,
+        Aiming,
+        Tracing,
+        Opd,
+        Fft,
+        NumberOfStages
+    };
+
+    struct SurfaceCounters
+    {
+        long long intersections = 0;
+        long long iterations    = 0;
+        long long tir           = 0;
+        long long missed        = 0;
+        long long blocked       = 0;
+    };
+
+    TraceStatistics();
+    TraceStatistics(const TraceStatistics& other);
+    TraceStatistics& operator=(const TraceStatistics& other);
+    ~TraceStatistics();
+
+    void Clear();
+
+    /**
+     * @brief Record the result of tracing rays through a path
+     * @param status trace result of each ray
+     * @param reached last surface index reached by each ray
+     * @param num_rays number of rays
+     * @param path_size number of surfaces in the path
+     * @param iterations Newton iterations per surface summed over the rays, or nullptr
+     */
+    void RecordTrace(const TraceError* status, const int* reached, int num_rays, int path_size, const long long* iterations);
+
+    void RecordTime(Stage stage, std::chrono::steady_clock::duration elapsed);
+
+    /** Add the counts and times of the other statistics */
+    void Merge(const TraceStatistics& other);
+
+    long long NumberOfRays() const;
+    int NumberOfSurfaces() const;
+    SurfaceCounters Surface(int srf_index) const;
+    SurfaceCounters Total() const;
+
+    /** Accumulated time in milliseconds */
+    double Time(Stage stage) const;
+    long long Calls(Stage stage) const;
+
+    static std::string StageName(Stage stage);
+
+    void Print(std::ostringstream& oss) const;
+    void Print() const;
+
+    /**
+     * @brief Measures the lifetime of the timer as the given stage, excluding the timers nested on the same thread
+     *
+     * Does nothing for null statistics. Timers must be destroyed in the reverse order of creation on each thread, as scoped objects are.
+     */
+    class StageTimer
+    {
+    public:
+        StageTimer(TraceStatistics* stats, Stage stage);
+        ~StageTimer();
+
+        StageTimer(const StageTimer&) = delete;
+        StageTimer& operator=(const StageTimer&) = delete;
+
+    private:
+        TraceStatistics* stats_;
+        Stage stage_;
+        StageTimer* parent_;
+
+        /** start of the current running interval */
+        std::chrono::steady_clock::time_point start_;
+        std::chrono::steady_clock::duration elapsed_;
+
+        /** innermost running timer of the thread */
+        static thread_local StageTimer* active_;
+    };
+
+private:
+    struct Counters
+    {
+        long long num_rays = 0;
+        std::vector<SurfaceCounters> srf_counters;
+        long long stage_ns[NumberOfStages] = {};
+        long long stage_calls[NumberOfStages] = {};
+
+        void Add(const Counters& other);
+    };
+
+    /** Counters of one recording thread. Written by the owner thread only. */
+    struct ThreadCounters : public Counters
+    {
+        /** scratch for RecordTrace */
+        std::vector<long long> last_attempt;
+    };
+
+    /** Counters of the calling thread, registered on first use */
+    ThreadCounters* local_counters();
+
+    /** Sum of all counters. mtx_ must be held. */
+    Counters collect() const;
+
+    mutable std::mutex mtx_;
+
+    /** distinguishes the instances in the per-thread lookup, never reused */
+    uint64_t id_;
+
+    /** counters taken over by copy or Merge() */
+    Counters merged_;
+
+    std::unordered_map< std::thread::id, std::unique_ptr<ThreadCounters> > threads_;
+};
+
+
+/**
+ * @brief Collects the statistics of one analysis run
+ *
+ * While the scope is alive, the tracers created for the system on the same thread record into fresh statistics,
+ * which are merged into the parent on destruction. The parent is the innermost enclosing scope of the same system on this thread,
+ * or the statistics attached to the system. Does nothing when the system has no statistics attached.
+ *
+ * The scopes are kept per thread and never modify the system, so analyses may run at once on the same system.
+ * A scope must be a local variable: nested scopes are closed in the reverse order of opening, on the thread that opened them.
+ * Tracers take the statistics on construction, so tracers used by the tasks of ParallelFor are to be created before the loop.
+ */
+class TraceStatisticsScope
+{
+public:
+    explicit TraceStatisticsScope(OpticalSystem* opt_sys);
+    ~TraceStatisticsScope();
+
+    TraceStatisticsScope(const TraceStatisticsScope&) = delete;
+    TraceStatisticsScope& operator=(const TraceStatisticsScope&) = delete;
+
+    /** Statistics collected in this scope, or nullptr if disabled */
+    std::shared_ptr<TraceStatistics> Statistics() const { return stats_; }
+
+    /** Statistics to record into for the system on the calling thread: the innermost open scope, or the statistics attached to the system */
+    static std::shared_ptr<TraceStatistics> Current(const OpticalSystem* opt_sys);
+
+private:
+    const OpticalSystem* opt_sys_;
+    std::shared_ptr<TraceStatistics> parent_;
+    std::shared_ptr<TraceStatistics> stats_;
+
+    /** enclosing scope on this thread */
+    TraceStatisticsScope* outer_;
+
+    /** innermost open scope of the thread */
+    static thread_local TraceStatisticsScope* innermost_;
+};
+
+} //namespace geopter
+
+#endif // TRACE_STATISTICS_H
@@ -0,0 +1,80 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#ifndef GEOPTER_BEST_FOCUS_SOLVE_H
+#define GEOPTER_BEST_FOCUS_SOLVE_H
+
+#include "solve/solve.h"
+
+namespace geopter {
+
+/**
+ * @brief Image distance solve minimizing RMS spot radius or RMS wavefront error
+ *
+ * The rays are traced once at the current image distance. Beyond the last surface the ray positions depend linearly
+ * on the defocus, so the minimum of the RMS spot is found in closed form. For the RMS wavefront the rays are extended to the moved
+ * image surface with the reference sphere moved along, and the minimum is found by iterating on the defocus without re-tracing.
+ * The solve must be set on the gap in front of the image surface. All wavelengths are used with their weights.
+ * The RMS spot is taken over the rays of all wavelengths about their weighted polychromatic centroid, as MeritOperand::RmsSpot,
+ * so lateral color enters the result. The RMS wavefront is taken in waves about the mean of each wavelength, as MeritOperand::RmsOpd.
+ */
+class BestFocusSolve : public Solve
+{
+public:
+    enum Criterion
+    {
+        RmsSpot,
+        RmsWavefront
+    };
+
+    BestFocusSolve();
+    BestFocusSolve(int gi, int criterion, int field_index, int nrd);
+    bool Check(const OpticalSystem* opt_sys) override;
+    void Apply(OpticalSystem* opt_sys) override;
+    std::unique_ptr<Solve> Clone() const override { return std::make_unique<BestFocusSolve>(*this); }
+    int GetSolveType() const override { return SolveType::BestFocus; }
+    std::string GetSolveTypeStr() const override { return "F"; }
+
+    /**
+     * @param param1 criterion (RmsSpot or RmsWavefront)
+     * @param param2 field index
+     * @param param3 number of pupil samples across the diameter
+     */
+    void SetParameters(double param1, double param2, double param3, double param4) override;
+    void GetParameters(double *param1=nullptr, double *param2=nullptr, double *param3=nullptr, double *param4=nullptr) override;
+
+    /** Defocus from the image distance before the last Apply() to the best focus */
+    double LastDefocus() const { return last_defocus_; }
+
+private:
+    int criterion_;
+    int field_index_;
+    int nrd_;
+    double last_defocus_;
+};
+
+}
+
+#endif //GEOPTER_BEST_FOCUS_SOLVE_H
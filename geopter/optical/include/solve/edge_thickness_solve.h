@@ -28,6 +28,7 @@ public:
     EdgeThicknessSolve(int gap_index, double thickness, double radial_height);
     bool Check(const OpticalSystem* opt_sys) override;
     void Apply(OpticalSystem* opt_sys) override;
+    std::unique_ptr<Solve> Clone() const override { return std::make_unique<EdgeThicknessSolve>(*this); }
     int GetSolveType() const override { return Solve::EdgeThickness; }
     std::string GetSolveTypeStr() const override { return "E"; }
     void SetParameters(double param1, double param2, double param3, double param4) override;
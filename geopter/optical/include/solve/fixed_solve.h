@@ -28,6 +28,7 @@ public:
     }
     bool Check(const OpticalSystem* /*opt_sys*/) override{ return true;}
     void Apply(OpticalSystem* /*opt_sys*/) override{}
+    std::unique_ptr<Solve> Clone() const override { return std::make_unique<FixedSolve>(*this); }
     int GetSolveType() const override { return 0; }
     void SetParameters(double /*param1*/, double /*param2*/, double /*param3=0.0*/, double /*param4=0.0*/) override{}
     void GetParameters(double *param1, double *param2, double *param3, double *param4) override{
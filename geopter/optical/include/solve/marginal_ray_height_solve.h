@@ -26,6 +26,7 @@ public:
     MarginalHeightSolve(int gi, double value, double zone);
     bool Check(const OpticalSystem* opt_sys) override;
     void Apply(OpticalSystem* opt_sys) override;
+    std::unique_ptr<Solve> Clone() const override { return std::make_unique<MarginalHeightSolve>(*this); }
     int GetSolveType() const override { return SolveType::MarginalHeight; }
     std::string GetSolveTypeStr() const override { return "M"; }
     void SetParameters(double param1, double param2, double param3, double param4) override;
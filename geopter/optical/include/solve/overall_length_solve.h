@@ -37,6 +37,7 @@ public:
     OverallLengthSolve(int gi, double value, int s1, int s2);
     bool Check(const OpticalSystem* opt_sys) override;
     void Apply(OpticalSystem* opt_sys) override;
+    std::unique_ptr<Solve> Clone() const override { return std::make_unique<OverallLengthSolve>(*this); }
     int GetSolveType() const override { return SolveType::OverallLength;}
     std::string GetSolveTypeStr() const override{ return "O";}
     void SetParameters(double param1, double param2, double param3, double param4) override;
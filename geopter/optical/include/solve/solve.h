@@ -28,6 +28,7 @@
 #define GEOPTER_SOLVE_H
 
 #include <string>
+#include <memory>
 
 namespace geopter{
 
@@ -42,10 +43,11 @@ public:
         Fixed,
         EdgeThickness,
         OverallLength,
-        MarginalHeight
+        MarginalHeight,
+        BestFocus
     };
 
-    Solve(){solve_type_ = -1;}
+    Solve(){solve_type_ = -1; gap_index_ = -1;}
     virtual ~Solve(){};
 
     /** Check parameters */
@@ -54,6 +56,9 @@ public:
     /** Apply solved value to the system */
     virtual void Apply(OpticalSystem* opt_sys) = 0;
 
+    /** Returns a copy of the solve with the same type and parameters */
+    virtual std::unique_ptr<Solve> Clone() const = 0;
+
     /** Returns solve type as integer. If -1, no valid solve is set */
     virtual int GetSolveType() const{return -1;}
 
@@ -74,6 +74,9 @@ public:
 
     void clear();
 
+    /** Replace the fields by copies of the given spec */
+    void CopyFrom(const FieldSpec& other);
+
     void print();
     void print(std::ostringstream& oss);
 
@@ -48,6 +48,9 @@ public:
 
     void Clear();
 
+    /** Replace pupil, fields and wavelengths by copies of the given spec */
+    void CopyFrom(const OpticalSpec& other);
+
     void CreateMinimumSpec();
 
     void update();
@@ -77,6 +77,9 @@ public:
 
     void clear();
 
+    /** Replace the wavelengths by copies of the given spec */
+    void CopyFrom(const WavelengthSpec& other);
+
     void print();
     void print(std::ostringstream& oss);
 
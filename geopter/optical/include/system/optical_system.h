@@ -32,8 +32,11 @@
 #include <sstream>
 #include <vector>
 #include <map>
+#include <mutex>
 #include <cassert>
 
+#include "nlohmann/json_fwd.hpp"
+
 #include "spec/optical_spec.h"
 #include "assembly/optical_assembly.h"
 #include "material/material_library.h"
@@ -41,6 +44,9 @@
 
 namespace geopter {
 
+class SequentialPath;
+class TraceStatistics;
+
 enum ReferenceRay{
     ChiefRay,
     MeridionalUpperRay,
@@ -57,6 +63,16 @@ public:
 
     void Initialize();
 
+    /**
+     * @brief Returns an independent copy of the system for concurrent use
+     *
+     * The prescription, solves and specifications are copied, while the materials and the glass catalogs are shared.
+     * The copy is already updated, so it can be traced without calling UpdateModel(). It starts with an empty path cache
+     * and records into the same trace statistics as the original.
+     * The original must not be edited while it is being cloned.
+     */
+    std::unique_ptr<OpticalSystem> Clone() const;
+
     /** Returns the title of the system */
     std::string Title() const { return title_; }
 
@@ -76,6 +92,12 @@ public:
     void LoadFile(const std::string& filepath);
     void SaveToFile(const std::string& filepath);
 
+    /** Prescription and specifications in the lens file format */
+    nlohmann::json ToJson() const;
+
+    /** Replace the system by the given lens file data and update the model */
+    void FromJson(nlohmann::json json_data);
+
     void SetTitle(std::string title) { title_ = title; }
     void SetNote(std::string note) { note_ = note;}
 
@@ -85,6 +107,28 @@ public:
 
     void UpdateModel();
 
+    /**
+     * @brief Returns the whole sequential path at the given wavelength
+     *
+     * Paths are cached per wavelength and rebuilt on the next request after any edit of the surfaces, gaps,
+     * materials or environment. The returned path stays alive while it is held, but its surface pointers
+     * are only valid as long as the assembly is not restructured.
+     */
+    std::shared_ptr<const SequentialPath> GetSequentialPath(double wvl);
+
+    /** Stamp of the last edit of the surfaces, gaps, materials or environment, against which the sequential paths are checked */
+    uint64_t Revision() const;
+
+    /**
+     * @brief Attach the statistics recorded by the tracers created for this system. nullptr disables recording.
+     *
+     * The pointer is read and written atomically, so it may be changed while the system is traced.
+     * Tracers keep the statistics they took on construction. Analyses collect into their own statistics through TraceStatisticsScope,
+     * which does not change the attached ones.
+     */
+    void SetTraceStatistics(std::shared_ptr<TraceStatistics> stats) { std::atomic_store(&trace_stats_, stats); }
+    std::shared_ptr<TraceStatistics> GetTraceStatistics() const { return std::atomic_load(&trace_stats_); }
+
     void Clear();
 
     void Print(std::ostringstream& oss);
@@ -98,6 +142,18 @@ protected:
 
     std::string title_;
     std::string note_;
+
+private:
+    struct CachedPath
+    {
+        uint64_t revision;
+        std::shared_ptr<const SequentialPath> path;
+    };
+
+    std::map<double, CachedPath> path_cache_;
+    std::mutex path_cache_mtx_;
+
+    std::shared_ptr<TraceStatistics> trace_stats_;
 };
 
 
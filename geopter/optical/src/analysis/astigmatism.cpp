@@ -42,6 +42,8 @@ Astigmatism::Astigmatism(OpticalSystem* opt_sys):
 
 std::shared_ptr<PlotData> Astigmatism::plot(int num_rays)
 {
+    TraceStatisticsScope stats_scope(opt_sys_);
+
     const int num_srfs = opt_sys_->GetOpticalAssembly()->NumberOfSurfaces();
     const int num_wvls = opt_sys_->GetOpticalSpec()->GetWavelengthSpec()->NumberOfWavelengths();
     const double maxfld = opt_sys_->GetOpticalSpec()->GetFieldSpec()->MaxField();
@@ -63,8 +65,6 @@ std::shared_ptr<PlotData> Astigmatism::plot(int num_rays)
     tmp_flds.reserve(num_rays);
     ys.reserve(num_rays);
 
-    SequentialPath seq_path = tracer->CreateSequentialPath(ref_wvl_val_);
-
     Eigen::Vector2d aim_pt({0.0, 0.0});
     Eigen::Vector3d obj_pt;
 
@@ -100,7 +100,9 @@ std::shared_ptr<PlotData> Astigmatism::plot(int num_rays)
         double wvl = opt_sys_->GetOpticalSpec()->GetWavelengthSpec()->GetWavelength(wi)->Value();
         Rgb color = opt_sys_->GetOpticalSpec()->GetWavelengthSpec()->GetWavelength(wi)->RenderColor();
 
-        SequentialPath seq_path = tracer->CreateSequentialPath(wvl);
+        auto seq_path_ptr = tracer->GetSequentialPath(wvl);
+
+        const SequentialPath& seq_path = *seq_path_ptr;
 
         std::vector<double> fy;
         std::vector<double> xfo;
@@ -143,5 +145,6 @@ std::shared_ptr<PlotData> Astigmatism::plot(int num_rays)
 
     delete tracer;
 
+    plot_data->SetTraceStatistics(stats_scope.Statistics());
     return plot_data;
 }
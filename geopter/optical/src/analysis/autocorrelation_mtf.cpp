@@ -0,0 +1,207 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include <iostream>
+#include <numeric>
+
+#include "analysis/autocorrelation_mtf.h"
+#include "analysis/wavefront.h"
+#include "sequential/sequential_trace.h"
+#include "renderer/renderer.h"
+#include "common/thread_pool.h"
+
+using namespace geopter;
+
+namespace {
+
+/** Unnormalized autocorrelation of the pupil function for a shear of k samples along rows (tangential) or columns (sagittal) */
+std::complex<double> PupilAutocorrelation(const Eigen::MatrixXcd& p, int k, bool tangential)
+{
+    const int n = p.rows();
+    if(k >= n){
+        return 0.0;
+    }
+
+    if(tangential){
+        return (p.bottomRows(n - k).array() * p.topRows(n - k).array().conjugate()).sum();
+    }else{
+        return (p.rightCols(n - k).array() * p.leftCols(n - k).array().conjugate()).sum();
+    }
+}
+
+}
+
+AutocorrelationMTF::AutocorrelationMTF(OpticalSystem *opt_sys) :
+    opt_sys_(opt_sys)
+{
+
+}
+
+void AutocorrelationMTF::ComputeOtf(const Field *fld, double wvl, const std::vector<double> &freqs, int pupil_samples, std::vector<std::complex<double> > &otf_tan, std::vector<std::complex<double> > &otf_sag)
+{
+    const int P = pupil_samples;
+    const int num_freqs = freqs.size();
+
+    otf_tan.assign(num_freqs, 0.0);
+    otf_sag.assign(num_freqs, 0.0);
+
+    WavefrontMap wfm(opt_sys_);
+    PupilFunction pf;
+    if( !wfm.CreatePupilFunction(fld, wvl, P, pf) ){
+        return;
+    }
+
+    const double otf0 = pf.values.squaredNorm();
+    if(otf0 <= 0.0){
+        return;
+    }
+
+    // shear in samples for each frequency
+    std::vector<double> shears(num_freqs);
+    for(int fk = 0; fk < num_freqs; fk++){
+        shears[fk] = pf.wavelength*pf.distance*std::abs(freqs[fk])/pf.sample_step;
+    }
+
+    // whole-sample shears used by the interpolation, each computed once
+    std::vector<int> needed(P + 1, 0);
+    for(double s : shears){
+        const int k = static_cast<int>(s);
+        if(k < P){
+            needed[k] = 1;
+            needed[k + 1] = 1;
+        }
+    }
+
+    std::vector<int> ks;
+    for(int k = 0; k <= P; k++){
+        if(needed[k]){
+            ks.push_back(k);
+        }
+    }
+
+    std::vector< std::complex<double> > acf_tan(P + 1, 0.0), acf_sag(P + 1, 0.0);
+    ThreadPool::Global()->ParallelFor(ks.size(), [&](int idx){
+        const int k = ks[idx];
+        acf_tan[k] = PupilAutocorrelation(pf.values, k, true)/otf0;
+        acf_sag[k] = PupilAutocorrelation(pf.values, k, false)/otf0;
+    });
+
+    for(int fk = 0; fk < num_freqs; fk++){
+        const int k = static_cast<int>(shears[fk]);
+        if(k >= P){
+            continue;
+        }
+        const double t = shears[fk] - static_cast<double>(k);
+        otf_tan[fk] = (1.0 - t)*acf_tan[k] + t*acf_tan[k + 1];
+        otf_sag[fk] = (1.0 - t)*acf_sag[k] + t*acf_sag[k + 1];
+    }
+}
+
+void AutocorrelationMTF::Compute(const Field *fld, const std::vector<double> &freqs, int pupil_samples, std::vector<double> &mtf_tan, std::vector<double> &mtf_sag)
+{
+    const int num_freqs = freqs.size();
+    const int num_wvls = opt_sys_->GetOpticalSpec()->GetWavelengthSpec()->NumberOfWavelengths();
+    std::vector<double> wvl_list = opt_sys_->GetOpticalSpec()->GetWavelengthSpec()->GetWavelengthList();
+    std::vector<double> wt_list = opt_sys_->GetOpticalSpec()->GetWavelengthSpec()->GetWeightList();
+
+    const double sum_wt = std::accumulate(wt_list.begin(), wt_list.end(), 0.0);
+
+    std::vector< std::complex<double> > poly_tan(num_freqs, 0.0), poly_sag(num_freqs, 0.0);
+    std::vector< std::complex<double> > otf_tan, otf_sag;
+
+    for(int wi = 0; wi < num_wvls; wi++){
+        ComputeOtf(fld, wvl_list[wi], freqs, pupil_samples, otf_tan, otf_sag);
+        for(int fk = 0; fk < num_freqs; fk++){
+            poly_tan[fk] += wt_list[wi]*otf_tan[fk];
+            poly_sag[fk] += wt_list[wi]*otf_sag[fk];
+        }
+    }
+
+    mtf_tan.resize(num_freqs);
+    mtf_sag.resize(num_freqs);
+    for(int fk = 0; fk < num_freqs; fk++){
+        mtf_tan[fk] = std::abs(poly_tan[fk])/sum_wt;
+        mtf_sag[fk] = std::abs(poly_sag[fk])/sum_wt;
+    }
+}
+
+std::shared_ptr<PlotData> AutocorrelationMTF::plot(int pupil_samples, double max_freq, double freq_step)
+{
+    TraceStatisticsScope stats_scope(opt_sys_);
+
+    auto plot_data = std::make_shared<PlotData>();
+    plot_data->SetPlotStyle(Renderer::PlotStyle::Curve);
+    plot_data->SetTitle("Diffraction MTF");
+    plot_data->SetXLabel("Spatial Frequency");
+    plot_data->SetYLabel("MTF");
+
+    if(freq_step <= 0.0){
+        std::cerr << "Frequency step must be positive" << std::endl;
+        return plot_data;
+    }
+    if(pupil_samples < 2){
+        std::cerr << "Pupil samples must be at least 2" << std::endl;
+        return plot_data;
+    }
+
+    const int num_flds = opt_sys_->GetOpticalSpec()->GetFieldSpec()->NumberOfFields();
+
+    std::vector<double> freqs;
+    {
+        double freq = 0.0;
+        while(freq < max_freq){
+            freqs.push_back(freq);
+            freq += freq_step;
+        }
+    }
+
+    std::vector<double> mtf_tan, mtf_sag;
+
+    for(int fi = 0; fi < num_flds; fi++){
+        Field* fld = opt_sys_->GetOpticalSpec()->GetFieldSpec()->GetField(fi);
+
+        this->Compute(fld, freqs, pupil_samples, mtf_tan, mtf_sag);
+
+        auto graph_sag = std::make_shared<Graph2d>();
+        graph_sag->SetData(freqs, mtf_sag);
+        graph_sag->SetLineStyle(Renderer::LineStyle::Solid);
+        graph_sag->SetRenderColor(fld->RenderColor());
+        graph_sag->SetName("F" + std::to_string(fi) + "_S");
+
+        auto graph_tan = std::make_shared<Graph2d>();
+        graph_tan->SetData(freqs, mtf_tan);
+        graph_tan->SetLineStyle(Renderer::LineStyle::Dots);
+        graph_tan->SetRenderColor(fld->RenderColor());
+        graph_tan->SetName("F" + std::to_string(fi) + "_T");
+
+        plot_data->AddGraph(graph_sag);
+        plot_data->AddGraph(graph_tan);
+    }
+
+    plot_data->SetTraceStatistics(stats_scope.Statistics());
+    return plot_data;
+}
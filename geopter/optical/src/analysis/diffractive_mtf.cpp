@@ -3,6 +3,8 @@
 #include "analysis/diffractive_psf.h"
 #include "common/circ_shift.h"
 #include "common/matrix_tool.h"
+#include "common/fft_engine.h"
+#include "sequential/trace_statistics.h"
 #include "renderer/renderer.h"
 
 using namespace geopter;
@@ -15,6 +17,8 @@ DiffractiveMTF::DiffractiveMTF(OpticalSystem *opt_sys) :
 
 std::shared_ptr<PlotData> DiffractiveMTF::plot(OpticalSystem* opt_sys, int M)
 {
+    TraceStatisticsScope stats_scope(opt_sys);
+
     const int num_flds = opt_sys->GetOpticalSpec()->GetFieldSpec()->NumberOfFields();
     const int num_wvls = opt_sys->GetOpticalSpec()->GetWavelengthSpec()->NumberOfWavelengths();
     std::vector<double> wvl_list = opt_sys->GetOpticalSpec()->GetWavelengthSpec()->GetWavelengthList();
@@ -61,9 +65,8 @@ std::shared_ptr<PlotData> DiffractiveMTF::plot(OpticalSystem* opt_sys, int M)
 
         //Eigen::MatrixXcd psf2_c = (psf.array().pow(2)). template cast<std::complex<double>>();
 
-        Eigen::MatrixXcd temp = Eigen::MatrixXcd::Zero(2*M, 2*M);
-        //temp.block(M, M,M,M) = psf2_c;
-        temp.block(M, M,M,M) = (psf.array().pow(2)). template cast<std::complex<double>>();
+        Eigen::MatrixXd temp = Eigen::MatrixXd::Zero(2*M, 2*M);
+        temp.block(M, M,M,M) = psf.array().pow(2);
 
         //Eigen::MatrixXcd temp1 = fftshift(temp);
         //Eigen::MatrixXcd temp2 = MatrixTool::fft2(fftshift(temp));
@@ -72,21 +75,31 @@ std::shared_ptr<PlotData> DiffractiveMTF::plot(OpticalSystem* opt_sys, int M)
         //double mtf0 = temp3(0,0);
         //Eigen::MatrixXd mtf = temp3.array()/mtf0;
 
-        Eigen::MatrixXd mtf = (MatrixTool::fft2(fftshift(temp))).array().abs();
-        double mtf0 = mtf(0,0);
-        mtf = mtf.array()/mtf0;
+        // the input is real, so the half spectrum is enough for the first row and column
+        Eigen::MatrixXcd spectrum;
+        {
+            TraceStatistics::StageTimer timer(stats_scope.Statistics().get(), TraceStatistics::Fft);
+            FftEngine::ForwardReal(spectrum, fftshift(temp));
+        }
+
+        const double mtf0 = std::abs(spectrum(0,0));
+        Eigen::VectorXd mtf_sag = spectrum.row(0).transpose().cwiseAbs()/mtf0;
+        Eigen::VectorXd mtf_tan(2*M);
+        for(int i = 0; i < 2*M; i++){
+            mtf_tan(i) = std::abs(spectrum(std::min(i, 2*M - i), 0))/mtf0;
+        }
 
         //std::vector<double> mtf_tan = MatrixTool::to_std_vector(mtf.col(0));
         //std::vector<double> mtf_sag = MatrixTool::to_std_vector(mtf.row(0));
 
         auto graph_sag = std::make_shared<Graph2d>();
-        graph_sag->SetData(fu,MatrixTool::to_std_vector(mtf.row(0)));
+        graph_sag->SetData(fu,MatrixTool::to_std_vector(mtf_sag));
         graph_sag->SetLineStyle(Renderer::LineStyle::Solid);
         graph_sag->SetRenderColor(fld->RenderColor());
         graph_sag->SetName("MTF_S F" + std::to_string(fi));
 
         auto graph_tan = std::make_shared<Graph2d>();
-        graph_tan->SetData(fu,MatrixTool::to_std_vector(mtf.col(0)));
+        graph_tan->SetData(fu,MatrixTool::to_std_vector(mtf_tan));
         graph_tan->SetLineStyle(Renderer::LineStyle::Dots);
         graph_tan->SetRenderColor(fld->RenderColor());
         graph_tan->SetName("MTF_T F" + std::to_string(fi));
@@ -99,6 +112,7 @@ std::shared_ptr<PlotData> DiffractiveMTF::plot(OpticalSystem* opt_sys, int M)
     delete psf_analyzer;
 
 
+    plot_data->SetTraceStatistics(stats_scope.Statistics());
     return plot_data;
 }
 
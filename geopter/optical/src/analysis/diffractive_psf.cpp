@@ -10,6 +10,7 @@
 #include "sequential/sequential_trace.h"
 #include "sequential/trace_error.h"
 #include "common/matrix_tool.h"
+#include "common/fft_engine.h"
 #include "common/circ_shift.h"
 
 using namespace geopter;
@@ -27,6 +28,8 @@ Eigen::MatrixXd &DiffractivePSF::ConvertToMatrix()
 
 std::shared_ptr<DataGrid> DiffractivePSF::Create(const Field *fld, double wvl, int ndim)
 {
+    TraceStatisticsScope stats_scope(opt_sys_);
+
     WavefrontMap *wfm = new WavefrontMap(opt_sys_);
 
     auto wf_grid = wfm->Create(fld,wvl,ndim);
@@ -51,7 +54,12 @@ std::shared_ptr<DataGrid> DiffractivePSF::Create(const Field *fld, double wvl, i
     double k = M_PI;
     Eigen::MatrixXcd H = O.array() * ((-k*im*O).array().exp());
     //Eigen::MatrixXcd H = O;
-    Eigen::MatrixXd psf = ((fftshift( MatrixTool::fft2(ifftshift(H)).matrix() )).array().abs() ).block(ndim/2, ndim/2, ndim, ndim) ;
+    Eigen::MatrixXcd spectrum = ifftshift(H);
+    {
+        TraceStatistics::StageTimer timer(stats_scope.Statistics().get(), TraceStatistics::Fft);
+        FftEngine::Forward(spectrum);
+    }
+    Eigen::MatrixXd psf = ((fftshift(spectrum)).array().abs() ).block(ndim/2, ndim/2, ndim, ndim) ;
     //Eigen::MatrixXd psf = ((fftshift( MatrixTool::fft2(ifftshift(O)).matrix() )).array().abs() ).block(ndim/2, ndim/2, ndim, ndim);
 
     psf /= psf.array().maxCoeff();
@@ -59,10 +67,60 @@ std::shared_ptr<DataGrid> DiffractivePSF::Create(const Field *fld, double wvl, i
     auto psf_grid = std::make_shared<DataGrid>(2*ndim, 2*ndim, 1.0, 1.0);
     psf_grid->SetValueMatrix(psf);
 
+    psf_grid->SetTraceStatistics(stats_scope.Statistics());
     return psf_grid;
 
 }
 
+std::shared_ptr<DataGrid> DiffractivePSF::CreateByMft(const Field *fld, double wvl, int pupil_samples, int image_samples, double pixel_pitch)
+{
+    TraceStatisticsScope stats_scope(opt_sys_);
+
+    const int P = pupil_samples;
+    const int N = image_samples;
+
+    if(N < 1){
+        std::cerr << "Image samples must be at least 1" << std::endl;
+        return nullptr;
+    }
+
+    WavefrontMap wfm(opt_sys_);
+    PupilFunction pf;
+    if( !wfm.CreatePupilFunction(fld, wvl, P, pf) ){
+        return nullptr;
+    }
+
+    // E = Ky * p * Kx^T, where K(m,j) = exp(-i*2pi*x_m*xi_j/(lambda*R))
+    const double scale = -2.0*M_PI/(pf.wavelength*pf.distance);
+
+    Eigen::MatrixXcd K(N, P);
+    for(int m = 0; m < N; m++){
+        const double x = static_cast<double>(m - N/2)*pixel_pitch;
+        for(int j = 0; j < P; j++){
+            const double xi = -pf.radius + static_cast<double>(j)*pf.sample_step;
+            K(m,j) = std::polar(1.0, scale*x*xi);
+        }
+    }
+
+    Eigen::MatrixXcd E;
+    {
+        TraceStatistics::StageTimer timer(stats_scope.Statistics().get(), TraceStatistics::Fft);
+        E = K * pf.values * K.transpose();
+    }
+
+    psf_ = E.cwiseAbs2();
+    if(pf.num_valid > 0){
+        const double num_valid = static_cast<double>(pf.num_valid);
+        psf_ /= num_valid*num_valid;
+    }
+
+    auto psf_grid = std::make_shared<DataGrid>(N, N, pixel_pitch, pixel_pitch);
+    psf_grid->SetValueMatrix(psf_);
+
+    psf_grid->SetTraceStatistics(stats_scope.Statistics());
+    return psf_grid;
+}
+
 void DiffractivePSF::CreateFromOpdTrace(OpticalSystem* opt_sys, const Field* fld, double wvl, int M, double L)
 {
     /*
@@ -74,7 +132,9 @@ void DiffractivePSF::CreateFromOpdTrace(OpticalSystem* opt_sys, const Field* fld
     tracer->SetApertureCheck(true);
     tracer->SetApplyVig(false);
 
-    SequentialPath seq_path = tracer->CreateSequentialPath(wvl);
+    auto seq_path_ptr = tracer->GetSequentialPath(wvl);
+
+    const SequentialPath& seq_path = *seq_path_ptr;
 
     auto chief_ray = std::make_shared<Ray>();
     chief_ray->Allocate(seq_path.Size());
@@ -106,30 +166,41 @@ void DiffractivePSF::CreateFromOpdTrace(OpticalSystem* opt_sys, const Field* fld
 
     W_ = Eigen::MatrixXd::Zero(M, M);
     Eigen::MatrixXcd A = Eigen::MatrixXcd::Zero(M, M);
-    Eigen::Vector2d pupil;
-    RayPtr ray = std::make_shared<Ray>(seq_path.Size());
+
+    const WavefrontContext ctx = create_wavefront_context(chief_ray, wvl);
+
+    // each row is traced as one bundle
+    std::vector<Eigen::Vector2d> pupils;
+    std::vector<int> cols;
+    std::vector<double> opds;
+    RayBundle bundle;
 
     for(int i = 0; i < M; i++){
-        for(int j = 0; j < M; j++){
-            pupil(0) = fu[j] * lz/wxp;
-            pupil(1) = fv[i] * lz/wxp;
+        pupils.clear();
+        cols.clear();
 
+        for(int j = 0; j < M; j++){
+            Eigen::Vector2d pupil(fu[j] * lz/wxp, fv[i] * lz/wxp);
             if(pupil.norm() <= 1.0){
-                tracer->TracePupilRay(ray, seq_path, pupil, fld, wvl);
-
-                if(ray->Status() == TRACE_SUCCESS){
-                    double opd = wave_abr_full_calc(ray, chief_ray);
-                    W_(i,j) = opd;
-                    A(i,j) = 1.0;
-                }else{
-                    W_(i,j) = 0.0;
-                    A(i,j) = 0.0;
-                }
-            }else{
-                W_(i,j) = 0.0;
-                A(i,j) = 0.0;
+                pupils.push_back(pupil);
+                cols.push_back(j);
             }
+        }
+
+        if(pupils.empty()){
+            continue;
+        }
 
+        tracer->TracePupilBundle(bundle, seq_path, pupils, fld, wvl);
+
+        opds.resize(pupils.size());
+        wave_abr_full_calc(ctx, bundle, opds.data());
+
+        for(size_t k = 0; k < cols.size(); k++){
+            if(bundle.Status(k) == TRACE_SUCCESS){
+                W_(i,cols[k]) = opds[k];
+                A(i,cols[k]) = 1.0;
+            }
         }
     }
 
@@ -146,7 +217,12 @@ void DiffractivePSF::CreateFromOpdTrace(OpticalSystem* opt_sys, const Field* fld
     //Eigen::MatrixXcd psf3 = fftshift(psf2);
     //Eigen::MatrixXcd psf3 = fftshift( MatrixTool::fft2(ifftshift(H)).matrix() );
     //psf_ = psf3.array().abs();
-    psf_ = (fftshift( MatrixTool::fft2(ifftshift(H)).matrix() )).array().abs();
+    Eigen::MatrixXcd spectrum = ifftshift(H);
+    {
+        TraceStatistics::StageTimer timer(TraceStatisticsScope::Current(opt_sys).get(), TraceStatistics::Fft);
+        FftEngine::Forward(spectrum);
+    }
+    psf_ = (fftshift(spectrum)).array().abs();
 
 }
 
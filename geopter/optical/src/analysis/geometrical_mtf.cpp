@@ -1,9 +1,12 @@
 #define _USE_MATH_DEFINES
 #include <cmath>
+#include <complex>
+#include <algorithm>
 
 #include "analysis/geometrical_mtf.h"
 #include "sequential/sequential_trace.h"
 #include "renderer/renderer.h"
+#include "common/thread_pool.h"
 
 
 namespace  {
@@ -34,13 +37,17 @@ double CalculateGeometricalMtf(double s, double t, const std::vector<double>& x,
 
 using namespace geopter;
 
-GeometricalMTF::GeometricalMTF()
+GeometricalMTF::GeometricalMTF() :
+    method_(Method::Histogram),
+    bins_per_cycle_(16)
 {
 
 }
 
 std::shared_ptr<PlotData> GeometricalMTF::plot(OpticalSystem* opt_sys, int nrd, double max_freq, double freq_step)
 {
+    TraceStatisticsScope stats_scope(opt_sys);
+
 
     /*
      * 1. spot data
@@ -72,19 +79,26 @@ std::shared_ptr<PlotData> GeometricalMTF::plot(OpticalSystem* opt_sys, int nrd,
     tracer->SetApertureCheck(true);
     tracer->SetApplyVig(false);
 
-    std::vector<SequentialPath> seq_paths;
+    std::vector< std::shared_ptr<const SequentialPath> > seq_paths;
     for (int wi = 0; wi < num_wvls; wi++){
         double wvl = opt_sys->GetOpticalSpec()->GetWavelengthSpec()->GetWavelength(wi)->Value();
-        seq_paths.emplace_back(tracer->CreateSequentialPath(wvl));
+        seq_paths.emplace_back(tracer->GetSequentialPath(wvl));
     }
 
     const int ref_wvl_idx = opt_sys->GetOpticalSpec()->GetWavelengthSpec()->ReferenceIndex();
     const double ref_wvl_val = opt_sys->GetOpticalSpec()->GetWavelengthSpec()->ReferenceWavelength();
-    const SequentialPath ref_seq_path = seq_paths[ref_wvl_idx];
+    const SequentialPath& ref_seq_path = *seq_paths[ref_wvl_idx];
 
 
     auto chief_ray = std::make_shared<Ray>( opt_sys->GetOpticalAssembly()->NumberOfSurfaces() );
-    auto ray = std::make_shared<Ray>(opt_sys->GetOpticalAssembly()->NumberOfSurfaces());
+
+    // pupil grid, common to all fields and wavelengths
+    const std::vector<Eigen::Vector2d> pupils = SequentialTrace::GridPupils(nrd);
+
+    constexpr int rays_per_tile = 1024;
+    const int num_rays  = pupils.size();
+    const int num_tiles = (num_rays + rays_per_tile - 1)/rays_per_tile;
+    const int img = ref_seq_path.Size() - 1;
 
     for(int fi = 0; fi < num_flds; fi++){
         Field* fld = opt_sys->GetOpticalSpec()->GetFieldSpec()->GetField(fi);
@@ -102,52 +116,54 @@ std::shared_ptr<PlotData> GeometricalMTF::plot(OpticalSystem* opt_sys, int nrd,
         us.clear();
         vs.clear();
 
-        us.reserve(nrd*nrd);
-        vs.reserve(nrd*nrd);
+        us.reserve(num_wvls*num_rays);
+        vs.reserve(num_wvls*num_rays);
 
-        Eigen::Vector2d pupil;
-        const double step = 2.0/static_cast<double>(nrd-1);
+        std::vector<double> tile_us(num_rays), tile_vs(num_rays);
+        std::vector<char> passed(num_rays);
 
         for(int wi = 0; wi < num_wvls; wi++){
             double wvl = opt_sys->GetOpticalSpec()->GetWavelengthSpec()->GetWavelength(wi)->Value();
 
-            for (int pi = 0; pi < nrd; pi++){
-                for(int pj = 0; pj < nrd; pj++){
-                    pupil(0) = -1.0 + static_cast<double>(pj)*step;
-                    pupil(1) = -1.0 + static_cast<double>(pi)*step;
+            std::fill(passed.begin(), passed.end(), 0);
 
-                    if(pupil.norm() <= 1.00){
-                        ray->SetStatus(TRACE_SUCCESS);
-                        if(TRACE_SUCCESS == tracer->TracePupilRay(ray,seq_paths[wi], pupil, fld, wvl)){
-                            double ray_x = ray->GetBack()->X();
-                            double ray_y = ray->GetBack()->Y();
+            ThreadPool::Global()->ParallelFor(num_tiles, [&](int ti){
+                const int begin = ti*rays_per_tile;
+                const int end   = std::min(num_rays, begin + rays_per_tile);
+                std::vector<Eigen::Vector2d> tile_pupils(pupils.begin() + begin, pupils.begin() + end);
 
-                            double dx = ray_x - chief_ray_x;
-                            double dy = ray_y - chief_ray_y;
+                RayBundle bundle(end - begin, seq_paths[wi]->Size(), true);
+                tracer->TracePupilBundle(bundle, *seq_paths[wi], tile_pupils, fld, wvl);
 
-                            us.push_back(dx);
-                            vs.push_back(dy);
-                        }
+                for(int ri = 0; ri < end - begin; ri++){
+                    if(TRACE_SUCCESS == bundle.Status(ri)){
+                        tile_us[begin + ri] = bundle.X(ri, img) - chief_ray_x;
+                        tile_vs[begin + ri] = bundle.Y(ri, img) - chief_ray_y;
+                        passed[begin + ri]  = 1;
                     }
                 }
+            });
 
-
+            for(int k = 0; k < num_rays; k++){
+                if(passed[k]){
+                    us.push_back(tile_us[k]);
+                    vs.push_back(tile_vs[k]);
+                }
             }
-
-
-
         }
 
         std::vector<double> mtf_tan_list(num_freqs, 0.0);
         std::vector<double> mtf_sag_list(num_freqs, 0.0);
 
-        for(int fk=0; fk < num_freqs; fk++){
-            double freq = freqs[fk];
-            double mtf_sag = CalculateGeometricalMtf(freq, 0.0, us, vs);
-            double mtf_tan = CalculateGeometricalMtf(0.0, freq, us, vs);
-
-            mtf_sag_list[fk] = mtf_sag;
-            mtf_tan_list[fk] = mtf_tan;
+        if(Method::Histogram == method_){
+            mtf_sag_list = LineSpreadMtf(freqs, us, bins_per_cycle_);
+            mtf_tan_list = LineSpreadMtf(freqs, vs, bins_per_cycle_);
+        }else{
+            ThreadPool::Global()->ParallelFor(num_freqs, [&](int fk){
+                double freq = freqs[fk];
+                mtf_sag_list[fk] = CalculateGeometricalMtf(freq, 0.0, us, vs);
+                mtf_tan_list[fk] = CalculateGeometricalMtf(0.0, freq, us, vs);
+            });
         }
 
         std::shared_ptr<Graph2d> graph_tan = std::make_shared<Graph2d>();
@@ -168,5 +184,58 @@ std::shared_ptr<PlotData> GeometricalMTF::plot(OpticalSystem* opt_sys, int nrd,
 
     delete tracer;
 
+    plot_data->SetTraceStatistics(stats_scope.Statistics());
     return plot_data;
 }
+
+std::vector<double> GeometricalMTF::LineSpreadMtf(const std::vector<double>& freqs, const std::vector<double>& coords, int bins_per_cycle)
+{
+    constexpr int max_bins = 1 << 22;
+
+    const int num_freqs = freqs.size();
+    std::vector<double> mtf(num_freqs, 0.0);
+
+    if(coords.empty() || freqs.empty()){
+        return mtf;
+    }
+
+    const auto minmax = std::minmax_element(coords.begin(), coords.end());
+    const double x_min = *minmax.first;
+    const double extent = *minmax.second - x_min;
+
+    const double max_freq = *std::max_element(freqs.begin(), freqs.end());
+    double bin_width = (max_freq > 0.0) ? 1.0/(static_cast<double>(bins_per_cycle)*max_freq) : extent;
+    bin_width = std::max(bin_width, extent/static_cast<double>(max_bins - 2));
+    if(bin_width <= 0.0){
+        bin_width = 1.0;
+    }
+
+    const int num_bins = static_cast<int>(extent/bin_width) + 2;
+    std::vector<double> hist(num_bins, 0.0);
+    for(double xi : coords){
+        const double t = (xi - x_min)/bin_width;
+        const int b = std::min(static_cast<int>(t), num_bins - 2);
+        const double w = t - static_cast<double>(b);
+        hist[b]     += 1.0 - w;
+        hist[b + 1] += w;
+    }
+
+    const double N = static_cast<double>(coords.size());
+
+    ThreadPool::Global()->ParallelFor(num_freqs, [&](int fk){
+        const double freq = freqs[fk];
+        const std::complex<double> step = std::polar(1.0, -2.0*M_PI*freq*bin_width);
+        std::complex<double> phase(1.0, 0.0);
+        std::complex<double> sum(0.0, 0.0);
+        for(int b = 0; b < num_bins; b++){
+            sum += hist[b]*phase;
+            phase *= step;
+        }
+
+        const double arg = M_PI*freq*bin_width;
+        const double sinc = (arg == 0.0) ? 1.0 : sin(arg)/arg;
+        mtf[fk] = std::abs(sum)/(N*sinc*sinc);
+    });
+
+    return mtf;
+}
@@ -92,7 +92,9 @@ void Layout::DrawReferenceRays()
 
     SequentialTrace *tracer = new SequentialTrace(opt_sys_);
 
-    SequentialPath seq_path = tracer->CreateSequentialPath(ref_wvl_val);
+    auto seq_path_ptr = tracer->GetSequentialPath(ref_wvl_val);
+
+    const SequentialPath& seq_path = *seq_path_ptr;
 
     auto r1 = std::make_shared<Ray>();
     auto r2 = std::make_shared<Ray>();
@@ -152,7 +154,9 @@ void Layout::DrawFanRays(int nrd)
     
     SequentialTrace *tracer = new SequentialTrace(opt_sys_);
 
-    SequentialPath seq_path = tracer->CreateSequentialPath(ref_wvl_val);
+    auto seq_path_ptr = tracer->GetSequentialPath(ref_wvl_val);
+
+    const SequentialPath& seq_path = *seq_path_ptr;
 
     double step = 2.0/(double)(nrd-1);
 
@@ -37,6 +37,8 @@ OpdFan::OpdFan(OpticalSystem* opt_sys) :
 
 std::shared_ptr<PlotData> OpdFan::plot(Field* fld, int nrd)
 {
+    TraceStatisticsScope stats_scope(opt_sys_);
+
     auto plot_data = std::make_shared<PlotData>();
     plot_data->SetTitle("OPD");
 
@@ -54,7 +56,9 @@ std::shared_ptr<PlotData> OpdFan::plot(Field* fld, int nrd)
         double wvl = opt_sys_->GetOpticalSpec()->GetWavelengthSpec()->GetWavelength(wi)->Value();
         Rgb render_color = opt_sys_->GetOpticalSpec()->GetWavelengthSpec()->GetWavelength(wi)->RenderColor();
 
-        SequentialPath seq_path = tracer->CreateSequentialPath(wvl);
+        auto seq_path_ptr = tracer->GetSequentialPath(wvl);
+
+        const SequentialPath& seq_path = *seq_path_ptr;
 
         std::vector<double> pupil_data;
         std::vector<double> opd_data;
@@ -74,26 +78,31 @@ std::shared_ptr<PlotData> OpdFan::plot(Field* fld, int nrd)
             std::cerr << "Trace error" << std::endl;
         }
 
+        const WavefrontContext ctx = create_wavefront_context(chief_ray, wvl);
+
+        std::vector<Eigen::Vector2d> pupils(nrd);
         for(int ri = 0; ri < nrd; ri++)
         {
             pupil(0) = 0.0;
             pupil(1) = -1.0 + (double)ri*2.0/(double)(nrd-1);
+            pupils[ri] = pupil;
+        }
 
-            auto ray = std::make_shared<Ray>();
-            ray->Allocate(num_srfs);
-            if( TRACE_SUCCESS != tracer->TracePupilRay(ray, seq_path, pupil, fld, wvl) ){
-                break;
-            }
-
-            if(ray->Status() == TRACE_SUCCESS){
-                //double opd = wave_abr_full_calc(fld, wvl, ray, cr_pkg, ref_sphere);
-                double opd = wave_abr_full_calc(ray, chief_ray);
-                opd *= convert_to_waves;
+        RayBundle bundle(nrd, seq_path.Size());
+        tracer->TracePupilBundle(bundle, seq_path, pupils, fld, wvl);
 
-                opd_data.push_back(opd);
+        std::vector<double> opds(nrd);
+        wave_abr_full_calc(ctx, bundle, opds.data());
 
-                pupil_data.push_back(pupil(1));
+        // the fan ends at the first failed ray
+        for(int ri = 0; ri < nrd; ri++)
+        {
+            if( TRACE_SUCCESS != bundle.Status(ri) ){
+                break;
             }
+
+            opd_data.push_back(opds[ri]*convert_to_waves);
+            pupil_data.push_back(pupils[ri](1));
         }
 
         auto graph = std::make_shared<Graph2d>(pupil_data, opd_data, render_color);
@@ -103,6 +112,7 @@ std::shared_ptr<PlotData> OpdFan::plot(Field* fld, int nrd)
 
     delete tracer;
 
+    plot_data->SetTraceStatistics(stats_scope.Statistics());
     return plot_data;
 }
 
@@ -40,6 +40,8 @@ Spherochromatism::Spherochromatism(OpticalSystem* opt_sys) :
 
 std::shared_ptr<PlotData> Spherochromatism::plot(int num_rays)
 {
+    TraceStatisticsScope stats_scope(opt_sys_);
+
     const Field* fld0 = opt_sys_->GetOpticalSpec()->GetFieldSpec()->GetField(0);
 
     // collect l_prime for on-axial data
@@ -79,7 +81,9 @@ std::shared_ptr<PlotData> Spherochromatism::plot(int num_rays)
         double wvl = opt_sys_->GetOpticalSpec()->GetWavelengthSpec()->GetWavelength(wi)->Value();
         Rgb color = opt_sys_->GetOpticalSpec()->GetWavelengthSpec()->GetWavelength(wi)->RenderColor();
 
-        SequentialPath seq_path = tracer->CreateSequentialPath(wvl);
+        auto seq_path_ptr = tracer->GetSequentialPath(wvl);
+
+        const SequentialPath& seq_path = *seq_path_ptr;
 
         std::vector<double> py;
         std::vector<double> lsa;
@@ -132,5 +136,6 @@ std::shared_ptr<PlotData> Spherochromatism::plot(int num_rays)
 
     delete tracer;
 
+    plotdata->SetTraceStatistics(stats_scope.Statistics());
     return plotdata;
 }
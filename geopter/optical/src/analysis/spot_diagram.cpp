@@ -6,10 +6,57 @@
 #include "sequential/trace_error.h"
 #include "renderer/renderer.h"
 #include "data/hexapolar_array.h"
+#include "common/thread_pool.h"
 
 
 using namespace geopter;
 
+namespace {
+
+/** Trace the pupil rays in parallel tiles, and collect the image points of the rays that pass through, in pupil order */
+void TraceSpotRays(std::vector<double>& xs, std::vector<double>& ys, SequentialTrace* tracer, const SequentialPath& seq_path, const std::vector<Eigen::Vector2d>& pupils, const Field* fld, double wvl)
+{
+    constexpr int rays_per_tile = 1024;
+
+    const int num_rays  = pupils.size();
+    const int num_tiles = (num_rays + rays_per_tile - 1)/rays_per_tile;
+    const int img = seq_path.Size() - 1;
+
+    std::vector<double> tile_xs(num_rays, 0.0);
+    std::vector<double> tile_ys(num_rays, 0.0);
+    std::vector<char>   passed(num_rays, 0);
+
+    ThreadPool::Global()->ParallelFor(num_tiles, [&](int ti){
+        const int begin = ti*rays_per_tile;
+        const int end   = std::min(num_rays, begin + rays_per_tile);
+        std::vector<Eigen::Vector2d> tile_pupils(pupils.begin() + begin, pupils.begin() + end);
+
+        RayBundle bundle(end - begin, seq_path.Size(), true);
+        tracer->TracePupilBundle(bundle, seq_path, tile_pupils, fld, wvl);
+
+        for(int ri = 0; ri < end - begin; ri++){
+            if(TRACE_SUCCESS == bundle.Status(ri)){
+                tile_xs[begin + ri] = bundle.X(ri, img);
+                tile_ys[begin + ri] = bundle.Y(ri, img);
+                passed[begin + ri]  = 1;
+            }
+        }
+    });
+
+    xs.clear();
+    ys.clear();
+    xs.reserve(num_rays);
+    ys.reserve(num_rays);
+    for(int k = 0; k < num_rays; k++){
+        if(passed[k]){
+            xs.push_back(tile_xs[k]);
+            ys.push_back(tile_ys[k]);
+        }
+    }
+}
+
+}
+
 SpotDiagram::SpotDiagram(OpticalSystem* opt_sys):
     RayAberration(opt_sys)
 {
@@ -19,7 +66,7 @@ SpotDiagram::SpotDiagram(OpticalSystem* opt_sys):
     wvl_weights_.reserve(num_wvls);
     for(int wi = 0; wi < num_wvls; wi++){
         wvl_weights_.push_back( opt_sys_->GetOpticalSpec()->GetWavelengthSpec()->GetWavelength(wi)->Weight() );
-        seq_paths_.push_back( tracer->CreateSequentialPath(opt_sys_->GetOpticalSpec()->GetWavelengthSpec()->GetWavelength(wi)->Value()) );
+        seq_paths_.push_back( tracer->GetSequentialPath(opt_sys_->GetOpticalSpec()->GetWavelengthSpec()->GetWavelength(wi)->Value()) );
     }
     delete tracer;
 }
@@ -32,6 +79,8 @@ SpotDiagram::~SpotDiagram()
 
 std::shared_ptr<PlotData> SpotDiagram::plot(const Field* fld, int pattern, int max_nrd, double dot_size)
 {
+    TraceStatisticsScope stats_scope(opt_sys_);
+
     SequentialTrace *tracer = new SequentialTrace(opt_sys_);
     tracer->SetApertureCheck(true);
     tracer->SetApplyVig(false);
@@ -45,7 +94,7 @@ std::shared_ptr<PlotData> SpotDiagram::plot(const Field* fld, int pattern, int m
 
     double max_wt = *std::max_element(wvl_weights_.begin(), wvl_weights_.end());
 
-    SequentialPath ref_seq_path = seq_paths_[ref_wvl_idx_];
+    const SequentialPath& ref_seq_path = *seq_paths_[ref_wvl_idx_];
     // trace chief ray
     auto chief_ray = std::make_shared<Ray>();
     chief_ray->Allocate(ref_seq_path.Size());
@@ -61,9 +110,8 @@ std::shared_ptr<PlotData> SpotDiagram::plot(const Field* fld, int pattern, int m
 
     // trace patterned rays for all wavelengths
     Eigen::Vector2d pupil;
-
-    auto ray = std::make_shared<Ray>();
-    ray->Allocate(chief_ray->NumberOfSegments());
+    std::vector<Eigen::Vector2d> pupils;
+    std::vector<double> xs, ys;
 
     for(int wi = 0; wi < num_wvl_; wi++){
 
@@ -83,11 +131,11 @@ std::shared_ptr<PlotData> SpotDiagram::plot(const Field* fld, int pattern, int m
         const double step = 2.0/(double)nrd;
         const double start = -1.0 + step/2;
 
-        if(SpotDiagram::SpotRayPattern::Grid == pattern)
-        {            
-            graph->Resize(nrd*nrd);
+        pupils.clear();
 
-            int valid_ray_count = 0;
+        if(SpotDiagram::SpotRayPattern::Grid == pattern)
+        {
+            pupils.reserve(nrd*nrd);
 
             for(int i = 0; i < nrd; i++){
                 for(int j = 0; j < nrd; j++){
@@ -95,52 +143,23 @@ std::shared_ptr<PlotData> SpotDiagram::plot(const Field* fld, int pattern, int m
                     pupil(1) = start + step*static_cast<double>(i);
 
                     if(pupil.norm() <= 1.0){
-                        ray->SetStatus(TRACE_SUCCESS);
-                        tracer->TracePupilRay(ray, seq_paths_[wi], pupil, fld, wvl);
-
-                        if(TRACE_SUCCESS == ray->Status()){
-
-                            double ray_x = ray->GetBack()->X();
-                            double ray_y = ray->GetBack()->Y();
-
-                            double dx = ray_x - chief_ray_x;
-                            double dy = ray_y - chief_ray_y;
-
-                            graph->SetData(valid_ray_count, dx, dy);
-
-                            valid_ray_count++;
-                        }
+                        pupils.push_back(pupil);
                     }
                 }
-
             }
 
-            graph->Resize(valid_ray_count);
-
         }else if(SpotDiagram::SpotRayPattern::Hexapolar == pattern){
 
-            graph->Resize( HexapolarArray<double>(nrd).TotalNumberOfPoints() );
-            int valid_ray_count = 0;
+            pupils.reserve( HexapolarArray<double>(nrd).TotalNumberOfPoints() );
 
             int half_num_rings = nrd/2;
             for (int r = 0; r < nrd/2; r++)
             {
                 int num_rays_in_ring = 6*r;
 
-                // center of hexapolar
+                // center of hexapolar, plotted only if it passes through like the other rays
                 if(num_rays_in_ring == 0){
-                    pupil(0) = 0.0;
-                    pupil(1) = 0.0;
-
-                    ray->SetStatus(TRACE_SUCCESS);
-                    tracer->TracePupilRay(ray, seq_paths_[wi], pupil, fld, wvl);
-
-                    double dx = ray->GetBack()->X() - chief_ray_x;
-                    double dy = ray->GetBack()->Y() - chief_ray_y;
-
-                    graph->SetData(valid_ray_count, dx, dy);
-                    valid_ray_count++;
-
+                    pupils.push_back(Eigen::Vector2d({0.0, 0.0}));
                     continue;
                 }
 
@@ -149,26 +168,22 @@ std::shared_ptr<PlotData> SpotDiagram::plot(const Field* fld, int pattern, int m
                 for(int ai = 0; ai < num_rays_in_ring; ai++){
                     pupil(0) = (double)r * 1.0/(half_num_rings) * cos((double)ai*ang_step);
                     pupil(1) = (double)r * 1.0/(half_num_rings) * sin((double)ai*ang_step);
-
-                    //ray->set_status(RayStatus::PassThrough);
-                    tracer->TracePupilRay(ray, seq_paths_[wi], pupil, fld, wvl);
-
-                    if(TRACE_SUCCESS == ray->Status()){
-                        double dx = ray->GetBack()->X() - chief_ray_x;
-                        double dy = ray->GetBack()->Y() - chief_ray_y;
-
-                        graph->SetData(valid_ray_count, dx, dy);
-                        valid_ray_count++;
-                    }
+                    pupils.push_back(pupil);
                 }
             }
 
-            graph->Resize(valid_ray_count);
-
         }else{
             std::cerr << "Undefined spot pattern" << std::endl;
         }
 
+        TraceSpotRays(xs, ys, tracer, *seq_paths_[wi], pupils, fld, wvl);
+
+        const int num_valid_rays = xs.size();
+        graph->Resize(num_valid_rays);
+        for(int k = 0; k < num_valid_rays; k++){
+            graph->SetData(k, xs[k] - chief_ray_x, ys[k] - chief_ray_y);
+        }
+
         // TODO: calculate RMS, Max diameter, etc
 
 
@@ -177,6 +192,7 @@ std::shared_ptr<PlotData> SpotDiagram::plot(const Field* fld, int pattern, int m
 
     delete tracer;
 
+    plot_data->SetTraceStatistics(stats_scope.Statistics());
     return plot_data;
 }
 
@@ -0,0 +1,192 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+
+#include "analysis/through_focus.h"
+#include "analysis/geometrical_mtf.h"
+#include "sequential/sequential_trace.h"
+#include "common/thread_pool.h"
+
+using namespace geopter;
+
+ThroughFocus::ThroughFocus(OpticalSystem *opt_sys) :
+    opt_sys_(opt_sys),
+    bins_per_cycle_(16)
+{
+
+}
+
+bool ThroughFocus::TraceFinalSegments(const Field *fld, int nrd, FinalSegments &segs, Eigen::Vector3d &chief_pt, Eigen::Vector2d &chief_slope)
+{
+    const int num_wvls = opt_sys_->GetOpticalSpec()->GetWavelengthSpec()->NumberOfWavelengths();
+    const double ref_wvl_val = opt_sys_->GetOpticalSpec()->GetWavelengthSpec()->ReferenceWavelength();
+
+    SequentialTrace tracer(opt_sys_);
+    tracer.SetApertureCheck(true);
+    tracer.SetApplyVig(false);
+
+    auto ref_seq_path = tracer.GetSequentialPath(ref_wvl_val);
+    auto chief_ray = std::make_shared<Ray>(ref_seq_path->Size());
+    if(TRACE_SUCCESS != tracer.TracePupilRay(chief_ray, *ref_seq_path, Eigen::Vector2d({0.0, 0.0}), fld, ref_wvl_val)){
+        std::cerr << "Failed to trace chief ray" << std::endl;
+        return false;
+    }
+
+    const RaySegment* chief_seg = chief_ray->GetBack();
+    chief_pt = Eigen::Vector3d(chief_seg->X(), chief_seg->Y(), chief_seg->Z());
+    chief_slope = Eigen::Vector2d(chief_seg->L()/chief_seg->N(), chief_seg->M()/chief_seg->N());
+
+    // pupil grid, same as GeometricalMTF
+    const std::vector<Eigen::Vector2d> pupils = SequentialTrace::GridPupils(nrd);
+
+    constexpr int rays_per_tile = 1024;
+    const int num_rays  = pupils.size();
+    const int num_tiles = (num_rays + rays_per_tile - 1)/rays_per_tile;
+
+    FinalSegments tile_segs;
+    tile_segs.x.resize(num_rays);
+    tile_segs.y.resize(num_rays);
+    tile_segs.z.resize(num_rays);
+    tile_segs.tx.resize(num_rays);
+    tile_segs.ty.resize(num_rays);
+    std::vector<char> passed(num_rays);
+
+    for(int wi = 0; wi < num_wvls; wi++){
+        const double wvl = opt_sys_->GetOpticalSpec()->GetWavelengthSpec()->GetWavelength(wi)->Value();
+        auto seq_path = tracer.GetSequentialPath(wvl);
+        const int img = seq_path->Size() - 1;
+
+        std::fill(passed.begin(), passed.end(), 0);
+
+        ThreadPool::Global()->ParallelFor(num_tiles, [&](int ti){
+            const int begin = ti*rays_per_tile;
+            const int end   = std::min(num_rays, begin + rays_per_tile);
+            std::vector<Eigen::Vector2d> tile_pupils(pupils.begin() + begin, pupils.begin() + end);
+
+            RayBundle bundle(end - begin, seq_path->Size(), true);
+            tracer.TracePupilBundle(bundle, *seq_path, tile_pupils, fld, wvl);
+
+            for(int ri = 0; ri < end - begin; ri++){
+                if(TRACE_SUCCESS == bundle.Status(ri) && bundle.N(ri, img) != 0.0){
+                    const int k = begin + ri;
+                    tile_segs.x[k]  = bundle.X(ri, img);
+                    tile_segs.y[k]  = bundle.Y(ri, img);
+                    tile_segs.z[k]  = bundle.Z(ri, img);
+                    tile_segs.tx[k] = bundle.L(ri, img)/bundle.N(ri, img);
+                    tile_segs.ty[k] = bundle.M(ri, img)/bundle.N(ri, img);
+                    passed[k] = 1;
+                }
+            }
+        });
+
+        for(int k = 0; k < num_rays; k++){
+            if(passed[k]){
+                segs.x.push_back(tile_segs.x[k]);
+                segs.y.push_back(tile_segs.y[k]);
+                segs.z.push_back(tile_segs.z[k]);
+                segs.tx.push_back(tile_segs.tx[k]);
+                segs.ty.push_back(tile_segs.ty[k]);
+            }
+        }
+    }
+
+    return true;
+}
+
+std::shared_ptr<DataGrid> ThroughFocus::Compute(const Field *fld, int nrd, double focus_min, double focus_max, int num_steps, double mtf_freq)
+{
+    TraceStatisticsScope stats_scope(opt_sys_);
+
+    const double focus_step = (num_steps > 1) ? (focus_max - focus_min)/static_cast<double>(num_steps - 1) : 0.0;
+
+    auto data_grid = std::make_shared<DataGrid>(NumberOfMetrics, num_steps, 1.0, focus_step);
+    data_grid->SetDescription("Through Focus");
+    data_grid->SetXLabel("Metric");
+    data_grid->SetYLabel("Defocus");
+
+    FinalSegments segs;
+    Eigen::Vector3d chief_pt;
+    Eigen::Vector2d chief_slope;
+    if( !TraceFinalSegments(fld, nrd, segs, chief_pt, chief_slope) ){
+        return data_grid;
+    }
+
+    const int num_rays = segs.x.size();
+    const std::vector<double> freqs({mtf_freq});
+
+    // each focus plane is a task
+    ThreadPool::Global()->ParallelFor(num_steps, [&](int k){
+        const double dz = focus_min + focus_step*static_cast<double>(k);
+
+        const double chief_x = chief_pt(0) + chief_slope(0)*(dz - chief_pt(2));
+        const double chief_y = chief_pt(1) + chief_slope(1)*(dz - chief_pt(2));
+
+        std::vector<double> us(num_rays), vs(num_rays);
+        double sum_u = 0.0, sum_v = 0.0;
+        for(int i = 0; i < num_rays; i++){
+            const double t = dz - segs.z[i];
+            us[i] = segs.x[i] + segs.tx[i]*t - chief_x;
+            vs[i] = segs.y[i] + segs.ty[i]*t - chief_y;
+            sum_u += us[i];
+            sum_v += vs[i];
+        }
+
+        double centroid_u = 0.0, centroid_v = 0.0, rms = 0.0, geo = 0.0;
+        std::vector<double> mtf_tan({0.0}), mtf_sag({0.0});
+
+        if(num_rays > 0){
+            centroid_u = sum_u/static_cast<double>(num_rays);
+            centroid_v = sum_v/static_cast<double>(num_rays);
+
+            double sum_r2 = 0.0, max_r2 = 0.0;
+            for(int i = 0; i < num_rays; i++){
+                const double du = us[i] - centroid_u;
+                const double dv = vs[i] - centroid_v;
+                const double r2 = du*du + dv*dv;
+                sum_r2 += r2;
+                max_r2 = std::max(max_r2, r2);
+            }
+            rms = sqrt(sum_r2/static_cast<double>(num_rays));
+            geo = sqrt(max_r2);
+
+            mtf_sag = GeometricalMTF::LineSpreadMtf(freqs, us, bins_per_cycle_);
+            mtf_tan = GeometricalMTF::LineSpreadMtf(freqs, vs, bins_per_cycle_);
+        }
+
+        data_grid->SetValueAt(k, Defocus,       dz);
+        data_grid->SetValueAt(k, RmsSpotRadius, rms);
+        data_grid->SetValueAt(k, GeoSpotRadius, geo);
+        data_grid->SetValueAt(k, CentroidX,     centroid_u);
+        data_grid->SetValueAt(k, CentroidY,     centroid_v);
+        data_grid->SetValueAt(k, MtfTangential, mtf_tan[0]);
+        data_grid->SetValueAt(k, MtfSagittal,   mtf_sag[0]);
+    });
+
+    data_grid->SetTraceStatistics(stats_scope.Statistics());
+    return data_grid;
+}
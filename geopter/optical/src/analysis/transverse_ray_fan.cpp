@@ -14,6 +14,8 @@ TransverseRayFan::TransverseRayFan(OpticalSystem* opt_sys) :
 
 std::shared_ptr<PlotData> TransverseRayFan::plot(double nrd, const Field* fld, int pupil_dir, int abr_dir)
 {
+    TraceStatisticsScope stats_scope(opt_sys_);
+
     const int stop_index = opt_sys_->GetOpticalAssembly()->StopIndex();
     //const double stop_radius = opt_sys_->optical_assembly()->surface(stop_index)->max_aperture();
 
@@ -38,7 +40,9 @@ std::shared_ptr<PlotData> TransverseRayFan::plot(double nrd, const Field* fld, i
         plot_data->SetYLabel("dy");
     }
 
-    SequentialPath ref_seq_path = tracer->CreateSequentialPath(ref_wvl_val_);
+    auto ref_seq_path_ptr = tracer->GetSequentialPath(ref_wvl_val_);
+
+    const SequentialPath& ref_seq_path = *ref_seq_path_ptr;
 
     // trace chief ray
     auto chief_ray = std::make_shared<Ray>();
@@ -60,7 +64,9 @@ std::shared_ptr<PlotData> TransverseRayFan::plot(double nrd, const Field* fld, i
         double wvl = opt_sys_->GetOpticalSpec()->GetWavelengthSpec()->GetWavelength(wi)->Value();
         Rgb render_color = opt_sys_->GetOpticalSpec()->GetWavelengthSpec()->GetWavelength(wi)->RenderColor();
 
-        SequentialPath seq_path = tracer->CreateSequentialPath(wvl);
+        auto seq_path_ptr = tracer->GetSequentialPath(wvl);
+
+        const SequentialPath& seq_path = *seq_path_ptr;
 
         std::vector<double> pupil_data;
         std::vector<double> abr_data;
@@ -113,5 +119,6 @@ std::shared_ptr<PlotData> TransverseRayFan::plot(double nrd, const Field* fld, i
 
     delete tracer;
 
+    plot_data->SetTraceStatistics(stats_scope.Statistics());
     return plot_data;
 }
@@ -1,6 +1,7 @@
 
 #include "analysis/wave_aberration.h"
 
+#include <cmath>
 #include <iostream>
 
 #include "sequential/sequential_trace.h"
@@ -19,111 +20,78 @@ WaveAberration::~WaveAberration()
     opt_sys_ = nullptr;
 }
 
-double WaveAberration::wave_abr_full_calc(const std::shared_ptr<Ray>& ray, const std::shared_ptr<Ray>& chief_ray, const Field* fld, ReferenceSphere& ref_sphere)
+WavefrontContext WaveAberration::CreateWavefrontContext(const std::shared_ptr<Ray> &chief_ray, double wvl)
 {
-    int k = opt_sys_->GetOpticalAssembly()->ImageIndex() - 1;
-    Surface* srf = opt_sys_->GetOpticalAssembly()->GetSurface(k);
-    //double exp_dist_parax = opt_sys_->paraxial_data()->exit_pupil_distance();
-
-    double cr_exp_dist;
-    Eigen::Vector3d cr_exp_pt;
-    get_chief_ray_exp_segment(cr_exp_pt, cr_exp_dist, chief_ray);
-
-    Eigen::Vector3d ref_dir = ref_sphere.ReferenceDirection();
-    double ref_sphere_radius = ref_sphere.Radius();
+    return create_wavefront_context(chief_ray, wvl);
+}
 
-    double e1 = eic_distance(ray->GetSegmentAt(1)->IntersectPt(), ray->GetSegmentAt(0)->Direction(),
-                             chief_ray->GetSegmentAt(1)->IntersectPt(), chief_ray->GetSegmentAt(0)->Direction());
+double WaveAberration::Opd(const WavefrontContext &ctx, const std::shared_ptr<Ray> &ray) const
+{
+    return wave_abr_full_calc(ctx, ray);
+}
 
-    double ekp = eic_distance(ray->GetSegmentAt(k)->IntersectPt(), ray->GetSegmentAt(k)->Direction(),
-                              chief_ray->GetSegmentAt(k)->IntersectPt(), chief_ray->GetSegmentAt(k)->Direction());
+WavefrontContext WaveAberration::create_wavefront_context(const std::shared_ptr<Ray>& chief_ray, ReferenceSphere& ref_sphere, double wvl)
+{
+    WavefrontContext ctx;
 
-    Eigen::Vector3d ray_inc_pt_before_img;
-    Eigen::Vector3d ray_dir_before_img;
-    transform_after_surface(ray_inc_pt_before_img, ray_dir_before_img, srf,ray->GetSegmentAt(k));
-    double dst = ekp - cr_exp_dist;
-    Eigen::Vector3d eic_exp_pt = ray_inc_pt_before_img - dst*ray_dir_before_img;
-    Eigen::Vector3d p_coord = eic_exp_pt - cr_exp_pt;
+    ctx.k = opt_sys_->GetOpticalAssembly()->ImageIndex() - 1;
+    ctx.decentered = opt_sys_->GetOpticalAssembly()->GetSurface(ctx.k)->Decenter();
 
-    double F = ref_dir.dot(ray_dir_before_img) - ray_dir_before_img.dot(p_coord)/ref_sphere_radius;
-    double J = p_coord.dot(p_coord)/ref_sphere_radius - 2.0*ref_dir.dot(p_coord);
+    get_chief_ray_exp_segment(ctx.cr_exp_pt, ctx.cr_exp_dist, chief_ray);
 
-    double soln = ref_dir(2)*chief_ray->GetBack()->Direction()(2);
-    double sign_soln = (soln > 0.0) - (soln < 0.0);
-    double denom = F + sign_soln*sqrt( F*F + J/ref_sphere_radius );
-    double ep;
-    if(fabs(denom) < std::numeric_limits<double>::epsilon()){
-        ep = 0.0;
-    }else{
-        ep = J/denom;
-    }
+    ctx.ref_dir = ref_sphere.ReferenceDirection();
+    ctx.ref_sphere_radius = ref_sphere.Radius();
 
-    double ray_op = ray->OpticalPathLength();
-    double chief_ray_op = chief_ray->OpticalPathLength();
+    double soln = ctx.ref_dir(2)*chief_ray->GetBack()->Direction()(2);
+    ctx.sign_soln = (soln > 0.0) - (soln < 0.0);
 
-    double wvl = chief_ray->Wavelength();
-    double n_img = opt_sys_->GetOpticalAssembly()->ImageSpaceGap()->GetMaterial()->RefractiveIndex(wvl);
-    double n_obj = opt_sys_->GetOpticalAssembly()->GetGap(0)->GetMaterial()->RefractiveIndex(wvl);
+    ctx.cr_pt1  = chief_ray->GetSegmentAt(1)->IntersectPt();
+    ctx.cr_dir0 = chief_ray->GetSegmentAt(0)->Direction();
+    ctx.cr_ptk  = chief_ray->GetSegmentAt(ctx.k)->IntersectPt();
+    ctx.cr_dirk = chief_ray->GetSegmentAt(ctx.k)->Direction();
+    ctx.cr_op   = chief_ray->OpticalPathLength();
 
-    n_img = fabs(n_img);
-    n_obj = fabs(n_obj);
+    ctx.n_img = fabs(opt_sys_->GetOpticalAssembly()->ImageSpaceGap()->GetMaterial()->RefractiveIndex(wvl));
+    ctx.n_obj = fabs(opt_sys_->GetOpticalAssembly()->GetGap(0)->GetMaterial()->RefractiveIndex(wvl));
 
-    double opd = -n_obj*e1 - ray_op + n_img*ekp + chief_ray_op - n_img*ep;
+    ctx.stats = TraceStatisticsScope::Current(opt_sys_);
 
-    return opd;
+    if(ctx.decentered){
+        // not implemented yet
+        std::cerr << "not implemented: WaveAberration::transform_after_surface()" << std::endl;
+    }
 
+    return ctx;
 }
 
-double WaveAberration::wave_abr_full_calc(const std::shared_ptr<Ray>& ray, const std::shared_ptr<Ray>& chief_ray)
+WavefrontContext WaveAberration::create_wavefront_context(const std::shared_ptr<Ray>& chief_ray, double wvl)
 {
-    /*
-     * 1. calculate chief ray intersection with exit pupil
-     * 2. calculate reference sphere
-     * 3. calculate opd
-     *
-     */
-
-    // ---> 1. calculate chief ray intersection with exit pupil
-
-    int k = opt_sys_->GetOpticalAssembly()->ImageIndex() - 1;
-    Surface* srf = opt_sys_->GetOpticalAssembly()->GetSurface(k);
-    //double exp_dist_parax = opt_sys_->paraxial_data()->exit_pupil_distance();
-
     double cr_exp_dist;
     Eigen::Vector3d cr_exp_pt;
     get_chief_ray_exp_segment(cr_exp_pt, cr_exp_dist, chief_ray);
 
-    // <---
-
-    //---> 2. calculate reference sphere
-
     ReferenceSphere ref_sphere = setup_reference_sphere(chief_ray, cr_exp_pt);
 
-    Eigen::Vector3d ref_dir = ref_sphere.ReferenceDirection();
-    double ref_sphere_radius = ref_sphere.Radius();
-
-    // <---
+    return create_wavefront_context(chief_ray, ref_sphere, wvl);
+}
 
-    // ---> 3. calculate opd
-    double e1 = eic_distance(ray->GetSegmentAt(1)->IntersectPt(), ray->GetSegmentAt(0)->Direction(),
-                             chief_ray->GetSegmentAt(1)->IntersectPt(), chief_ray->GetSegmentAt(0)->Direction());
+namespace {
 
-    double ekp = eic_distance(ray->GetSegmentAt(k)->IntersectPt(), ray->GetSegmentAt(k)->Direction(),
-                              chief_ray->GetSegmentAt(k)->IntersectPt(), chief_ray->GetSegmentAt(k)->Direction());
+/** OPD of a ray given by the intersection at the first surface, the object space direction, the segment at the surface k and the total optical path */
+inline double CalculateOpd(const WavefrontContext& ctx, const Eigen::Vector3d& pt1, const Eigen::Vector3d& dir0, const Eigen::Vector3d& ptk, const Eigen::Vector3d& dirk, double ray_op)
+{
+    // equally inclined chord distances
+    double e1  = ( (dir0 + ctx.cr_dir0).dot(pt1 - ctx.cr_pt1) ) / ( 1.0 + dir0.dot(ctx.cr_dir0) );
+    double ekp = ( (dirk + ctx.cr_dirk).dot(ptk - ctx.cr_ptk) ) / ( 1.0 + dirk.dot(ctx.cr_dirk) );
 
-    Eigen::Vector3d ray_inc_pt_before_img;
-    Eigen::Vector3d ray_dir_before_img;
-    transform_after_surface(ray_inc_pt_before_img, ray_dir_before_img, srf,ray->GetSegmentAt(k));
-    double dst = ekp - cr_exp_dist;
-    Eigen::Vector3d eic_exp_pt = ray_inc_pt_before_img - dst*ray_dir_before_img;
-    Eigen::Vector3d p_coord = eic_exp_pt - cr_exp_pt;
+    double dst = ekp - ctx.cr_exp_dist;
+    Eigen::Vector3d eic_exp_pt = ptk - dst*dirk;
+    Eigen::Vector3d p_coord = eic_exp_pt - ctx.cr_exp_pt;
 
-    double F = ref_dir.dot(ray_dir_before_img) - ray_dir_before_img.dot(p_coord)/ref_sphere_radius;
-    double J = p_coord.dot(p_coord)/ref_sphere_radius - 2.0*ref_dir.dot(p_coord);
+    double F = ctx.ref_dir.dot(dirk) - dirk.dot(p_coord)/ctx.ref_sphere_radius;
+    double J = p_coord.dot(p_coord)/ctx.ref_sphere_radius - 2.0*ctx.ref_dir.dot(p_coord);
 
-    double soln = ref_dir(2)*chief_ray->GetBack()->Direction()(2);
-    double sign_soln = (soln > 0.0) - (soln < 0.0);
-    double denom = F + sign_soln*sqrt( F*F + J/ref_sphere_radius );
+    double denom = F + ctx.sign_soln*sqrt( F*F + J/ctx.ref_sphere_radius );
     double ep;
     if(fabs(denom) < std::numeric_limits<double>::epsilon()){
         ep = 0.0;
@@ -131,20 +99,60 @@ double WaveAberration::wave_abr_full_calc(const std::shared_ptr<Ray>& ray, const
         ep = J/denom;
     }
 
-    double ray_op = ray->OpticalPathLength();
-    double chief_ray_op = chief_ray->OpticalPathLength();
+    return -ctx.n_obj*e1 - ray_op + ctx.n_img*ekp + ctx.cr_op - ctx.n_img*ep;
+}
+
+}
+
+double WaveAberration::wave_abr_full_calc(const WavefrontContext& ctx, const std::shared_ptr<Ray>& ray) const
+{
+    TraceStatistics::StageTimer timer(ctx.stats.get(), TraceStatistics::Opd);
+
+    return CalculateOpd(ctx, ray->GetSegmentAt(1)->IntersectPt(), ray->GetSegmentAt(0)->Direction(),
+                        ray->GetSegmentAt(ctx.k)->IntersectPt(), ray->GetSegmentAt(ctx.k)->Direction(),
+                        ray->OpticalPathLength());
+}
+
+double WaveAberration::Opd(const WavefrontContext &ctx, const std::shared_ptr<Ray> &ray, double defocus) const
+{
+    // the optical path is taken up to the surface k, so only the reference sphere moves, centered at the chief ray on the moved image surface
+    const Eigen::Vector3d ref_sphere_vec = ctx.ref_sphere_radius*ctx.ref_dir + (defocus/ctx.cr_dirk(2))*ctx.cr_dirk;
 
-    double ref_wvl_val = opt_sys_->GetOpticalSpec()->GetWavelengthSpec()->ReferenceWavelength();
-    double n_img = opt_sys_->GetOpticalAssembly()->ImageSpaceGap()->GetMaterial()->RefractiveIndex(ref_wvl_val);
-    double n_obj = opt_sys_->GetOpticalAssembly()->GetGap(0)->GetMaterial()->RefractiveIndex(ref_wvl_val);
+    WavefrontContext defocused = ctx;
+    defocused.ref_sphere_radius = ref_sphere_vec.norm();
+    defocused.ref_dir = ref_sphere_vec.normalized();
 
-    n_img = fabs(n_img);
-    n_obj = fabs(n_obj);
+    return wave_abr_full_calc(defocused, ray);
+}
 
-    double opd = -n_obj*e1 - ray_op + n_img*ekp + chief_ray_op - n_img*ep;
+void WaveAberration::wave_abr_full_calc(const WavefrontContext& ctx, const RayBundle& bundle, double* opd) const
+{
+    TraceStatistics::StageTimer timer(ctx.stats.get(), TraceStatistics::Opd);
+
+    const int num_rays = bundle.NumberOfRays();
+
+    for(int ri = 0; ri < num_rays; ri++){
+        if(TRACE_SUCCESS != bundle.Status(ri)){
+            opd[ri] = NAN;
+            continue;
+        }
+        opd[ri] = CalculateOpd(ctx, bundle.IntersectPt(ri, 1), bundle.Direction(ri, 0),
+                               bundle.IntersectPt(ri, ctx.k), bundle.Direction(ri, ctx.k),
+                               bundle.OpticalPathLength(ri));
+    }
+}
 
-    return opd;
+double WaveAberration::wave_abr_full_calc(const std::shared_ptr<Ray>& ray, const std::shared_ptr<Ray>& chief_ray, const Field* /*fld*/, ReferenceSphere& ref_sphere)
+{
+    const WavefrontContext ctx = create_wavefront_context(chief_ray, ref_sphere, chief_ray->Wavelength());
+    return wave_abr_full_calc(ctx, ray);
+}
 
+double WaveAberration::wave_abr_full_calc(const std::shared_ptr<Ray>& ray, const std::shared_ptr<Ray>& chief_ray)
+{
+    const double ref_wvl_val = opt_sys_->GetOpticalSpec()->GetWavelengthSpec()->ReferenceWavelength();
+    const WavefrontContext ctx = create_wavefront_context(chief_ray, ref_wvl_val);
+    return wave_abr_full_calc(ctx, ray);
 }
 
 double WaveAberration::eic_distance(const Eigen::Vector3d& p, const Eigen::Vector3d& d, const Eigen::Vector3d& p0, const Eigen::Vector3d& d0)
@@ -22,10 +22,13 @@
 **          Contact: heterophyllus.work@gmail.com
 **             Date: November 11th, 2021
 ********************************************************************************/
+#define _USE_MATH_DEFINES
+#include <cmath>
 #include <iostream>
 #include "analysis/wavefront.h"
 #include "sequential/sequential_trace.h"
 #include "sequential/trace_error.h"
+#include "common/thread_pool.h"
 
 using namespace geopter;
 
@@ -38,6 +41,8 @@ WavefrontMap::WavefrontMap(OpticalSystem* opt_sys)
 
 std::shared_ptr<DataGrid> WavefrontMap::Create(const Field *fld, double wvl, int ndim)
 {
+    TraceStatisticsScope stats_scope(opt_sys_);
+
     ndim_ = ndim;
     wvl_ = wvl;
 
@@ -48,57 +53,108 @@ std::shared_ptr<DataGrid> WavefrontMap::Create(const Field *fld, double wvl, int
     tracer->SetApertureCheck(true);
     tracer->SetApplyVig(false);
 
-    SequentialPath seq_path = tracer->CreateSequentialPath(wvl);
+    auto seq_path_ptr = tracer->GetSequentialPath(wvl);
+
+    const SequentialPath& seq_path = *seq_path_ptr;
 
     const auto chief_ray = std::make_shared<Ray>();
     chief_ray->Allocate(seq_path.Size());
-    int trace_result = tracer->TracePupilRay(chief_ray, seq_path, Eigen::Vector2d({0.0, 0.0}), fld, wvl);
+    tracer->TracePupilRay(chief_ray, seq_path, Eigen::Vector2d({0.0, 0.0}), fld, wvl);
 
     const double step = 2.0/static_cast<double>(ndim-1);
     const double start = -1.0;
 
-    Eigen::Vector2d pupil;
-
     double epd = 2.0*opt_sys_->GetFirstOrderData()->entrance_pupil_radius;
-    RayPtr ray = std::make_shared<Ray>();
-    ray->Allocate(seq_path.Size());
 
     auto data_grid = std::make_shared<DataGrid>(ndim, ndim, epd, epd);
 
-    double cr_exp_dist;
-    Eigen::Vector3d cr_exp_pt;
-    get_chief_ray_exp_segment(cr_exp_pt, cr_exp_dist, chief_ray);
-    auto ref_sphere = setup_reference_sphere(chief_ray,cr_exp_pt);
+    const WavefrontContext ctx = create_wavefront_context(chief_ray, wvl);
 
+    // each row of the grid is a task, traced as one bundle
+    ThreadPool::Global()->ParallelFor(ndim, [&](int i){
+        std::vector<Eigen::Vector2d> pupils;
+        std::vector<int> cols;
+        pupils.reserve(ndim);
+        cols.reserve(ndim);
 
-    for(int i = 0; i < ndim; i++)
-    {
         for(int j = 0 ; j < ndim; j++)
         {
-            pupil(0) = start + step*static_cast<double>(j);
-            pupil(1) = start + step*static_cast<double>(i);
-
+            Eigen::Vector2d pupil(start + step*static_cast<double>(j), start + step*static_cast<double>(i));
             if(pupil.norm() < 1.0){
-                trace_result = tracer->TracePupilRay(ray, seq_path, pupil, fld, wvl);
-                if(TRACE_SUCCESS == trace_result){
-                    double opd = wave_abr_full_calc(ray, chief_ray, fld, ref_sphere);
-                    opd *= convert_to_waves;
-                    data_grid->SetValueAt(i, j, opd);
-                }else{
-                    data_grid->SetValueAt(i, j, NAN);
-                }
-            }else{
-                data_grid->SetValueAt(i, j, NAN);
+                pupils.push_back(pupil);
+                cols.push_back(j);
             }
+            data_grid->SetValueAt(i, j, NAN);
+        }
 
+        if(pupils.empty()){
+            return;
         }
 
-    }
+        RayBundle bundle(pupils.size(), seq_path.Size());
+        tracer->TracePupilBundle(bundle, seq_path, pupils, fld, wvl);
+
+        std::vector<double> opd(pupils.size());
+        wave_abr_full_calc(ctx, bundle, opd.data());
+
+        for(size_t k = 0; k < cols.size(); k++){
+            data_grid->SetValueAt(i, cols[k], opd[k]*convert_to_waves);
+        }
+    });
 
     delete tracer;
 
+    data_grid->SetTraceStatistics(stats_scope.Statistics());
     return data_grid;
 }
 
+bool WavefrontMap::CreatePupilFunction(const Field *fld, double wvl, int pupil_samples, PupilFunction &pf)
+{
+    const int P = pupil_samples;
+    if(P < 2){
+        std::cerr << "Pupil samples must be at least 2" << std::endl;
+        return false;
+    }
 
+    // distance from the exit pupil to the chief ray on the image
+    SequentialTrace tracer(opt_sys_);
+    auto seq_path_ptr = tracer.GetSequentialPath(wvl);
+    const SequentialPath& seq_path = *seq_path_ptr;
 
+    auto chief_ray = std::make_shared<Ray>(seq_path.Size());
+    if( TRACE_SUCCESS != tracer.TracePupilRay(chief_ray, seq_path, Eigen::Vector2d({0.0, 0.0}), fld, wvl) ){
+        std::cerr << "Failed to trace chief ray" << std::endl;
+        return false;
+    }
+
+    const double img_ht = chief_ray->GetBack()->Height();
+    const double img_dist = opt_sys_->GetFirstOrderData()->image_distance;
+    const double exp_dist = opt_sys_->GetFirstOrderData()->exit_pupil_distance;
+    const double zxp = img_dist - exp_dist;
+
+    pf.distance = sqrt(zxp*zxp + img_ht*img_ht);
+    pf.radius = opt_sys_->GetFirstOrderData()->exit_pupil_radius;
+    pf.sample_step = 2.0*pf.radius/static_cast<double>(P-1);
+    pf.wavelength = wvl*1.0e-6;
+
+    auto wf_grid = Create(fld, wvl, P);
+    const Eigen::MatrixXd& W = wf_grid->ValueData();
+
+    pf.values = Eigen::MatrixXcd::Zero(P, P);
+    pf.num_valid = 0;
+    for(int i = 0; i < P; i++){
+        for(int j = 0; j < P; j++){
+            if(!std::isnan(W(i,j))){
+                pf.values(i,j) = std::polar(1.0, -2.0*M_PI*W(i,j));
+                pf.num_valid++;
+            }
+        }
+    }
+
+    return true;
+}
+
+std::vector<double> WavefrontMap::FitZernike(DataGrid *wf_grid, int num_terms, ZernikeOrdering ordering)
+{
+    return ZernikeFit::Fit(wf_grid->ValueData(), num_terms, ordering);
+}
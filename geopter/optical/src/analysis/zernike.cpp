@@ -0,0 +1,209 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+
+#include "Eigen/Dense"
+#include "analysis/zernike.h"
+
+using namespace geopter;
+
+std::vector< std::shared_ptr<const ZernikeFit::Basis> > ZernikeFit::cache_;
+std::mutex ZernikeFit::cache_mtx_;
+
+namespace {
+
+double Factorial(int n)
+{
+    double f = 1.0;
+    for(int i = 2; i <= n; i++){
+        f *= static_cast<double>(i);
+    }
+    return f;
+}
+
+/** Radial polynomial R_n^m, m >= 0 */
+double RadialPolynomial(int n, int m, double rho)
+{
+    double r = 0.0;
+    for(int s = 0; s <= (n - m)/2; s++){
+        const double c = Factorial(n - s)/( Factorial(s) * Factorial((n + m)/2 - s) * Factorial((n - m)/2 - s) );
+        r += ((s % 2 == 0) ? c : -c) * std::pow(rho, n - 2*s);
+    }
+    return r;
+}
+
+}
+
+bool ZernikeFit::Indices(int j, ZernikeOrdering ordering, int &n, int &m)
+{
+    if(j < 1){
+        std::cerr << "Zernike term index must be at least 1: " << j << std::endl;
+        return false;
+    }
+
+    if(ZernikeOrdering::Noll == ordering){
+        // row n holds the indices n(n+1)/2+1 ... (n+1)(n+2)/2, with |m| increasing and cosine terms on even indices
+        n = 0;
+        while((n + 1)*(n + 2)/2 < j){
+            n++;
+        }
+        int k = j - n*(n + 1)/2 - 1;
+        int abs_m = (n % 2 == 0) ? 2*((k + 1)/2) : 2*(k/2) + 1;
+        m = (abs_m == 0 || j % 2 == 0) ? abs_m : -abs_m;
+        return true;
+    }else{
+        // j = (1 + (n+|m|)/2)^2 - 2|m| + (m < 0)
+        for(int nn = 0; ; nn++){
+            for(int mm = -nn; mm <= nn; mm += 2){
+                const int k = (nn + std::abs(mm))/2;
+                const int jj = (1 + k)*(1 + k) - 2*std::abs(mm) + ((mm < 0) ? 1 : 0);
+                if(jj == j){
+                    n = nn;
+                    m = mm;
+                    return true;
+                }
+            }
+        }
+    }
+}
+
+double ZernikeFit::Evaluate(int j, ZernikeOrdering ordering, double rho, double theta)
+{
+    int n, m;
+    if( !Indices(j, ordering, n, m) ){
+        return NAN;
+    }
+
+    const int abs_m = std::abs(m);
+    double z = RadialPolynomial(n, abs_m, rho);
+    if(m > 0){
+        z *= cos(abs_m*theta);
+    }else if(m < 0){
+        z *= sin(abs_m*theta);
+    }
+
+    if(ZernikeOrdering::Noll == ordering){
+        z *= (m == 0) ? sqrt(n + 1.0) : sqrt(2.0*(n + 1.0));
+    }
+
+    return z;
+}
+
+std::shared_ptr<const ZernikeFit::Basis> ZernikeFit::GetBasis(int rows, int cols, int num_terms, ZernikeOrdering ordering, const std::vector<char> &mask)
+{
+    constexpr size_t max_cache_size = 16;
+
+    {
+        std::lock_guard<std::mutex> lk(cache_mtx_);
+        for(const auto& b : cache_){
+            if(b->rows == rows && b->cols == cols && b->num_terms == num_terms && b->ordering == ordering && b->mask == mask){
+                return b;
+            }
+        }
+    }
+
+    auto basis = std::make_shared<Basis>();
+    basis->rows = rows;
+    basis->cols = cols;
+    basis->num_terms = num_terms;
+    basis->ordering = ordering;
+    basis->mask = mask;
+
+    const int num_valid = std::count(mask.begin(), mask.end(), 1);
+
+    // basis matrix over the valid cells, column-major like the grid
+    Eigen::MatrixXd A(num_valid, num_terms);
+    const double step_x = (cols > 1) ? 2.0/static_cast<double>(cols - 1) : 0.0;
+    const double step_y = (rows > 1) ? 2.0/static_cast<double>(rows - 1) : 0.0;
+    int v = 0;
+    for(int c = 0; c < cols; c++){
+        for(int r = 0; r < rows; r++){
+            if( !mask[c*rows + r] ){
+                continue;
+            }
+            const double x = -1.0 + step_x*static_cast<double>(c);
+            const double y = -1.0 + step_y*static_cast<double>(r);
+            const double rho = sqrt(x*x + y*y);
+            const double theta = atan2(y, x);
+            for(int t = 0; t < num_terms; t++){
+                A(v, t) = Evaluate(t + 1, ordering, rho, theta);
+            }
+            v++;
+        }
+    }
+
+    // normal equations, factored once by Cholesky
+    const Eigen::MatrixXd AtA = A.transpose()*A;
+    basis->pseudo_inverse = AtA.ldlt().solve(A.transpose());
+
+    std::lock_guard<std::mutex> lk(cache_mtx_);
+    if(cache_.size() >= max_cache_size){
+        cache_.erase(cache_.begin());
+    }
+    cache_.push_back(basis);
+
+    return basis;
+}
+
+std::vector<double> ZernikeFit::Fit(const Eigen::MatrixXd &grid, int num_terms, ZernikeOrdering ordering)
+{
+    const int rows = grid.rows();
+    const int cols = grid.cols();
+    const int size = rows*cols;
+
+    std::vector<char> mask(size);
+    int num_valid = 0;
+    for(int k = 0; k < size; k++){
+        mask[k] = std::isnan(grid.data()[k]) ? 0 : 1;
+        num_valid += mask[k];
+    }
+
+    if(num_terms <= 0 || num_valid < num_terms){
+        return std::vector<double>();
+    }
+
+    auto basis = GetBasis(rows, cols, num_terms, ordering, mask);
+
+    Eigen::VectorXd values(num_valid);
+    int v = 0;
+    for(int k = 0; k < size; k++){
+        if(mask[k]){
+            values(v++) = grid.data()[k];
+        }
+    }
+
+    const Eigen::VectorXd coefs = basis->pseudo_inverse*values;
+
+    return std::vector<double>(coefs.data(), coefs.data() + coefs.size());
+}
+
+void ZernikeFit::ClearCache()
+{
+    std::lock_guard<std::mutex> lk(cache_mtx_);
+    cache_.clear();
+}
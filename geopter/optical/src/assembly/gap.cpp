@@ -27,6 +27,8 @@
 #include "assembly/gap.h"
 #include "solve/fixed_solve.h"
 
+#include <algorithm>
+
 using namespace geopter;
 
 Gap::Gap()
@@ -34,6 +36,7 @@ Gap::Gap()
     thi_ = 0.0;
     material_ = MaterialLibrary::GetAir();
     solve_ = std::make_unique<FixedSolve>();
+    revision_ = RevisionCounter::Next();
 }
 
 Gap::Gap(double t, std::shared_ptr<Material> m){
@@ -44,6 +47,7 @@ Gap::Gap(double t, std::shared_ptr<Material> m){
         material_ = MaterialLibrary::GetAir();
     }
     solve_ = std::make_unique<FixedSolve>();
+    revision_ = RevisionCounter::Next();
 }
 
 Gap::~Gap()
@@ -51,6 +55,22 @@ Gap::~Gap()
     material_ = nullptr;
 }
 
+std::unique_ptr<Gap> Gap::Clone() const
+{
+    auto gap = std::make_unique<Gap>(thi_, material_);
+
+    if(solve_){
+        gap->solve_ = solve_->Clone();
+    }else{
+        gap->solve_.reset();
+    }
+
+    gap->gap_index_ = gap_index_;
+    gap->revision_  = revision_;
+
+    return gap;
+}
+
 void Gap::SetMaterial(std::shared_ptr<Material> m)
 {
     if(m){
@@ -58,6 +78,21 @@ void Gap::SetMaterial(std::shared_ptr<Material> m)
     }else{
         material_ = MaterialLibrary::GetAir();
     }
+    revision_ = RevisionCounter::Next();
+}
+
+void Gap::SetThickness(double t)
+{
+    // solves reassign the thickness on every update, so only actual changes are stamped
+    if(t != thi_){
+        thi_ = t;
+        revision_ = RevisionCounter::Next();
+    }
+}
+
+uint64_t Gap::Revision() const
+{
+    return std::max(revision_, material_->Revision());
 }
 
 bool Gap::HasSolve() const {
@@ -41,6 +41,7 @@ OpticalAssembly::OpticalAssembly(OpticalSystem* opt_sys) :
     parent_(opt_sys)
 {
     num_surfs_ = 0;
+    revision_ = RevisionCounter::Next();
 }
 
 OpticalAssembly::~OpticalAssembly()
@@ -64,7 +65,7 @@ void OpticalAssembly::UpdateSolve()
     const int num_srfs = interfaces_.size();
 
     // update gap index
-    for(int i = 0; i < num_gaps_; i++){
+    for(int i = 0; i < (int)gaps_.size(); i++){
         gaps_[i]->SetGapIndex(i);
     }
 
@@ -164,6 +165,26 @@ void OpticalAssembly::Clear()
     }
 
     num_surfs_ = 0;
+    revision_ = RevisionCounter::Next();
+}
+
+void OpticalAssembly::CopyFrom(const OpticalAssembly &other)
+{
+    Clear();
+
+    interfaces_.reserve(other.interfaces_.size());
+    for(const auto &s : other.interfaces_){
+        interfaces_.push_back(s->Clone());
+    }
+
+    gaps_.reserve(other.gaps_.size());
+    for(const auto &g : other.gaps_){
+        gaps_.push_back(g->Clone());
+    }
+
+    stop_index_            = other.stop_index_;
+    current_surface_index_ = other.current_surface_index_;
+    num_surfs_             = other.num_surfs_;
 }
 
 void OpticalAssembly::CreateMinimumAssembly()
@@ -199,6 +220,7 @@ void OpticalAssembly::CreateMinimumAssembly()
     current_surface_index_ = 2;
 
     num_surfs_ = interfaces_.size();
+    revision_ = RevisionCounter::Next();
 }
 
 
@@ -225,6 +247,7 @@ void OpticalAssembly::Insert(int i)
         current_surface_index_ = interfaces_.size() -1;
 
         num_surfs_ = interfaces_.size();
+        revision_ = RevisionCounter::Next();
 
     }else{
         this->Insert(i, std::numeric_limits<double>::infinity(), 0.0, "AIR");
@@ -283,6 +306,7 @@ void OpticalAssembly::Insert(int i, double r, double t, const std::string &mat_n
     current_surface_index_ = i;
 
     num_surfs_ = interfaces_.size();
+    revision_ = RevisionCounter::Next();
 }
 
 void OpticalAssembly::Remove(int i)
@@ -305,10 +329,23 @@ void OpticalAssembly::Remove(int i)
         if (i < current_surface_index_){
             current_surface_index_ -= 1;
         }
+        revision_ = RevisionCounter::Next();
     }
     num_surfs_ = interfaces_.size();
 }
 
+uint64_t OpticalAssembly::Revision() const
+{
+    uint64_t rev = revision_;
+    for(const auto &s : interfaces_){
+        rev = std::max(rev, s->Revision());
+    }
+    for(const auto &g : gaps_){
+        rev = std::max(rev, g->Revision());
+    }
+    return rev;
+}
+
 
 void OpticalAssembly::SetLocalTransforms()
 {
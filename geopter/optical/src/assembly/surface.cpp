@@ -45,6 +45,8 @@ Surface::Surface()
     solve_ = nullptr;
 
     decenter_ = nullptr;
+
+    revision_ = RevisionCounter::Next();
 }
 
 
@@ -53,6 +55,31 @@ Surface::~Surface()
     solve_.reset();
 }
 
+std::unique_ptr<Surface> Surface::Clone() const
+{
+    auto srf = std::make_unique<Surface>();
+
+    srf->label_          = label_;
+    srf->interact_mode_  = interact_mode_;
+    srf->semi_diameter_  = semi_diameter_;
+    srf->profile_        = profile_;
+    srf->clear_aperture_ = clear_aperture_;
+    srf->lcl_tfrm_       = lcl_tfrm_;
+    srf->gbl_tfrm_       = gbl_tfrm_;
+
+    if(decenter_){
+        srf->decenter_ = std::make_unique<DecenterData>(*decenter_);
+    }
+    if(solve_){
+        srf->solve_ = solve_->Clone();
+    }
+
+    // the copy is identical, so it keeps the stamps of the original
+    srf->revision_ = revision_;
+
+    return srf;
+}
+
 std::string Surface::ApertureShape() const
 {
     return std::visit([](auto ap){ return ap.ShapeName() ;}, clear_aperture_);
@@ -67,6 +94,16 @@ double Surface::MaxAperture() const
 void Surface::RemoveClearAperture()
 {
     clear_aperture_ = Aperture<NoneAperture>();
+    revision_ = RevisionCounter::Next();
+}
+
+void Surface::SetLocalTransform(const Transformation &tfrm)
+{
+    // SetLocalTransforms() rewrites every surface on each update, so only actual changes are stamped
+    if(tfrm.rotation != lcl_tfrm_.rotation || tfrm.transfer != lcl_tfrm_.transfer){
+        lcl_tfrm_ = tfrm;
+        revision_ = RevisionCounter::Next();
+    }
 }
 
 
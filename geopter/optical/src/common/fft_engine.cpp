@@ -0,0 +1,200 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#include <algorithm>
+#include <vector>
+#include <complex>
+
+#include "common/fft_engine.h"
+#include "common/thread_pool.h"
+#include "unsupported/Eigen/FFT"
+
+using namespace geopter;
+
+namespace {
+
+typedef std::complex<double> Complex;
+
+/** Per thread transform objects and line buffers */
+struct FftWorkspace
+{
+    FftWorkspace(){
+        real_fft.SetFlag(Eigen::FFT<double>::HalfSpectrum);
+        cpx_fft.SetFlag(Eigen::FFT<double>::Unscaled);
+        real_fft.SetFlag(Eigen::FFT<double>::Unscaled);
+    }
+
+    Eigen::FFT<double> cpx_fft;
+    Eigen::FFT<double> real_fft;
+    std::vector<Complex> line_in;
+    std::vector<Complex> line_out;
+};
+
+FftWorkspace& Workspace()
+{
+    thread_local FftWorkspace ws;
+    return ws;
+}
+
+/** Call fn(line) for each line in [0, num_lines), in parallel blocks when the work is large enough */
+template<class F>
+void ForEachLine(int num_lines, int line_length, const F& fn)
+{
+    constexpr long long min_parallel_work = 64*64;
+
+    ThreadPool* pool = ThreadPool::Global();
+    const int num_threads = pool->NumberOfThreads();
+
+    if(num_threads == 1 || (long long)num_lines*line_length < min_parallel_work){
+        for(int i = 0; i < num_lines; i++){
+            fn(i);
+        }
+        return;
+    }
+
+    const int num_blocks = std::min(num_lines, 4*num_threads);
+    pool->ParallelFor(num_blocks, [&](int b){
+        const int begin = (long long)num_lines*b/num_blocks;
+        const int end   = (long long)num_lines*(b+1)/num_blocks;
+        for(int i = begin; i < end; i++){
+            fn(i);
+        }
+    });
+}
+
+/** Complex transform along each row, which is strided in column-major storage */
+void TransformRows(Complex* data, int rows, int cols, bool inverse)
+{
+    // the unscaled transform of a single sample is the sample itself, and kissfft does not accept that length
+    if(cols == 1){
+        return;
+    }
+
+    ForEachLine(rows, cols, [=](int r){
+        FftWorkspace& ws = Workspace();
+        ws.line_in.resize(cols);
+        ws.line_out.resize(cols);
+        for(int c = 0; c < cols; c++){
+            ws.line_in[c] = data[(size_t)c*rows + r];
+        }
+        if(inverse){
+            ws.cpx_fft.inv(ws.line_out.data(), ws.line_in.data(), cols);
+        }else{
+            ws.cpx_fft.fwd(ws.line_out.data(), ws.line_in.data(), cols);
+        }
+        for(int c = 0; c < cols; c++){
+            data[(size_t)c*rows + r] = ws.line_out[c];
+        }
+    });
+}
+
+/** Complex transform along each column, contiguous in column-major storage */
+void TransformCols(Complex* data, int rows, int cols, bool inverse)
+{
+    if(rows == 1){
+        return;
+    }
+
+    ForEachLine(cols, rows, [=](int c){
+        FftWorkspace& ws = Workspace();
+        ws.line_out.resize(rows);
+        Complex* col = data + (size_t)c*rows;
+        if(inverse){
+            ws.cpx_fft.inv(ws.line_out.data(), col, rows);
+        }else{
+            ws.cpx_fft.fwd(ws.line_out.data(), col, rows);
+        }
+        std::copy(ws.line_out.begin(), ws.line_out.end(), col);
+    });
+}
+
+} // namespace
+
+
+void FftEngine::Forward(Eigen::MatrixXcd &data)
+{
+    const int rows = data.rows();
+    const int cols = data.cols();
+
+    TransformRows(data.data(), rows, cols, false);
+    TransformCols(data.data(), rows, cols, false);
+}
+
+void FftEngine::Inverse(Eigen::MatrixXcd &data)
+{
+    const int rows = data.rows();
+    const int cols = data.cols();
+
+    TransformRows(data.data(), rows, cols, true);
+    TransformCols(data.data(), rows, cols, true);
+
+    data /= static_cast<double>(rows)*static_cast<double>(cols);
+}
+
+void FftEngine::ForwardReal(Eigen::MatrixXcd &out, const Eigen::MatrixXd &in)
+{
+    const int rows = in.rows();
+    const int cols = in.cols();
+    const int half_rows = rows/2 + 1;
+
+    out.resize(half_rows, cols);
+
+    const double* src = in.data();
+    Complex* dst = out.data();
+
+    if(rows == 1){
+        out = in.cast<Complex>();
+    }else{
+        ForEachLine(cols, rows, [=](int c){
+            Workspace().real_fft.fwd(dst + (size_t)c*half_rows, src + (size_t)c*rows, rows);
+        });
+    }
+
+    TransformRows(out.data(), half_rows, cols, false);
+}
+
+void FftEngine::InverseReal(Eigen::MatrixXd &out, const Eigen::MatrixXcd &in, int rows)
+{
+    const int half_rows = in.rows();
+    const int cols = in.cols();
+
+    Eigen::MatrixXcd spectrum = in;
+    TransformRows(spectrum.data(), half_rows, cols, true);
+
+    out.resize(rows, cols);
+
+    const Complex* src = spectrum.data();
+    double* dst = out.data();
+
+    if(rows == 1){
+        out = spectrum.real();
+    }else{
+        ForEachLine(cols, rows, [=](int c){
+            Workspace().real_fft.inv(dst + (size_t)c*rows, src + (size_t)c*half_rows, rows);
+        });
+    }
+
+    out /= static_cast<double>(rows)*static_cast<double>(cols);
+}
@@ -0,0 +1,245 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <iterator>
+
+#include "common/thread_pool.h"
+
+using namespace geopter;
+
+std::unique_ptr<ThreadPool> ThreadPool::global_;
+std::mutex ThreadPool::global_mtx_;
+
+struct ThreadPool::Batch
+{
+    int remaining;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::exception_ptr error;
+};
+
+
+ThreadPool::ThreadPool(int num_threads) :
+    pending_(0),
+    next_queue_(0),
+    stop_(false)
+{
+    if(num_threads <= 0){
+        num_threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+
+    const int num_workers = num_threads - 1;
+
+    for(int i = 0; i < num_workers; i++){
+        queues_.push_back(std::make_unique<WorkQueue>());
+    }
+
+    for(int i = 0; i < num_workers; i++){
+        workers_.emplace_back(&ThreadPool::WorkerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lk(wake_mtx_);
+        stop_ = true;
+    }
+    wake_cv_.notify_all();
+
+    for(auto &w : workers_){
+        w.join();
+    }
+}
+
+void ThreadPool::ParallelFor(int n, const std::function<void(int)>& fn)
+{
+    if(n <= 0){
+        return;
+    }
+
+    if(workers_.empty() || n == 1){
+        for(int i = 0; i < n; i++){
+            fn(i);
+        }
+        return;
+    }
+
+    Batch batch;
+    batch.remaining = n;
+
+    // contiguous blocks of indices per queue, starting from a rotating queue
+    const int num_queues = queues_.size();
+    const unsigned int first = next_queue_.fetch_add(1);
+    for(int q = 0; q < num_queues; q++){
+        const int begin = static_cast<long long>(n) * q / num_queues;
+        const int end   = static_cast<long long>(n) * (q + 1) / num_queues;
+        if(begin == end){
+            continue;
+        }
+        WorkQueue* queue = queues_[(first + q) % num_queues].get();
+        std::lock_guard<std::mutex> lk(queue->mtx);
+        for(int i = begin; i < end; i++){
+            queue->tasks.push_back(Task{&fn, i, &batch});
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(wake_mtx_);
+        pending_ += n;
+    }
+    wake_cv_.notify_all();
+
+    // help until the batch is done
+    Task task;
+    while(true){
+        {
+            std::unique_lock<std::mutex> lk(batch.mtx);
+            if(batch.remaining == 0){
+                break;
+            }
+        }
+
+        if(Steal(first, task, &batch)){
+            Run(task);
+        }else{
+            std::unique_lock<std::mutex> lk(batch.mtx);
+            batch.cv.wait_for(lk, std::chrono::milliseconds(1), [&batch]{ return batch.remaining == 0; });
+        }
+    }
+
+    if(batch.error){
+        std::rethrow_exception(batch.error);
+    }
+}
+
+void ThreadPool::WorkerLoop(int id)
+{
+    Task task;
+
+    while(true){
+        if(PopOwn(id, task) || Steal(id + 1, task)){
+            Run(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lk(wake_mtx_);
+        wake_cv_.wait(lk, [this]{ return stop_ || pending_.load() > 0; });
+        if(stop_){
+            return;
+        }
+    }
+}
+
+bool ThreadPool::PopOwn(int id, Task &task)
+{
+    WorkQueue* queue = queues_[id].get();
+    std::lock_guard<std::mutex> lk(queue->mtx);
+    if(queue->tasks.empty()){
+        return false;
+    }
+
+    task = queue->tasks.front();
+    queue->tasks.pop_front();
+    pending_--;
+    return true;
+}
+
+bool ThreadPool::Steal(int first, Task &task, const Batch* batch)
+{
+    const int num_queues = queues_.size();
+
+    for(int q = 0; q < num_queues; q++){
+        WorkQueue* queue = queues_[(first + q) % num_queues].get();
+        std::lock_guard<std::mutex> lk(queue->mtx);
+        if(queue->tasks.empty()){
+            continue;
+        }
+
+        if(!batch){
+            task = queue->tasks.back();
+            queue->tasks.pop_back();
+            pending_--;
+            return true;
+        }
+
+        // only the tasks of the waiting batch, searched from the back where the recent batches are
+        for(auto itr = queue->tasks.rbegin(); itr != queue->tasks.rend(); ++itr){
+            if(itr->batch == batch){
+                task = *itr;
+                queue->tasks.erase(std::next(itr).base());
+                pending_--;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::Run(const Task &task)
+{
+    std::exception_ptr error;
+    try{
+        (*task.fn)(task.index);
+    }catch(...){
+        error = std::current_exception();
+    }
+
+    // The batch lives on the caller's stack. It must not be touched after the last unlock.
+    Batch* batch = task.batch;
+    std::lock_guard<std::mutex> lk(batch->mtx);
+    if(error && !batch->error){
+        batch->error = error;
+    }
+    batch->remaining--;
+    if(batch->remaining == 0){
+        batch->cv.notify_all();
+    }
+}
+
+ThreadPool* ThreadPool::Global()
+{
+    std::lock_guard<std::mutex> lk(global_mtx_);
+    if(!global_){
+        global_ = std::make_unique<ThreadPool>(0);
+    }
+    return global_.get();
+}
+
+void ThreadPool::SetGlobalThreadCount(int num_threads)
+{
+    std::lock_guard<std::mutex> lk(global_mtx_);
+    global_.reset();
+    global_ = std::make_unique<ThreadPool>(num_threads);
+}
+
+int ThreadPool::GlobalThreadCount()
+{
+    return Global()->NumberOfThreads();
+}
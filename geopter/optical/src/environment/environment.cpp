@@ -24,27 +24,32 @@
 ********************************************************************************/
 
 #include "environment/environment.h"
+#include "common/revision_counter.h"
 
 
 using namespace geopter;
 
 double Environment::temperature_ = 25;
 double Environment::pressure_ = 101325.0;
+std::atomic<uint64_t> Environment::revision_(0);
 
 Environment::Environment()
 {
     temperature_ = 25;
     pressure_ = 101325.0;
+    revision_ = RevisionCounter::Next();
 }
 
 void Environment::SetTemperature(double t)
 {
     temperature_ = t;
+    revision_ = RevisionCounter::Next();
 }
 
 void Environment::SetAirPressure(double p)
 {
     pressure_ = p;
+    revision_ = RevisionCounter::Next();
 }
 
 double Environment::Temperature()
@@ -57,3 +62,7 @@ double Environment::AirPressure()
     return pressure_;
 }
 
+uint64_t Environment::Revision()
+{
+    return revision_;
+}
@@ -0,0 +1,144 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#include "material/dispersion_formula.h"
+
+using namespace geopter;
+
+namespace {
+
+using Type = DispersionFormula::Type;
+
+/** Formulas written on powers of lambda^2, matching the scalar functions in DispersionFormula */
+template<Type T>
+inline double Formula(double l, const double* c)
+{
+    const double l2  = l*l;
+    const double il2 = 1.0/l2;
+
+    if constexpr (T == Type::Schott){
+        return sqrt( c[0] + c[1]*l2 + il2*(c[2] + il2*(c[3] + il2*(c[4] + il2*c[5]))) );
+    }else if constexpr (T == Type::Sellmeier1){
+        return sqrt( 1 + c[0]*l2/(l2-c[1]) + c[2]*l2/(l2-c[3]) + c[4]*l2/(l2-c[5]) );
+    }else if constexpr (T == Type::Herzberger){
+        const double L = 1/(l2-0.028);
+        return ( c[0] + c[1]*L + c[2]*L*L + l2*(c[3] + l2*(c[4] + l2*c[5])) );
+    }else if constexpr (T == Type::Sellmeier2){
+        return sqrt( 1 + c[0] + c[1]*l2/(l2-c[2]) + c[3]*l2/(l2-c[4]) );
+    }else if constexpr (T == Type::Conrady){
+        return ( c[0] + c[1]/l + c[2]/(l2*l*sqrt(l)) );
+    }else if constexpr (T == Type::Sellmeier3){
+        return sqrt( 1 + c[0]*l2/(l2-c[1]) + c[2]*l2/(l2-c[3]) + c[4]*l2/(l2-c[5]) + c[6]*l2/(l2-c[7]) );
+    }else if constexpr (T == Type::HandbookOfOptics1){
+        return sqrt( c[0] + c[1]/(l2-c[2]) - c[3]*l2 );
+    }else if constexpr (T == Type::HandbookOfOptics2){
+        return sqrt( c[0] + c[1]*l2/(l2-c[2]) - c[3]*l2 );
+    }else if constexpr (T == Type::Sellmeier4){
+        return sqrt( c[0] + c[1]*l2/(l2-c[2]) + c[3]*l2/(l2-c[4]) );
+    }else if constexpr (T == Type::Extended1){
+        return sqrt( c[0] + c[1]*l2 + il2*(c[2] + il2*(c[3] + il2*(c[4] + il2*(c[5] + il2*(c[6] + il2*c[7]))))) );
+    }else if constexpr (T == Type::Sellmeier5){
+        return sqrt( 1 + c[0]*l2/(l2-c[1]) + c[2]*l2/(l2-c[3]) + c[4]*l2/(l2-c[5]) + c[6]*l2/(l2-c[7]) + c[8]*l2/(l2-c[9]) );
+    }else if constexpr (T == Type::Extended2){
+        return sqrt( c[0] + c[1]*l2 + l2*l2*(c[6] + l2*c[7]) + il2*(c[2] + il2*(c[3] + il2*(c[4] + il2*c[5]))) );
+    }else if constexpr (T == Type::Nikon_Hikari){
+        // lambda^-8 appears twice, as in the scalar formula
+        return sqrt( c[0] + l2*(c[1] + l2*c[2]) + il2*(c[3] + il2*il2*(c[4] + il2*(c[5] + c[6] + il2*(c[7] + il2*c[8])))) );
+    }else{
+        return 1.0;
+    }
+}
+
+template<Type T>
+void EvaluateWavelengths(const std::vector<double>& coefs, const double* lambdamicron, double* n, int count)
+{
+    // local copy so that the compiler knows the coefficients do not alias the output
+    double c[12] = {};
+    for(int k = 0; k < 12 && k < (int)coefs.size(); k++){
+        c[k] = coefs[k];
+    }
+
+    for(int i = 0; i < count; i++){
+        n[i] = Formula<T>(lambdamicron[i], c);
+    }
+}
+
+template<Type T>
+void EvaluateGlasses(const double* coefs, int stride, double lambdamicron, double* n, int count)
+{
+    for(int i = 0; i < count; i++){
+        n[i] = Formula<T>(lambdamicron, coefs + (size_t)i*stride);
+    }
+}
+
+template<template<Type> class Fn, typename... Args>
+void Dispatch(Type type, Args... args)
+{
+    switch (type) {
+    case Type::Schott:            Fn<Type::Schott>()(args...);            break;
+    case Type::Sellmeier1:        Fn<Type::Sellmeier1>()(args...);        break;
+    case Type::Herzberger:        Fn<Type::Herzberger>()(args...);        break;
+    case Type::Sellmeier2:        Fn<Type::Sellmeier2>()(args...);        break;
+    case Type::Conrady:           Fn<Type::Conrady>()(args...);           break;
+    case Type::Sellmeier3:        Fn<Type::Sellmeier3>()(args...);        break;
+    case Type::HandbookOfOptics1: Fn<Type::HandbookOfOptics1>()(args...); break;
+    case Type::HandbookOfOptics2: Fn<Type::HandbookOfOptics2>()(args...); break;
+    case Type::Sellmeier4:        Fn<Type::Sellmeier4>()(args...);        break;
+    case Type::Extended1:         Fn<Type::Extended1>()(args...);         break;
+    case Type::Sellmeier5:        Fn<Type::Sellmeier5>()(args...);        break;
+    case Type::Extended2:         Fn<Type::Extended2>()(args...);         break;
+    case Type::Nikon_Hikari:      Fn<Type::Nikon_Hikari>()(args...);      break;
+    default:                      Fn<Type::Unknown>()(args...);
+    }
+}
+
+template<Type T>
+struct WavelengthLoop
+{
+    void operator()(const std::vector<double>* coefs, const double* lambdamicron, double* n, int count) const {
+        EvaluateWavelengths<T>(*coefs, lambdamicron, n, count);
+    }
+};
+
+template<Type T>
+struct GlassLoop
+{
+    void operator()(const double* coefs, int stride, double lambdamicron, double* n, int count) const {
+        EvaluateGlasses<T>(coefs, stride, lambdamicron, n, count);
+    }
+};
+
+} // namespace
+
+
+void DispersionFormula::Evaluate(Type type, const std::vector<double> &c, const double *lambdamicron, double *n, int count)
+{
+    Dispatch<WavelengthLoop>(type, &c, lambdamicron, n, count);
+}
+
+void DispersionFormula::Evaluate(Type type, const double *coefs, int stride, double lambdamicron, double *n, int count)
+{
+    Dispatch<GlassLoop>(type, coefs, stride, lambdamicron, n, count);
+}
@@ -40,11 +40,16 @@
 using namespace geopter;
 
 Glass::Glass() : Material(),
-    formula_func_ptr_(nullptr)
+    formula_func_ptr_(nullptr),
+    formula_type_(DispersionFormula::Type::None),
+    index_cache_revision_(0)
 {
     constexpr int knum_coefs = 12;
     coefs_ = std::vector<double>(knum_coefs, 0.0);
 
+    // no thermal effect unless TD data are given. 20 degC is the AGF default reference.
+    D0_ = D1_ = D2_ = E0_ = E1_ = Ltk_ = 0.0;
+    Tref_ = 20.0;
     Pref_ = 101325.0;
 }
 
@@ -57,13 +62,81 @@ Glass::~Glass()
 
 double Glass::RefractiveIndex(double wv_nm) const
 {
-    if(formula_func_ptr_){
-        double lambdainput = wv_nm/1000.0;
-        double lambdarel = RelativeWavelength(lambdainput, Environment::Temperature(), Environment::AirPressure());
-        return RefractiveIndexRel(lambdarel);
-    }else{
+    if(!formula_func_ptr_){
         return 1.0;
     }
+
+    // analyses and solves ask for the same few wavelengths over and over
+    constexpr size_t max_cache_size = 32;
+
+    const double T = Environment::Temperature();
+    const double P = Environment::AirPressure();
+    uint64_t rev;
+
+    {
+        std::lock_guard<std::mutex> lk(index_cache_mtx_);
+        if(index_cache_revision_ != revision_){
+            index_cache_.clear();
+            index_cache_revision_ = revision_;
+        }
+        rev = index_cache_revision_;
+        for(const auto& e : index_cache_){
+            if(e.wv_nm == wv_nm && e.temperature == T && e.pressure == P){
+                return e.index;
+            }
+        }
+    }
+
+    const double n = ComputeRefractiveIndex(wv_nm, T, P);
+
+    std::lock_guard<std::mutex> lk(index_cache_mtx_);
+    if(index_cache_revision_ == rev){
+        if(index_cache_.size() >= max_cache_size){
+            index_cache_.erase(index_cache_.begin());
+        }
+        index_cache_.push_back(IndexCacheEntry{wv_nm, T, P, n});
+    }
+
+    return n;
+}
+
+double Glass::ComputeRefractiveIndex(double wv_nm, double T, double P) const
+{
+    double lambdainput = wv_nm/1000.0;
+    double lambdarel = RelativeWavelength(lambdainput, T, P);
+    return RefractiveIndexRel(lambdarel);
+}
+
+std::vector<double> Glass::RefractiveIndices(const std::vector<double> &wvls_nm) const
+{
+    const int num_wvls = wvls_nm.size();
+    std::vector<double> n(num_wvls, 1.0);
+
+    if(!formula_func_ptr_){
+        return n;
+    }
+
+    const double T = Environment::Temperature();
+    const double P = Environment::AirPressure();
+
+    std::vector<double> lambdarel(num_wvls);
+    for(int i = 0; i < num_wvls; i++){
+        lambdarel[i] = RelativeWavelength(wvls_nm[i]/1000.0, T, P);
+    }
+
+    // relative index at the reference temperature, shared by the absolute index and the thermal change
+    std::vector<double> n_rel_Tref(num_wvls);
+    DispersionFormula::Evaluate(formula_type_, coefs_, lambdarel.data(), n_rel_Tref.data(), num_wvls);
+
+    constexpr double P0 = 101325.0;
+    for(int i = 0; i < num_wvls; i++){
+        const double wvl = lambdarel[i];
+        const double n_abs_T0 = n_rel_Tref[i]*Air::RefractiveIndexAbs(wvl, Tref_, P0);
+        const double n_abs = n_abs_T0 + ThermalIndexChange(wvl, T, n_rel_Tref[i]);
+        n[i] = n_abs/Air::RefractiveIndexAbs(wvl, T);
+    }
+
+    return n;
 }
 
 
@@ -73,57 +146,74 @@ void Glass::SetDispersionFormula(int i)
     switch (i) {
     case 1:
         formula_func_ptr_ = &(DispersionFormula::Schott);
+        formula_type_ = DispersionFormula::Type::Schott;
         break;
     case 2:
         formula_func_ptr_ = &(DispersionFormula::Sellmeier1);
+        formula_type_ = DispersionFormula::Type::Sellmeier1;
         break;
     case 3:
         formula_func_ptr_ = &(DispersionFormula::Herzberger);
+        formula_type_ = DispersionFormula::Type::Herzberger;
         break;
     case 4:
         formula_func_ptr_ = &(DispersionFormula::Sellmeier2);
+        formula_type_ = DispersionFormula::Type::Sellmeier2;
         break;
     case 5:
         formula_func_ptr_ = &(DispersionFormula::Conrady);
+        formula_type_ = DispersionFormula::Type::Conrady;
         break;
     case 6:
         formula_func_ptr_ = &(DispersionFormula::Sellmeier3);
+        formula_type_ = DispersionFormula::Type::Sellmeier3;
         break;
     case 7:
         formula_func_ptr_ = &(DispersionFormula::HandbookOfOptics1);
+        formula_type_ = DispersionFormula::Type::HandbookOfOptics1;
         break;
     case 8:
         formula_func_ptr_ = &(DispersionFormula::HandbookOfOptics2);
+        formula_type_ = DispersionFormula::Type::HandbookOfOptics2;
         break;
     case 9:
         formula_func_ptr_ = &(DispersionFormula::Sellmeier4);
+        formula_type_ = DispersionFormula::Type::Sellmeier4;
         break;
     case 10:
         formula_func_ptr_ = &(DispersionFormula::Extended1);
+        formula_type_ = DispersionFormula::Type::Extended1;
         break;
     case 11:
         formula_func_ptr_ = &(DispersionFormula::Sellmeier5);
+        formula_type_ = DispersionFormula::Type::Sellmeier5;
         break;
     case 12:
         formula_func_ptr_ = &(DispersionFormula::Extended2);
+        formula_type_ = DispersionFormula::Type::Extended2;
         break;
     case 13: // Unknown
         if(StringTool::Contains(supplier_name_, "HIKARI")){
             formula_func_ptr_ = &(DispersionFormula::Nikon_Hikari);
+            formula_type_ = DispersionFormula::Type::Nikon_Hikari;
         }else{
             formula_func_ptr_ = &(DispersionFormula::Unknown);
+            formula_type_ = DispersionFormula::Type::Unknown;
         }
         break;
     default:
         formula_func_ptr_ = nullptr;
+        formula_type_ = DispersionFormula::Type::None;
     }
 
+    revision_ = RevisionCounter::Next();
 }
 
 void Glass::SetDispersionCoefs(int i, double val)
 {
     if(i < (int)coefs_.size()){
         coefs_[i] = val;
+        revision_ = RevisionCounter::Next();
     }else{
         return;
     }
@@ -198,6 +288,7 @@ void Glass::SetThermalData(double D0, double D1, double D2, double E0, double E1
     E1_ = E1;
     Ltk_  = Ltk;
     Tref_ = Tref;
+    revision_ = RevisionCounter::Next();
 }
 
 double Glass::DnDtAbs(double wvl_micron, double t) const
@@ -210,10 +301,14 @@ double Glass::DnDtAbs(double wvl_micron, double t) const
 }
 
 double Glass::Delta_n_Abs(double wvl_micron, double t) const
+{
+    return ThermalIndexChange(wvl_micron, t, RefractiveIndexRel_Tref(wvl_micron));
+}
+
+double Glass::ThermalIndexChange(double wvl_micron, double t, double n) const
 {
     double dT = t - Tref_;
     double Stk = (Ltk_ > 0.0) - (Ltk_ < 0.0);
-    double n  = RefractiveIndexRel_Tref(wvl_micron);
 
     // Zemax manual
     return (n*n-1)/(2*n) * ( D0_*dT + D1_*dT*dT + D2_*dT*dT*dT + (E0_*dT + E1_*dT*dT)/(wvl_micron*wvl_micron - Stk*Ltk_*Ltk_) );
@@ -28,6 +28,9 @@
 #include <fstream>
 #include <sstream>
 #include <filesystem>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
 
 #include "material/glass_catalog.h"
 #include "common/string_tool.h"
@@ -36,6 +39,223 @@
 
 using namespace geopter;
 
+bool GlassCatalog::cache_enabled_ = true;
+std::string GlassCatalog::cache_dir_;
+
+namespace {
+
+/** Glass data as stored in AGF files */
+struct GlassRecord
+{
+    static constexpr int num_coefs = 12;
+    static constexpr int num_thermal_data = 7;
+
+    std::string name;
+    int formula = 0;
+    double coefs[num_coefs] = {};
+    bool has_thermal_data = false;
+    double thermal_data[num_thermal_data] = {}; // D0, D1, D2, E0, E1, Ltk, Tref
+};
+
+/** Source file stamps used to validate the binary cache */
+struct CacheHeader
+{
+    uint64_t source_size;
+    int64_t  source_mtime;
+    uint64_t source_hash;
+};
+
+constexpr char cache_magic[8] = {'G','E','O','A','G','F','C','1'};
+
+/** 64-bit FNV-1a */
+uint64_t Fnv1a(const char* data, size_t size)
+{
+    uint64_t h = 14695981039346656037ULL;
+    for(size_t i = 0; i < size; i++){
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+void ParseAgf(const std::string& text, std::vector<GlassRecord>& records)
+{
+    std::istringstream iss(text);
+    std::string line_str;
+
+    while(getline(iss,line_str))
+    {
+        if(StringTool::StartsWith(line_str, "NM"))
+        {
+            //NM <glass name> <dispersion formula #> <MIL#> <N(d)> <V(d)> <Exclude Sub> <status> <melt freq>
+
+            std::vector<std::string> line_parts = StringTool::Split(line_str,' ');
+            GlassRecord rec;
+            rec.name = line_parts[1];
+            std::transform(rec.name.begin(), rec.name.end(), rec.name.begin(), ::toupper);
+            rec.formula = atoi(line_parts[2].c_str());
+            records.push_back(std::move(rec));
+        }
+        else if(records.empty())
+        {
+            continue;
+        }
+        else if(StringTool::StartsWith(line_str, "CD"))
+        {
+            // CD <dispersion coefficients 1 - 10>
+
+            std::vector<std::string> line_parts = StringTool::Split(line_str,' ');
+            for(int i = 1; i < (int)line_parts.size() && i <= GlassRecord::num_coefs; i++){
+                double val;
+                try {
+                    val = std::stod(line_parts[i]);
+                }  catch (...) {
+                    val = 0.0;
+                }
+                records.back().coefs[i-1] = val;
+            }
+        }
+        else if(StringTool::StartsWith(line_str, "TD"))
+        {
+            std::vector<std::string> line_parts = StringTool::Split(line_str,' ');
+            if(line_parts.size() >= 8){
+                for(int i = 0; i < GlassRecord::num_thermal_data; i++){
+                    records.back().thermal_data[i] = std::stod(line_parts[i+1]);
+                }
+                records.back().has_thermal_data = true;
+            }
+        }
+    }
+}
+
+template<typename T>
+void Append(std::string& buf, const T& val)
+{
+    buf.append(reinterpret_cast<const char*>(&val), sizeof(T));
+}
+
+template<typename T>
+bool Extract(const std::string& buf, size_t& pos, T& val)
+{
+    if(pos + sizeof(T) > buf.size()){
+        return false;
+    }
+    std::memcpy(&val, buf.data() + pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+}
+
+/**
+ * Layout: magic, header, payload hash, payload
+ * payload: number of glasses, then for each glass: name length, name, formula, coefficients, thermal flag, thermal data
+ */
+bool WriteBinaryCache(const std::string& cache_path, const CacheHeader& header, const std::vector<GlassRecord>& records)
+{
+    std::string payload;
+    Append(payload, static_cast<uint32_t>(records.size()));
+    for(auto &rec : records){
+        Append(payload, static_cast<uint32_t>(rec.name.size()));
+        payload.append(rec.name);
+        Append(payload, static_cast<int32_t>(rec.formula));
+        for(double c : rec.coefs){
+            Append(payload, c);
+        }
+        Append(payload, static_cast<uint8_t>(rec.has_thermal_data));
+        for(double td : rec.thermal_data){
+            Append(payload, td);
+        }
+    }
+
+    std::string buf(cache_magic, sizeof(cache_magic));
+    Append(buf, header);
+    Append(buf, Fnv1a(payload.data(), payload.size()));
+    buf.append(payload);
+
+    // write aside and rename, so that other processes never see a partial file
+    const std::string tmp_path = cache_path + ".tmp";
+    {
+        std::ofstream ofs(tmp_path, std::ios::binary | std::ios::trunc);
+        if(!ofs.is_open()){
+            return false;
+        }
+        ofs.write(buf.data(), buf.size());
+        if(!ofs){
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, cache_path, ec);
+    if(ec){
+        std::filesystem::remove(tmp_path, ec);
+        return false;
+    }
+    return true;
+}
+
+bool ReadBinaryCache(const std::string& cache_path, CacheHeader& header, std::vector<GlassRecord>& records)
+{
+    std::ifstream ifs(cache_path, std::ios::binary | std::ios::ate);
+    if(!ifs.is_open()){
+        return false;
+    }
+
+    // whole file in one read
+    std::string buf(static_cast<size_t>(ifs.tellg()), '\0');
+    ifs.seekg(0);
+    if(!ifs.read(&buf[0], buf.size())){
+        return false;
+    }
+
+    if(buf.size() < sizeof(cache_magic) || buf.compare(0, sizeof(cache_magic), cache_magic, sizeof(cache_magic)) != 0){
+        return false;
+    }
+
+    size_t pos = sizeof(cache_magic);
+    uint64_t payload_hash;
+    if(!Extract(buf, pos, header) || !Extract(buf, pos, payload_hash)){
+        return false;
+    }
+    if(payload_hash != Fnv1a(buf.data() + pos, buf.size() - pos)){
+        return false;
+    }
+
+    uint32_t num_glasses;
+    if(!Extract(buf, pos, num_glasses)){
+        return false;
+    }
+
+    records.resize(num_glasses);
+    for(auto &rec : records){
+        uint32_t name_len;
+        int32_t formula;
+        uint8_t has_thermal_data;
+        if(!Extract(buf, pos, name_len) || pos + name_len > buf.size()){
+            return false;
+        }
+        rec.name.assign(buf, pos, name_len);
+        pos += name_len;
+
+        bool ok = Extract(buf, pos, formula);
+        for(double &c : rec.coefs){
+            ok = ok && Extract(buf, pos, c);
+        }
+        ok = ok && Extract(buf, pos, has_thermal_data);
+        for(double &td : rec.thermal_data){
+            ok = ok && Extract(buf, pos, td);
+        }
+        if(!ok){
+            return false;
+        }
+        rec.formula = formula;
+        rec.has_thermal_data = (has_thermal_data != 0);
+    }
+
+    return true;
+}
+
+} // namespace
+
 GlassCatalog::GlassCatalog() :
     name_("")
 {
@@ -57,16 +277,11 @@ int GlassCatalog::NumberOfGlasses() const
     return (int)glasses_.size();
 }
 
-std::shared_ptr<Glass> GlassCatalog::GetGlass(std::string product_name)
+std::shared_ptr<Glass> GlassCatalog::GetGlass(const std::string& product_name) const
 {
-    if(!glasses_.empty())
-    {
-        for(auto &g : glasses_)
-        {
-            if(g->ProductName() == product_name){
-                return g;
-            }
-        }
+    auto itr = name_index_.find(product_name);
+    if(itr != name_index_.end()){
+        return itr->second;
     }
 
     return nullptr;
@@ -86,16 +301,17 @@ void GlassCatalog::Clear()
         }
         glasses_.clear();
     }
+    name_index_.clear();
 }
 
 bool GlassCatalog::LoadAgf(std::string agf_path)
 {
-    std::ifstream ifs(agf_path);
-    std::string line_str;
-
-    if(!ifs.is_open()){
+    std::error_code ec;
+    const uint64_t src_size  = std::filesystem::file_size(agf_path, ec);
+    if(ec){
         return false;
     }
+    const int64_t  src_mtime = std::filesystem::last_write_time(agf_path, ec).time_since_epoch().count();
 
     Clear();
 
@@ -103,63 +319,77 @@ bool GlassCatalog::LoadAgf(std::string agf_path)
     std::filesystem::path p = agf_path;
     name_ = p.stem().u8string();
     std::transform(name_.begin(), name_.end(), name_.begin(), ::toupper); // all-uppercase
-    std::string supplier = name_;
 
+    const std::string cache_path = CachePath(agf_path);
 
-    while(getline(ifs,line_str))
+    std::vector<GlassRecord> records;
+    CacheHeader cache_header;
+    const bool has_cache = cache_enabled_ && ReadBinaryCache(cache_path, cache_header, records);
+
+    if( !(has_cache && cache_header.source_size == src_size && cache_header.source_mtime == src_mtime) )
     {
-        if(StringTool::StartsWith(line_str, "NM"))
-        {
-            //NM <glass name> <dispersion formula #> <MIL#> <N(d)> <V(d)> <Exclude Sub> <status> <melt freq>
+        // the text needs to be read anyway, either to verify the hash or to parse it
+        std::ifstream ifs(agf_path, std::ios::binary);
+        if(!ifs.is_open()){
+            return false;
+        }
+        std::string text((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
 
-            std::vector<std::string> line_parts = StringTool::Split(line_str,' ');
-            auto glass = std::make_shared<Glass>();
-            glasses_.push_back(std::move(glass));
-            std::string glassname = line_parts[1];
-            std::transform(glassname.begin(), glassname.end(), glassname.begin(), ::toupper);
-            glasses_.back()->SetProductName(glassname);
-            glasses_.back()->SetSupplier(supplier);
-            glasses_.back()->SetDispersionFormula(atoi(line_parts[2].c_str()));
+        const uint64_t src_hash = Fnv1a(text.data(), text.size());
 
+        if( !(has_cache && cache_header.source_size == src_size && cache_header.source_hash == src_hash) ){
+            records.clear();
+            ParseAgf(text, records);
         }
-        else if(StringTool::StartsWith(line_str, "CD"))
-        {
-            // CD <dispersion coefficients 1 - 10>
 
-            std::vector<std::string> line_parts = StringTool::Split(line_str,' ');
-            for(int i = 1; i < (int)line_parts.size(); i++){
-                double val;
-                try {
-                    val = std::stod(line_parts[i]);
-                }  catch (...) {
-                    val = 0.0;
-                }
-                glasses_.back()->SetDispersionCoefs(i-1,val);
+        // refresh the stamps even if only the modification time has changed
+        if(cache_enabled_ && !records.empty()){
+            if(!cache_dir_.empty()){
+                std::filesystem::create_directories(cache_dir_, ec);
             }
+            WriteBinaryCache(cache_path, CacheHeader{src_size, src_mtime, src_hash}, records);
         }
-        else if(StringTool::StartsWith(line_str, "TD"))
-        {
-            std::vector<std::string> line_parts = StringTool::Split(line_str,' ');
-            if(line_parts.size() >= 8){
-                double D0 = std::stod(line_parts[1]);
-                double D1 = std::stod(line_parts[2]);
-                double D2 = std::stod(line_parts[3]);
-                double E0 = std::stod(line_parts[4]);
-                double E1 = std::stod(line_parts[5]);
-                double Ltk = std::stod(line_parts[6]);
-                double Tref = std::stod(line_parts[7]);
-                glasses_.back()->SetThermalData(D0, D1, D2, E0, E1, Ltk, Tref);
-            }
+    }
+
+    for(auto &rec : records){
+        auto glass = std::make_shared<Glass>();
+        glass->SetProductName(rec.name);
+        glass->SetSupplier(name_);
+        glass->SetDispersionFormula(rec.formula);
+        for(int i = 0; i < GlassRecord::num_coefs; i++){
+            glass->SetDispersionCoefs(i, rec.coefs[i]);
         }
+        if(rec.has_thermal_data){
+            const double* td = rec.thermal_data;
+            glass->SetThermalData(td[0], td[1], td[2], td[3], td[4], td[5], td[6]);
+        }
+        glasses_.push_back(std::move(glass));
     }
 
     if(glasses_.empty()){
         return false;
     }
 
+    // the first entry wins on duplicated names, as the former linear search did
+    name_index_.reserve(glasses_.size());
+    for(auto &g : glasses_){
+        name_index_.emplace(g->ProductName(), g);
+    }
+
     return true;
 }
 
+std::string GlassCatalog::CachePath(const std::string &agf_path)
+{
+    std::filesystem::path p = agf_path;
+    p.replace_extension(".gcat");
+    if(!cache_dir_.empty()){
+        // catalogs of the same name in different directories share the entry, which is refreshed by the hash check
+        p = std::filesystem::path(cache_dir_) / p.filename();
+    }
+    return p.u8string();
+}
+
 void GlassCatalog::Print()
 {
     std::ostringstream oss;
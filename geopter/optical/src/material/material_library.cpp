@@ -45,17 +45,28 @@ using namespace geopter;
 
 std::vector< std::unique_ptr<GlassCatalog> > MaterialLibrary::catalogs_;
 std::shared_ptr<Air> MaterialLibrary::air_;
+std::unordered_map< std::string, std::shared_ptr<Glass> > MaterialLibrary::glass_index_;
+int MaterialLibrary::num_instances_ = 0;
+std::mutex MaterialLibrary::instances_mtx_;
 
 MaterialLibrary::MaterialLibrary()
 {
-    air_ = std::make_shared<Air>();
-
+    std::lock_guard<std::mutex> lk(instances_mtx_);
+    if(num_instances_ == 0 || !air_){
+        air_ = std::make_shared<Air>();
+    }
+    num_instances_++;
 }
 
 MaterialLibrary::~MaterialLibrary()
 {
-    air_.reset();
-    clear();
+    // the shared data are released with the last instance
+    std::lock_guard<std::mutex> lk(instances_mtx_);
+    num_instances_--;
+    if(num_instances_ == 0){
+        air_.reset();
+        clear();
+    }
 }
 
 void MaterialLibrary::clear()
@@ -67,7 +78,7 @@ void MaterialLibrary::clear()
         }
         catalogs_.clear();
     }
-
+    glass_index_.clear();
 }
 
 std::shared_ptr<Air> MaterialLibrary::GetAir()
@@ -124,13 +135,9 @@ std::shared_ptr<Material> MaterialLibrary::Find(std::string material_name)
     }else{
         // assume real glass name without catalog (ex. n-bk7)
         std::transform(material_name.begin(), material_name.end(), material_name.begin(), ::toupper); // all-uppercase
-        for(int ci = 0; ci < (int)catalogs_.size(); ci++){
-            GlassCatalog* catalog = catalogs_[ci].get();
-            //std::string product_and_supplier = material_name + "_" + catalog->name();
-            std::string product_name = material_name;
-            if(catalog->GetGlass(product_name)){ //found
-                return catalog->GetGlass(product_name);
-            }
+        auto itr = glass_index_.find(material_name);
+        if(itr != glass_index_.end()){
+            return itr->second;
         }
         return nullptr;
     }
@@ -158,6 +165,15 @@ bool MaterialLibrary::LoadAgfFiles(const std::vector<std::string>& agf_paths)
         }
     }
 
+    // earlier catalogs take precedence for names without supplier
+    for(auto &cat : catalogs_){
+        const int num_glasses = cat->NumberOfGlasses();
+        for(int gi = 0; gi < num_glasses; gi++){
+            auto g = cat->GetGlass(gi);
+            glass_index_.emplace(g->ProductName(), g);
+        }
+    }
+
     return true;
 
 }
@@ -0,0 +1,231 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#include <iostream>
+#include <cmath>
+#include <limits>
+
+#include "Eigen/Dense"
+
+#include "optimization/dls_optimizer.h"
+#include "system/optical_system.h"
+#include "common/thread_pool.h"
+
+using namespace geopter;
+
+DlsOptimizer::DlsOptimizer(OpticalSystem *opt_sys) :
+    opt_sys_(opt_sys),
+    max_iter_(50),
+    damping_(1.0e-3),
+    fd_step_(1.0e-6),
+    tolerance_(1.0e-8)
+{
+
+}
+
+DlsOptimizer::~DlsOptimizer()
+{
+
+}
+
+void DlsOptimizer::AddVariable(const OptimizationVariable &var)
+{
+    if( !var.Check(opt_sys_) ){
+        std::cerr << "Invalid optimization variable: " << var.Name() << std::endl;
+        return;
+    }
+    variables_.push_back(var);
+}
+
+void DlsOptimizer::ClearVariables()
+{
+    variables_.clear();
+}
+
+void DlsOptimizer::prepare_copies()
+{
+    const int num_vars = variables_.size();
+
+    trial_sys_ = opt_sys_->Clone();
+
+    column_sys_.resize(num_vars);
+    ThreadPool::Global()->ParallelFor(num_vars, [&](int j){
+        column_sys_[j] = opt_sys_->Clone();
+    });
+
+    scales_.resize(num_vars);
+    for(int j = 0; j < num_vars; j++){
+        scales_[j] = variables_[j].Scale(opt_sys_);
+    }
+}
+
+Eigen::VectorXd DlsOptimizer::current_values() const
+{
+    const int num_vars = variables_.size();
+    Eigen::VectorXd x(num_vars);
+    for(int j = 0; j < num_vars; j++){
+        x(j) = variables_[j].Value(opt_sys_);
+    }
+    return x;
+}
+
+void DlsOptimizer::apply_values(OpticalSystem *opt_sys, const Eigen::VectorXd &x) const
+{
+    for(int j = 0; j < (int)variables_.size(); j++){
+        variables_[j].SetValue(opt_sys, x(j));
+    }
+    opt_sys->UpdateModel();
+}
+
+Eigen::VectorXd DlsOptimizer::residuals_at(OpticalSystem *opt_sys, const Eigen::VectorXd &x) const
+{
+    apply_values(opt_sys, x);
+    return merit_func_.Residuals(opt_sys);
+}
+
+Eigen::MatrixXd DlsOptimizer::jacobian_at(const Eigen::VectorXd &x, const Eigen::VectorXd &r0)
+{
+    const int num_vars = variables_.size();
+    Eigen::MatrixXd jac = Eigen::MatrixXd::Zero(r0.size(), num_vars);
+
+    // each column on its own copy
+    ThreadPool::Global()->ParallelFor(num_vars, [&](int j){
+        const double h = fd_step_*scales_[j];
+        OpticalSystem* sys = column_sys_[j].get();
+
+        Eigen::VectorXd xj = x;
+        xj(j) = x(j) + h;
+        Eigen::VectorXd col = (residuals_at(sys, xj) - r0)/h;
+
+        // rays may be lost on one side, e.g. close to the aperture edge
+        if( !col.allFinite() ){
+            xj(j) = x(j) - h;
+            col = (r0 - residuals_at(sys, xj))/h;
+        }
+
+        if(col.allFinite()){
+            jac.col(j) = col;
+        }
+    });
+
+    return jac;
+}
+
+Eigen::MatrixXd DlsOptimizer::Jacobian()
+{
+    prepare_copies();
+
+    const Eigen::VectorXd x = current_values();
+    const Eigen::VectorXd r0 = residuals_at(trial_sys_.get(), x);
+
+    return jacobian_at(x, r0);
+}
+
+DlsOptimizer::Result DlsOptimizer::Optimize()
+{
+    Result result;
+
+    if(variables_.empty() || merit_func_.NumberOfOperands() == 0){
+        std::cerr << "No variables or operands to optimize" << std::endl;
+        return result;
+    }
+
+    prepare_copies();
+
+    Eigen::VectorXd x = current_values();
+    Eigen::VectorXd r = residuals_at(trial_sys_.get(), x);
+    double merit = MeritFunction::SumOfSquares(r);
+
+    result.initial_merit = merit;
+    result.final_merit = merit;
+
+    if( !std::isfinite(merit) ){
+        std::cerr << "Merit function cannot be evaluated at the starting point" << std::endl;
+        return result;
+    }
+
+    double mu = damping_;
+    constexpr int max_retries = 10;
+
+    for(int iter = 0; iter < max_iter_; iter++){
+        result.iterations = iter + 1;
+
+        const Eigen::MatrixXd jac = jacobian_at(x, r);
+        const Eigen::MatrixXd jtj = jac.transpose()*jac;
+        const Eigen::VectorXd jtr = jac.transpose()*r;
+
+        if(jtr.norm() <= std::numeric_limits<double>::epsilon()*merit){
+            result.converged = true;
+            break;
+        }
+
+        // Marquardt scaling by the diagonal, floored for variables with no effect
+        Eigen::VectorXd diag = jtj.diagonal();
+        const double floor = 1.0e-12*std::max(diag.maxCoeff(), 1.0e-300);
+        diag = diag.cwiseMax(floor);
+
+        bool accepted = false;
+        double new_merit = merit;
+        Eigen::VectorXd new_x, new_r;
+
+        for(int k = 0; k < max_retries; k++){
+            Eigen::MatrixXd lhs = jtj;
+            lhs.diagonal() += mu*diag;
+
+            const Eigen::VectorXd delta = lhs.ldlt().solve(-jtr);
+            new_x = x + delta;
+            new_r = residuals_at(trial_sys_.get(), new_x);
+            new_merit = MeritFunction::SumOfSquares(new_r);
+
+            if(new_merit < merit){
+                accepted = true;
+                mu = std::max(mu/10.0, 1.0e-12);
+                break;
+            }
+            mu *= 10.0;
+        }
+
+        if( !accepted ){
+            result.stalled = true;
+            break;
+        }
+
+        const double decrease = (merit - new_merit)/merit;
+        x = new_x;
+        r = new_r;
+        merit = new_merit;
+
+        if(decrease < tolerance_){
+            result.converged = true;
+            break;
+        }
+    }
+
+    result.final_merit = merit;
+
+    apply_values(opt_sys_, x);
+
+    return result;
+}
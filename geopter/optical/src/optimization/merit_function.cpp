@@ -0,0 +1,308 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#include <cmath>
+#include <limits>
+
+#include "optimization/merit_function.h"
+#include "system/optical_system.h"
+#include "sequential/sequential_trace.h"
+#include "analysis/wave_aberration.h"
+
+using namespace geopter;
+
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+}
+
+
+MeritOperand::MeritOperand(int type, double target, double weight, int field_index, int wvl_index) :
+    type_(type),
+    target_(target),
+    weight_(weight),
+    field_index_(field_index),
+    wvl_index_(wvl_index),
+    pupil_(Eigen::Vector2d::Zero()),
+    nrd_(11)
+{
+
+}
+
+bool MeritOperand::Check(const OpticalSystem *opt_sys) const
+{
+    if(type_ < EffectiveFocalLength || type_ > RmsOpd) return false;
+    if(weight_ < 0.0) return false;
+    if(EffectiveFocalLength == type_) return true;
+
+    OpticalSpec* opt_spec = opt_sys->GetOpticalSpec();
+    if(field_index_ < 0 || field_index_ >= opt_spec->GetFieldSpec()->NumberOfFields()) return false;
+    if(wvl_index_ < -1 || wvl_index_ >= opt_spec->GetWavelengthSpec()->NumberOfWavelengths()) return false;
+    if((RmsSpot == type_ || RmsOpd == type_) && nrd_ < 2) return false;
+
+    return true;
+}
+
+double MeritOperand::Evaluate(OpticalSystem *opt_sys) const
+{
+    if( !Check(opt_sys) ){
+        return kNaN;
+    }
+
+    switch (type_) {
+    case EffectiveFocalLength:
+        return opt_sys->GetFirstOrderData()->effective_focal_length;
+    case RmsSpot:
+        return rms_spot(opt_sys);
+    case TransverseX:
+        return transverse(opt_sys, 0);
+    case TransverseY:
+        return transverse(opt_sys, 1);
+    case Opd:
+        return wavefront(opt_sys, false);
+    case RmsOpd:
+        return wavefront(opt_sys, true);
+    default:
+        return kNaN;
+    }
+}
+
+std::vector<int> MeritOperand::wavelength_indices(OpticalSystem *opt_sys) const
+{
+    WavelengthSpec* wvl_spec = opt_sys->GetOpticalSpec()->GetWavelengthSpec();
+
+    std::vector<int> indices;
+    if(wvl_index_ >= 0){
+        indices.push_back(wvl_index_);
+    }else if(RmsSpot == type_ || RmsOpd == type_){
+        for(int wi = 0; wi < wvl_spec->NumberOfWavelengths(); wi++){
+            indices.push_back(wi);
+        }
+    }else{
+        indices.push_back(wvl_spec->ReferenceIndex());
+    }
+    return indices;
+}
+
+double MeritOperand::rms_spot(OpticalSystem *opt_sys) const
+{
+    WavelengthSpec* wvl_spec = opt_sys->GetOpticalSpec()->GetWavelengthSpec();
+    Field* fld = opt_sys->GetOpticalSpec()->GetFieldSpec()->GetField(field_index_);
+    const std::vector<Eigen::Vector2d> pupils = SequentialTrace::GridPupils(nrd_);
+
+    SequentialTrace tracer(opt_sys);
+    tracer.SetApertureCheck(true);
+    tracer.SetApplyVig(false);
+
+    // weighted spot about the polychromatic centroid
+    std::vector<Eigen::Vector2d> pts;
+    std::vector<double> wts;
+
+    for(int wi : wavelength_indices(opt_sys)){
+        const double wvl = wvl_spec->GetWavelength(wi)->Value();
+        const double wt  = wvl_spec->GetWavelength(wi)->Weight();
+        auto seq_path = tracer.GetSequentialPath(wvl);
+        auto ray = std::make_shared<Ray>(seq_path->Size());
+
+        for(const auto& pupil : pupils){
+            if(TRACE_SUCCESS == tracer.TracePupilRay(ray, *seq_path, pupil, fld, wvl)){
+                pts.emplace_back(ray->GetBack()->X(), ray->GetBack()->Y());
+                wts.push_back(wt);
+            }
+        }
+    }
+
+    double sum_wt = 0.0;
+    Eigen::Vector2d centroid = Eigen::Vector2d::Zero();
+    for(size_t k = 0; k < pts.size(); k++){
+        centroid += wts[k]*pts[k];
+        sum_wt   += wts[k];
+    }
+    if(sum_wt <= 0.0){
+        return kNaN;
+    }
+    centroid /= sum_wt;
+
+    double sum_sq = 0.0;
+    for(size_t k = 0; k < pts.size(); k++){
+        sum_sq += wts[k]*(pts[k] - centroid).squaredNorm();
+    }
+
+    return sqrt(sum_sq/sum_wt);
+}
+
+double MeritOperand::transverse(OpticalSystem *opt_sys, int axis) const
+{
+    WavelengthSpec* wvl_spec = opt_sys->GetOpticalSpec()->GetWavelengthSpec();
+    Field* fld = opt_sys->GetOpticalSpec()->GetFieldSpec()->GetField(field_index_);
+
+    SequentialTrace tracer(opt_sys);
+    tracer.SetApertureCheck(true);
+    tracer.SetApplyVig(false);
+
+    // measured from the chief ray of the reference wavelength
+    const double ref_wvl = wvl_spec->ReferenceWavelength();
+    auto ref_path = tracer.GetSequentialPath(ref_wvl);
+    auto chief_ray = std::make_shared<Ray>(ref_path->Size());
+    if(TRACE_SUCCESS != tracer.TracePupilRay(chief_ray, *ref_path, Eigen::Vector2d::Zero(), fld, ref_wvl)){
+        return kNaN;
+    }
+
+    const double wvl = wvl_spec->GetWavelength(wavelength_indices(opt_sys).front())->Value();
+    auto seq_path = tracer.GetSequentialPath(wvl);
+    auto ray = std::make_shared<Ray>(seq_path->Size());
+    if(TRACE_SUCCESS != tracer.TracePupilRay(ray, *seq_path, pupil_, fld, wvl)){
+        return kNaN;
+    }
+
+    return ray->GetBack()->IntersectPt()(axis) - chief_ray->GetBack()->IntersectPt()(axis);
+}
+
+double MeritOperand::wavefront(OpticalSystem *opt_sys, bool rms) const
+{
+    WavelengthSpec* wvl_spec = opt_sys->GetOpticalSpec()->GetWavelengthSpec();
+    Field* fld = opt_sys->GetOpticalSpec()->GetFieldSpec()->GetField(field_index_);
+
+    SequentialTrace tracer(opt_sys);
+    tracer.SetApertureCheck(true);
+    tracer.SetApplyVig(false);
+
+    const std::vector<Eigen::Vector2d> pupils = rms ? SequentialTrace::GridPupils(nrd_) : std::vector<Eigen::Vector2d>({pupil_});
+
+    double sum_wt = 0.0;
+    double sum_sq = 0.0;
+    double opd = kNaN;
+
+    for(int wi : wavelength_indices(opt_sys)){
+        const double wvl = wvl_spec->GetWavelength(wi)->Value();
+        const double wt  = wvl_spec->GetWavelength(wi)->Weight();
+        const double to_waves = 1.0/(1.0e-6*wvl);
+        auto seq_path = tracer.GetSequentialPath(wvl);
+
+        auto chief_ray = std::make_shared<Ray>(seq_path->Size());
+        if(TRACE_SUCCESS != tracer.TracePupilRay(chief_ray, *seq_path, Eigen::Vector2d::Zero(), fld, wvl)){
+            return kNaN;
+        }
+        WaveAberration wave_abr(opt_sys);
+        const WavefrontContext ctx = wave_abr.CreateWavefrontContext(chief_ray, wvl);
+
+        // rms about the mean of the pupil samples
+        std::vector<double> opds;
+        auto ray = std::make_shared<Ray>(seq_path->Size());
+        for(const auto& pupil : pupils){
+            if(TRACE_SUCCESS == tracer.TracePupilRay(ray, *seq_path, pupil, fld, wvl)){
+                opds.push_back(to_waves*wave_abr.Opd(ctx, ray));
+            }
+        }
+
+        if(opds.empty()){
+            return kNaN;
+        }
+        if( !rms ){
+            opd = opds.front();
+            break;
+        }
+
+        double mean = 0.0;
+        for(double w : opds) mean += w;
+        mean /= static_cast<double>(opds.size());
+
+        double var = 0.0;
+        for(double w : opds) var += (w - mean)*(w - mean);
+        var /= static_cast<double>(opds.size());
+
+        sum_sq += wt*var;
+        sum_wt += wt;
+    }
+
+    if( !rms ){
+        return opd;
+    }
+    if(sum_wt <= 0.0){
+        return kNaN;
+    }
+    return sqrt(sum_sq/sum_wt);
+}
+
+std::string MeritOperand::Name() const
+{
+    switch (type_) {
+    case EffectiveFocalLength: return "EFL";
+    case RmsSpot:              return "RSPOT";
+    case TransverseX:          return "TRAX";
+    case TransverseY:          return "TRAY";
+    case Opd:                  return "OPD";
+    case RmsOpd:               return "ROPD";
+    default:                   return "";
+    }
+}
+
+
+MeritFunction::MeritFunction()
+{
+
+}
+
+void MeritFunction::AddOperand(const MeritOperand &operand)
+{
+    operands_.push_back(operand);
+}
+
+void MeritFunction::RemoveOperand(int i)
+{
+    if(i >= 0 && i < (int)operands_.size()){
+        operands_.erase(operands_.begin() + i);
+    }
+}
+
+void MeritFunction::Clear()
+{
+    operands_.clear();
+}
+
+Eigen::VectorXd MeritFunction::Residuals(OpticalSystem *opt_sys) const
+{
+    const int num_operands = operands_.size();
+    Eigen::VectorXd residuals(num_operands);
+    for(int i = 0; i < num_operands; i++){
+        const MeritOperand& operand = operands_[i];
+        residuals(i) = sqrt(operand.Weight())*(operand.Evaluate(opt_sys) - operand.Target());
+    }
+    return residuals;
+}
+
+double MeritFunction::Value(OpticalSystem *opt_sys) const
+{
+    return SumOfSquares(Residuals(opt_sys));
+}
+
+double MeritFunction::SumOfSquares(const Eigen::VectorXd &residuals)
+{
+    if( !residuals.allFinite() ){
+        return std::numeric_limits<double>::infinity();
+    }
+    return residuals.squaredNorm();
+}
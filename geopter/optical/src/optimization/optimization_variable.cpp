@@ -0,0 +1,167 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#include <cmath>
+#include <algorithm>
+
+#include "optimization/optimization_variable.h"
+#include "system/optical_system.h"
+
+using namespace geopter;
+
+OptimizationVariable::OptimizationVariable(int type, int index, int term) :
+    type_(type),
+    index_(index),
+    term_(term)
+{
+
+}
+
+bool OptimizationVariable::Check(const OpticalSystem *opt_sys) const
+{
+    OpticalAssembly* assembly = opt_sys->GetOpticalAssembly();
+    const int num_srfs = assembly->NumberOfSurfaces();
+
+    switch(type_){
+    case Curvature:
+        return (index_ > 0 && index_ < num_srfs - 1);
+    case Thickness:
+        return (index_ > 0 && index_ < num_srfs - 1);
+    case Conic:
+    case AsphereCoefficient:
+    {
+        if(index_ <= 0 || index_ >= num_srfs - 1){
+            return false;
+        }
+        Surface* srf = assembly->GetSurface(index_);
+        if(auto prf = srf->Profile<EvenPolynomial>()){
+            return (type_ == Conic) || (term_ >= 0 && term_ < prf->NumberOfTerms());
+        }
+        if(auto prf = srf->Profile<OddPolynomial>()){
+            return (type_ == Conic) || (term_ >= 0 && term_ < prf->NumberOfTerms());
+        }
+        return false;
+    }
+    default:
+        return false;
+    }
+}
+
+double OptimizationVariable::Value(const OpticalSystem *opt_sys) const
+{
+    OpticalAssembly* assembly = opt_sys->GetOpticalAssembly();
+
+    switch(type_){
+    case Curvature:
+        return assembly->GetSurface(index_)->Curvature();
+    case Thickness:
+        return assembly->GetGap(index_)->Thickness();
+    case Conic:
+    {
+        Surface* srf = assembly->GetSurface(index_);
+        if(auto prf = srf->Profile<EvenPolynomial>()) return prf->Conic();
+        if(auto prf = srf->Profile<OddPolynomial>())  return prf->Conic();
+        return 0.0;
+    }
+    case AsphereCoefficient:
+    {
+        Surface* srf = assembly->GetSurface(index_);
+        if(auto prf = srf->Profile<EvenPolynomial>()) return prf->GetNthTerm(term_);
+        if(auto prf = srf->Profile<OddPolynomial>())  return prf->GetNthTerm(term_);
+        return 0.0;
+    }
+    default:
+        return 0.0;
+    }
+}
+
+void OptimizationVariable::SetValue(OpticalSystem *opt_sys, double value) const
+{
+    OpticalAssembly* assembly = opt_sys->GetOpticalAssembly();
+
+    switch(type_){
+    case Curvature:
+        assembly->GetSurface(index_)->SetCurvature(value);
+        break;
+    case Thickness:
+        assembly->GetGap(index_)->SetThickness(value);
+        break;
+    case Conic:
+    {
+        Surface* srf = assembly->GetSurface(index_);
+        if(auto prf = srf->Profile<EvenPolynomial>()) prf->SetConic(value);
+        else if(auto prf = srf->Profile<OddPolynomial>()) prf->SetConic(value);
+        break;
+    }
+    case AsphereCoefficient:
+    {
+        Surface* srf = assembly->GetSurface(index_);
+        if(auto prf = srf->Profile<EvenPolynomial>()) prf->SetNthTerm(term_, value);
+        else if(auto prf = srf->Profile<OddPolynomial>()) prf->SetNthTerm(term_, value);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+double OptimizationVariable::Scale(const OpticalSystem *opt_sys) const
+{
+    switch(type_){
+    case Curvature:
+        return 1.0e-2;
+    case Thickness:
+        return 1.0;
+    case Conic:
+        return 1.0;
+    case AsphereCoefficient:
+    {
+        Surface* srf = opt_sys->GetOpticalAssembly()->GetSurface(index_);
+        const double sd = std::max(srf->MaxAperture(), 1.0e-3);
+
+        // even terms multiply r^(2i+4), odd terms r^(i+3)
+        int power = 2*term_ + 4;
+        if(srf->Profile<OddPolynomial>()){
+            power = term_ + 3;
+        }
+
+        // 1 um of sag at the semi-diameter
+        return 1.0e-3/std::pow(sd, power);
+    }
+    default:
+        return 1.0;
+    }
+}
+
+std::string OptimizationVariable::Name() const
+{
+    switch(type_){
+    case Curvature:          return "CV" + std::to_string(index_);
+    case Thickness:          return "TH" + std::to_string(index_);
+    case Conic:              return "CC" + std::to_string(index_);
+    case AsphereCoefficient: return "AS" + std::to_string(index_) + "_" + std::to_string(term_);
+    default:                 return "";
+    }
+}
@@ -16,6 +16,13 @@ FirstOrderData::~FirstOrderData()
     parent_ = nullptr;
 }
 
+void FirstOrderData::CopyFrom(const FirstOrderData &other)
+{
+    OpticalSystem* parent = parent_;
+    *this = other;
+    parent_ = parent;
+}
+
 
 void FirstOrderData::Update()
 {
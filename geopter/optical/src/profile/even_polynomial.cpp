@@ -25,6 +25,7 @@
 
 #include "profile/even_polynomial.h"
 
+#include <cmath>
 #include <iostream>
 #include <iomanip>
 
@@ -39,6 +40,7 @@ EvenPolynomial::EvenPolynomial() :
     cv_ = 0.0;
     terms_ = std::vector<double>(num_terms_, 0.0);
     eps_ = 1.0e-8;
+    revision_ = RevisionCounter::Next();
 }
 
 EvenPolynomial::EvenPolynomial(double cv, double conic, const std::vector<double>& coefs) :
@@ -49,6 +51,7 @@ EvenPolynomial::EvenPolynomial(double cv, double conic, const std::vector<double
     terms_ = std::vector<double>(num_terms_, 0.0);
     this->SetTerms(coefs);
     eps_ = 1.0e-8;
+    revision_ = RevisionCounter::Next();
 }
 
 
@@ -60,34 +63,7 @@ EvenPolynomial::~EvenPolynomial()
 
 bool EvenPolynomial::Intersect(Eigen::Vector3d& pt, double& distance, const Eigen::Vector3d& p0, const Eigen::Vector3d& dir)
 {
-    // Spencer's method
-
-    Eigen::Vector3d p = p0;
-    double s1 = -f(p)/dir.dot(df(p));
-    double s2;
-    double delta = fabs(s1);
-    constexpr int max_iter = 50;
-    int iter = 0;
-
-    while(delta > eps_)
-    {
-        p = p0 + s1*dir;
-        s2 = s1 - f(p)/dir.dot(df(p));
-        delta = fabs(s2-s1);
-        s1 = s2;
-        iter++;
-
-        if(iter > max_iter){
-            pt = p;
-            distance = s1;
-            return false;
-        }
-    }
-
-    pt = p;
-    distance = s1;
-
-    return true;
+    return ComputeIntersect(pt, distance, p0, dir, cv_, conic_, terms_.data(), num_terms_, eps_);
 }
 
 double EvenPolynomial::GetNthTerm(int i) const
@@ -103,6 +79,7 @@ void EvenPolynomial::SetNthTerm(int i, double val)
 {
     if(i < num_terms_){
         terms_[i] = val;
+        revision_ = RevisionCounter::Next();
     }
 }
 
@@ -110,37 +87,41 @@ void EvenPolynomial::SetTerms(const std::vector<double>& coefs)
 {
     terms_ = std::vector<double>(num_terms_, 0.0);
 
-    for(int i = 0; i < std::min(num_terms_, (int)terms_.size()); i++){
+    for(int i = 0; i < std::min(num_terms_, (int)coefs.size()); i++){
         terms_[i] = coefs[i];
     }
 
+    revision_ = RevisionCounter::Next();
+
 }
 
 
 double EvenPolynomial::Sag(double x, double y) const
+{
+    return ComputeSag(cv_, conic_, terms_.data(), num_terms_, x, y);
+}
+
+double EvenPolynomial::ComputeSag(double cv, double conic, const double* terms, int num_terms, double x, double y)
 {
     double r2 = x*x + y*y;
 
     // sphere + conic contribution
     double z = 0.0;
-    double inside_sqrt = 1.0 - (conic_+1.0)*cv_*cv_*r2;
+    double inside_sqrt = 1.0 - (conic+1.0)*cv*cv*r2;
     if(inside_sqrt < 0.0){
         std::cout << "TraceMissedSurface EvenPolynomial::sag()" << std::endl;
         return NAN;
     }
     else{
-        z = cv_*r2 / ( 1.0 + sqrt( inside_sqrt ) );
+        z = cv*r2 / ( 1.0 + sqrt( inside_sqrt ) );
     }
 
-    // polynomial contribution
+    // polynomial contribution, Ar4 + Br6 + Cr8... = r4*(A + r2*(B + r2*(C + ...)))
     double z_asp = 0.0;
-    double r_pow = r2;
-
-    //Ar4 + Br6 + Cr8...
-    for(int i = 0; i < num_terms_; i++){
-        r_pow *= r2;
-        z_asp += terms_[i]*r_pow;
+    for(int i = num_terms - 1; i >= 0; i--){
+        z_asp = z_asp*r2 + terms[i];
     }
+    z_asp *= r2*r2;
 
     return (z + z_asp);
 }
@@ -152,34 +133,9 @@ double EvenPolynomial::f(const Eigen::Vector3d& p) const
 
 Eigen::Vector3d EvenPolynomial::df(const Eigen::Vector3d& p) const
 {
-    //sphere + conic contribution
-    double r2 = p(0)*p(0) + p(1)*p(1);
-    double ec = conic_ + 1.0;
-
-    double e = cv_ / sqrt( 1.0 - ec*cv_*cv_*r2 );
-
-    //polynomial asphere contribution
-    double r_pow = 1.0;
-    double e_asp = 0.0;
-    double c_coef = 2.0;
-
-    c_coef += 2.0;
-    r_pow *= r2;
-
-    for(int i = 0; i < num_terms_; i++){
-        e_asp += c_coef*terms_[i]*r_pow;
-        c_coef += 2.0;
-        r_pow *= r2;
-    }
-
-    double e_tot = e + e_asp;
-
-    Eigen::Vector3d df({-e_tot*p(0), -e_tot*p(1), 1.0});
-    return df;
-
+    return ComputeGradient(cv_, conic_, terms_.data(), num_terms_, p);
 }
 
-
 double EvenPolynomial::deriv_1st(double h) const
 {
     double k = conic_;
@@ -193,8 +149,10 @@ double EvenPolynomial::deriv_1st(double h) const
     double z2 = z2_denom/z2_num;
 
     double z3 = 0.0;
+    double h_pow = h*h*h;
     for (int i = 0; i < num_terms_; i++) {
-        z3 += 2*(i+2) * terms_[i] * pow(h, 2*(i+1) + 1);
+        z3 += 2*(i+2) * terms_[i] * h_pow;
+        h_pow *= h*h;
     }
 
     return (z1 + z2 + z3);
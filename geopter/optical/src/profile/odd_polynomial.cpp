@@ -23,6 +23,7 @@
 **             Date: May 16th, 2021                                                                                          
 ********************************************************************************/
 
+#include <cmath>
 #include <iomanip>
 #include "profile/odd_polynomial.h"
 #include "sequential/trace_error.h"
@@ -35,6 +36,7 @@ OddPolynomial::OddPolynomial() :
 {
     cv_ = 0.0;
     eps_ = 1.0e-5;
+    revision_ = RevisionCounter::Next();
 }
 
 OddPolynomial::OddPolynomial(double cv, double conic, const std::vector<double>& coefs) :
@@ -44,6 +46,7 @@ OddPolynomial::OddPolynomial(double cv, double conic, const std::vector<double>&
     cv_ = cv;
     this->SetTerms(coefs);
     eps_ = 1.0e-5;
+    revision_ = RevisionCounter::Next();
 }
 
 
@@ -55,41 +58,14 @@ OddPolynomial::~OddPolynomial()
 
 bool OddPolynomial::Intersect(Eigen::Vector3d& pt, double& distance, const Eigen::Vector3d& p0, const Eigen::Vector3d& dir)
 {
-    // Spencer's method
-
-    Eigen::Vector3d p = p0;
-    double s1 = -f(p)/dir.dot(df(p));
-    double s2;
-    double delta = fabs(s1);
-    constexpr int max_iter = 30;
-    int iter = 0;
-
-    while(delta > eps_)
-    {
-        p = p0 + s1*dir;
-        s2 = s1 - f(p)/dir.dot(df(p));
-        delta = fabs(s2-s1);
-        s1 = s2;
-        iter++;
-
-        if(iter > max_iter){
-            pt = p;
-            distance = s1;
-            return false;
-        }
-    }
-
-    pt = p;
-    distance = s1;
-
-    return true;
+    return ComputeIntersect(pt, distance, p0, dir, cv_, conic_, terms_.data(), num_terms_, eps_);
 }
 
-
 void OddPolynomial::SetNthTerm(int i, double val)
 {
     if(i < num_terms_){
         terms_[i] = val;
+        revision_ = RevisionCounter::Next();
     }
 }
 
@@ -100,6 +76,8 @@ void OddPolynomial::SetTerms(const std::vector<double>& coefs)
     for(int i = 0; i < std::min(num_terms_, (int)coefs.size()); i++){
         terms_[i] = coefs[i];
     }
+
+    revision_ = RevisionCounter::Next();
 }
 
 
@@ -115,21 +93,24 @@ double OddPolynomial::GetNthTerm(int i) const
 
 
 double OddPolynomial::Sag(double x, double y) const
+{
+    return ComputeSag(cv_, conic_, terms_.data(), num_terms_, x, y);
+}
+
+double OddPolynomial::ComputeSag(double cv, double conic, const double* terms, int num_terms, double x, double y)
 {
     double r2 = x*x + y*y;
     double r = sqrt(r2);
 
     // conic contribution
-    double z_conic = cv_*r2/( 1.0 + sqrt( 1.0 - cv_*cv_*r2*(conic_+1.0) ) );
+    double z_conic = cv*r2/( 1.0 + sqrt( 1.0 - cv*cv*r2*(conic+1.0) ) );
 
-    // polynomial contribution
+    // polynomial contribution, r^3*(a0 + r*(a1 + r*(a2 + ...)))
     double z_pol = 0.0;
-    double r_pow = r2*r;
-
-    for(int i = 0; i < num_terms_; i++) {
-        z_pol += terms_[i] * r_pow;
-        r_pow *= r;
+    for(int i = num_terms - 1; i >= 0; i--) {
+        z_pol = z_pol*r + terms[i];
     }
+    z_pol *= r2*r;
 
     return (z_conic + z_pol);
 }
@@ -141,29 +122,7 @@ double OddPolynomial::f(const Eigen::Vector3d &p) const
 
 Eigen::Vector3d OddPolynomial::df(const Eigen::Vector3d &p) const
 {
-    double r2 = p(0)*p(0) + p(1)*p(1);
-    double r = sqrt(r2);
-    double t = sqrt( 1.0 - cv_*cv_*r2*(conic_ + 1.0) ); // common sqrt
-
-    // conic contribution
-    double conic_contrib_1 = 2*cv_/(t + 1.0);
-    double conic_contrib_2 = pow(cv_,3)*r2*(conic_+1.0)/( t*pow((t+1.0), 2) );
-
-    // polynomial contribution
-    double pol_contrib = 0.0;
-
-    double r_pow = r;
-    double num = 3.0;
-    for(int i = 0; i < num_terms_; i++){
-        pol_contrib += num*terms_[i]*r_pow;
-        num += 1.0;
-        r_pow *= r;
-    }
-
-    double e_tot = conic_contrib_1 + conic_contrib_2 + pol_contrib;
-
-    Eigen::Vector3d df_ret({-e_tot*p(0), -e_tot*p(1), 1.0});
-    return df_ret;
+    return ComputeGradient(cv_, conic_, terms_.data(), num_terms_, p);
 }
 
 double OddPolynomial::deriv_1st(double h) const
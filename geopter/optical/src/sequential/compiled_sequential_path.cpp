@@ -0,0 +1,125 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#include <algorithm>
+
+#include "sequential/compiled_sequential_path.h"
+#include "sequential/sequential_path.h"
+#include "assembly/surface.h"
+
+using namespace geopter;
+
+CompiledSequentialPath::CompiledSequentialPath()
+{
+
+}
+
+CompiledSequentialPath::CompiledSequentialPath(const SequentialPath &seq_path)
+{
+    const int path_size = seq_path.Size();
+    surfaces_.reserve(path_size);
+
+    for(int i = 0; i < path_size; i++){
+        const SequentialPathComponent& comp = seq_path.At(i);
+        this->Append(comp.surface, comp.distance, comp.refractive_index);
+    }
+}
+
+CompiledSequentialPath::~CompiledSequentialPath()
+{
+    surfaces_.clear();
+}
+
+void CompiledSequentialPath::Clear()
+{
+    surfaces_.clear();
+}
+
+void CompiledSequentialPath::Append(Surface *s, double thi, double n)
+{
+    surfaces_.push_back( Compile(s, thi, n) );
+}
+
+CompiledSurface CompiledSequentialPath::Compile(Surface *s, double thi, double n)
+{
+    CompiledSurface cs;
+
+    cs.profile   = CompiledProfileType::Spherical;
+    cs.cv        = s->Curvature();
+    cs.conic     = 0.0;
+    cs.tolerance = 0.0;
+    cs.num_terms = 0;
+    for(int i = 0; i < CompiledSurface::max_terms; i++){
+        cs.terms[i] = 0.0;
+    }
+
+    if(s->IsProfile<EvenPolynomial>()){
+        auto prf = s->Profile<EvenPolynomial>();
+        cs.profile   = CompiledProfileType::EvenPolynomial;
+        cs.conic     = prf->Conic();
+        cs.tolerance = prf->Tolerance();
+        const int num_terms = std::min(prf->NumberOfTerms(), (int)CompiledSurface::max_terms);
+        for(int i = 0; i < num_terms; i++){
+            cs.terms[i] = prf->GetNthTerm(i);
+            if(cs.terms[i] != 0.0){
+                cs.num_terms = i + 1; // trailing zero terms are skipped
+            }
+        }
+    }else if(s->IsProfile<OddPolynomial>()){
+        auto prf = s->Profile<OddPolynomial>();
+        cs.profile   = CompiledProfileType::OddPolynomial;
+        cs.conic     = prf->Conic();
+        cs.tolerance = prf->Tolerance();
+        const int num_terms = std::min(prf->NumberOfTerms(), (int)CompiledSurface::max_terms);
+        for(int i = 0; i < num_terms; i++){
+            cs.terms[i] = prf->GetNthTerm(i);
+            if(cs.terms[i] != 0.0){
+                cs.num_terms = i + 1; // trailing zero terms are skipped
+            }
+        }
+    }
+
+    const Transformation& tfrm = s->LocalTransform();
+    for(int i = 0; i < 3; i++){
+        for(int j = 0; j < 3; j++){
+            cs.rotation[3*i + j] = tfrm.rotation(i, j);
+        }
+        cs.transfer[i] = tfrm.transfer(i);
+    }
+
+    cs.distance         = thi;
+    cs.refractive_index = n;
+
+    cs.aperture        = CompiledApertureType::None;
+    cs.aperture_radius = 0.0;
+    if(s->IsAperture<Circular>()){
+        cs.aperture        = CompiledApertureType::Circular;
+        cs.aperture_radius = s->GetClearAperture<Circular>()->Radius();
+    }
+
+    cs.surface = s;
+
+    return cs;
+}
@@ -0,0 +1,578 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#include <cmath>
+#include <atomic>
+#include <algorithm>
+
+#include "sequential/conic_kernel.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define GEOPTER_X86_SIMD
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// FMA contraction is disabled so that the vector paths round the same way as the scalar path.
+#if defined(__clang__)
+#define GEOPTER_TARGET_AVX2   __attribute__((target("avx2")))
+#define GEOPTER_TARGET_AVX512 __attribute__((target("avx512f")))
+#elif defined(__GNUC__)
+#define GEOPTER_TARGET_AVX2   __attribute__((target("avx2"), optimize("fp-contract=off")))
+#define GEOPTER_TARGET_AVX512 __attribute__((target("avx512f"), optimize("fp-contract=off")))
+#else
+#define GEOPTER_TARGET_AVX2
+#define GEOPTER_TARGET_AVX512
+#endif
+
+using namespace geopter;
+
+namespace {
+
+/** Pointers to the incident and outgoing data of one surface */
+struct KernelData
+{
+    const double *x0, *y0, *z0, *l0, *m0, *n0, *opl0;
+    double *x1, *y1, *z1, *l1, *m1, *n1;
+    double *dist, *opl;
+    const TraceError *status;
+    TraceError *result;
+};
+
+
+void IntersectAndRefractScalar(const KernelData& d, const ConicKernel::Parameters& prm, int begin, int end)
+{
+    const double* r = prm.rotation;
+    const double cv = prm.cv;
+    const double k  = prm.conic;
+
+    for(int i = begin; i < end; i++)
+    {
+        if(d.status[i] != TRACE_SUCCESS){
+            continue;
+        }
+
+        const double px = d.x0[i] - prm.transfer[0];
+        const double py = d.y0[i] - prm.transfer[1];
+        const double pz = d.z0[i] - prm.transfer[2];
+
+        const double l = d.l0[i];
+        const double m = d.m0[i];
+        const double n = d.n0[i];
+
+        // relative source point and direction looked from the current surface
+        const double rpx = r[0]*px + r[1]*py + r[2]*pz;
+        const double rpy = r[3]*px + r[4]*py + r[5]*pz;
+        const double rpz = r[6]*px + r[7]*py + r[8]*pz;
+        const double rdx = r[0]*l + r[1]*m + r[2]*n;
+        const double rdy = r[3]*l + r[4]*m + r[5]*n;
+        const double rdz = r[6]*l + r[7]*m + r[8]*n;
+
+        // foot of perpendicular
+        const double s0 = -(rpx*rdx + rpy*rdy + rpz*rdz);
+        const double fx = rpx + s0*rdx;
+        const double fy = rpy + s0*rdy;
+        const double fz = rpz + s0*rdz;
+
+        // c(x^2 + y^2 + (1+k)z^2) - 2z = 0
+        const double a  = cv*(1.0 + k*rdz*rdz);
+        const double b  = cv*(rdx*fx + rdy*fy + rdz*fz + k*rdz*fz) - rdz;
+        const double cc = cv*(fx*fx + fy*fy + fz*fz + k*fz*fz) - 2.0*fz;
+
+        const double inside_sqrt = b*b - a*cc;
+        if(inside_sqrt < 0.0){
+            d.result[i] = TRACE_MISSEDSURFACE_ERROR;
+            continue;
+        }
+
+        const double s1 = cc/(sqrt(inside_sqrt) - b);
+        const double ix = fx + s1*rdx;
+        const double iy = fy + s1*rdy;
+        const double iz = fz + s1*rdz;
+
+        // surface normal
+        double gx = -cv*ix;
+        double gy = -cv*iy;
+        double gz = 1.0 - cv*(1.0 + k)*iz;
+        const double g_inv = 1.0/sqrt(gx*gx + gy*gy + gz*gz);
+        gx *= g_inv;
+        gy *= g_inv;
+        gz *= g_inv;
+
+        // refraction
+        const double cosI = l*gx + m*gy + n*gz;
+        const double inside_sqrt_bend = prm.n_out*prm.n_out - prm.n_in*prm.n_in*(1.0 - cosI*cosI);
+
+        // on TIR the incident direction and the previous optical path length are kept, as in the single ray trace
+        double ox, oy, oz, opl;
+        if(inside_sqrt_bend < 0.0){
+            ox = l;
+            oy = m;
+            oz = n;
+            opl = d.opl0[i];
+            d.result[i] = TRACE_TIR_ERROR;
+        }else{
+            const double cosI_sgn = (cosI > 0.0) - (cosI < 0.0);
+            const double alpha = sqrt(inside_sqrt_bend)*cosI_sgn - prm.n_in*cosI;
+            ox = (prm.n_in*l + alpha*gx)/prm.n_out;
+            oy = (prm.n_in*m + alpha*gy)/prm.n_out;
+            oz = (prm.n_in*n + alpha*gz)/prm.n_out;
+            opl = prm.n_in*(s0 + s1);
+            d.result[i] = TRACE_SUCCESS;
+        }
+
+        const double o_inv = 1.0/sqrt(ox*ox + oy*oy + oz*oz);
+
+        d.x1[i] = ix;
+        d.y1[i] = iy;
+        d.z1[i] = iz;
+        d.l1[i] = ox*o_inv;
+        d.m1[i] = oy*o_inv;
+        d.n1[i] = oz*o_inv;
+        d.dist[i] = s0 + s1;
+        d.opl[i]  = opl;
+    }
+}
+
+
+#ifdef GEOPTER_X86_SIMD
+
+/** Store only the masked lanes, so that the rows of terminated rays are kept */
+GEOPTER_TARGET_AVX2
+inline void StoreMaskedAVX2(double* dst, __m256d v, __m256i mask, bool all_lanes)
+{
+    if(all_lanes){
+        _mm256_storeu_pd(dst, v);
+    }else{
+        _mm256_maskstore_pd(dst, mask, v);
+    }
+}
+
+GEOPTER_TARGET_AVX2
+int IntersectAndRefractAVX2(const KernelData& d, const ConicKernel::Parameters& prm, int num_rays)
+{
+    constexpr int width = 4;
+    const int end = num_rays - num_rays % width;
+
+    const __m256d r0 = _mm256_set1_pd(prm.rotation[0]);
+    const __m256d r1 = _mm256_set1_pd(prm.rotation[1]);
+    const __m256d r2 = _mm256_set1_pd(prm.rotation[2]);
+    const __m256d r3 = _mm256_set1_pd(prm.rotation[3]);
+    const __m256d r4 = _mm256_set1_pd(prm.rotation[4]);
+    const __m256d r5 = _mm256_set1_pd(prm.rotation[5]);
+    const __m256d r6 = _mm256_set1_pd(prm.rotation[6]);
+    const __m256d r7 = _mm256_set1_pd(prm.rotation[7]);
+    const __m256d r8 = _mm256_set1_pd(prm.rotation[8]);
+    const __m256d tx = _mm256_set1_pd(prm.transfer[0]);
+    const __m256d ty = _mm256_set1_pd(prm.transfer[1]);
+    const __m256d tz = _mm256_set1_pd(prm.transfer[2]);
+    const __m256d cv = _mm256_set1_pd(prm.cv);
+    const __m256d k  = _mm256_set1_pd(prm.conic);
+    const __m256d cv_ec = _mm256_set1_pd(prm.cv*(1.0 + prm.conic));
+    const __m256d n_in  = _mm256_set1_pd(prm.n_in);
+    const __m256d n_out = _mm256_set1_pd(prm.n_out);
+    const __m256d n_out2 = _mm256_set1_pd(prm.n_out*prm.n_out);
+    const __m256d n_in2  = _mm256_set1_pd(prm.n_in*prm.n_in);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one  = _mm256_set1_pd(1.0);
+    const __m256d two  = _mm256_set1_pd(2.0);
+
+    for(int i = 0; i < end; i += width)
+    {
+        const __m256i live = _mm256_set_epi64x(-(long long)(d.status[i + 3] == TRACE_SUCCESS), -(long long)(d.status[i + 2] == TRACE_SUCCESS),
+                                               -(long long)(d.status[i + 1] == TRACE_SUCCESS), -(long long)(d.status[i] == TRACE_SUCCESS));
+        const int live_bits = _mm256_movemask_pd(_mm256_castsi256_pd(live));
+        if(live_bits == 0){
+            continue;
+        }
+
+        const __m256d px = _mm256_sub_pd(_mm256_loadu_pd(d.x0 + i), tx);
+        const __m256d py = _mm256_sub_pd(_mm256_loadu_pd(d.y0 + i), ty);
+        const __m256d pz = _mm256_sub_pd(_mm256_loadu_pd(d.z0 + i), tz);
+        const __m256d l  = _mm256_loadu_pd(d.l0 + i);
+        const __m256d m  = _mm256_loadu_pd(d.m0 + i);
+        const __m256d n  = _mm256_loadu_pd(d.n0 + i);
+
+        const __m256d rpx = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(r0, px), _mm256_mul_pd(r1, py)), _mm256_mul_pd(r2, pz));
+        const __m256d rpy = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(r3, px), _mm256_mul_pd(r4, py)), _mm256_mul_pd(r5, pz));
+        const __m256d rpz = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(r6, px), _mm256_mul_pd(r7, py)), _mm256_mul_pd(r8, pz));
+        const __m256d rdx = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(r0, l), _mm256_mul_pd(r1, m)), _mm256_mul_pd(r2, n));
+        const __m256d rdy = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(r3, l), _mm256_mul_pd(r4, m)), _mm256_mul_pd(r5, n));
+        const __m256d rdz = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(r6, l), _mm256_mul_pd(r7, m)), _mm256_mul_pd(r8, n));
+
+        const __m256d s0 = _mm256_sub_pd(zero, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(rpx, rdx), _mm256_mul_pd(rpy, rdy)), _mm256_mul_pd(rpz, rdz)));
+        const __m256d fx = _mm256_add_pd(rpx, _mm256_mul_pd(s0, rdx));
+        const __m256d fy = _mm256_add_pd(rpy, _mm256_mul_pd(s0, rdy));
+        const __m256d fz = _mm256_add_pd(rpz, _mm256_mul_pd(s0, rdz));
+
+        const __m256d a  = _mm256_mul_pd(cv, _mm256_add_pd(one, _mm256_mul_pd(k, _mm256_mul_pd(rdz, rdz))));
+        const __m256d dp = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(rdx, fx), _mm256_mul_pd(rdy, fy)), _mm256_mul_pd(rdz, fz)), _mm256_mul_pd(k, _mm256_mul_pd(rdz, fz)));
+        const __m256d b  = _mm256_sub_pd(_mm256_mul_pd(cv, dp), rdz);
+        const __m256d pp = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(fx, fx), _mm256_mul_pd(fy, fy)), _mm256_mul_pd(fz, fz)), _mm256_mul_pd(k, _mm256_mul_pd(fz, fz)));
+        const __m256d cc = _mm256_sub_pd(_mm256_mul_pd(cv, pp), _mm256_mul_pd(two, fz));
+
+        const __m256d inside_sqrt = _mm256_sub_pd(_mm256_mul_pd(b, b), _mm256_mul_pd(a, cc));
+        const __m256d missed = _mm256_cmp_pd(inside_sqrt, zero, _CMP_LT_OQ);
+
+        const __m256d s1 = _mm256_div_pd(cc, _mm256_sub_pd(_mm256_sqrt_pd(inside_sqrt), b));
+        const __m256d ix = _mm256_add_pd(fx, _mm256_mul_pd(s1, rdx));
+        const __m256d iy = _mm256_add_pd(fy, _mm256_mul_pd(s1, rdy));
+        const __m256d iz = _mm256_add_pd(fz, _mm256_mul_pd(s1, rdz));
+
+        __m256d gx = _mm256_sub_pd(zero, _mm256_mul_pd(cv, ix));
+        __m256d gy = _mm256_sub_pd(zero, _mm256_mul_pd(cv, iy));
+        __m256d gz = _mm256_sub_pd(one, _mm256_mul_pd(cv_ec, iz));
+        const __m256d g_inv = _mm256_div_pd(one, _mm256_sqrt_pd(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(gx, gx), _mm256_mul_pd(gy, gy)), _mm256_mul_pd(gz, gz))));
+        gx = _mm256_mul_pd(gx, g_inv);
+        gy = _mm256_mul_pd(gy, g_inv);
+        gz = _mm256_mul_pd(gz, g_inv);
+
+        const __m256d cosI = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(l, gx), _mm256_mul_pd(m, gy)), _mm256_mul_pd(n, gz));
+        const __m256d inside_sqrt_bend = _mm256_sub_pd(n_out2, _mm256_mul_pd(n_in2, _mm256_sub_pd(one, _mm256_mul_pd(cosI, cosI))));
+        const __m256d tir = _mm256_cmp_pd(inside_sqrt_bend, zero, _CMP_LT_OQ);
+
+        const __m256d root = _mm256_sqrt_pd(inside_sqrt_bend);
+        __m256d n_cosIp = _mm256_and_pd(_mm256_cmp_pd(cosI, zero, _CMP_GT_OQ), root);
+        n_cosIp = _mm256_blendv_pd(n_cosIp, _mm256_sub_pd(zero, root), _mm256_cmp_pd(cosI, zero, _CMP_LT_OQ));
+        const __m256d alpha = _mm256_sub_pd(n_cosIp, _mm256_mul_pd(n_in, cosI));
+
+        __m256d ox = _mm256_div_pd(_mm256_add_pd(_mm256_mul_pd(n_in, l), _mm256_mul_pd(alpha, gx)), n_out);
+        __m256d oy = _mm256_div_pd(_mm256_add_pd(_mm256_mul_pd(n_in, m), _mm256_mul_pd(alpha, gy)), n_out);
+        __m256d oz = _mm256_div_pd(_mm256_add_pd(_mm256_mul_pd(n_in, n), _mm256_mul_pd(alpha, gz)), n_out);
+        ox = _mm256_blendv_pd(ox, l, tir);
+        oy = _mm256_blendv_pd(oy, m, tir);
+        oz = _mm256_blendv_pd(oz, n, tir);
+        const __m256d o_inv = _mm256_div_pd(one, _mm256_sqrt_pd(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(ox, ox), _mm256_mul_pd(oy, oy)), _mm256_mul_pd(oz, oz))));
+
+        const __m256d dist = _mm256_add_pd(s0, s1);
+        const __m256d opl  = _mm256_blendv_pd(_mm256_mul_pd(n_in, dist), _mm256_loadu_pd(d.opl0 + i), tir);
+
+        // rays missing the surface are not written, as in the scalar path
+        const __m256i write = _mm256_castpd_si256(_mm256_andnot_pd(missed, _mm256_castsi256_pd(live)));
+        const bool write_all = (_mm256_movemask_pd(_mm256_castsi256_pd(write)) == 0xF);
+
+        StoreMaskedAVX2(d.x1 + i, ix, write, write_all);
+        StoreMaskedAVX2(d.y1 + i, iy, write, write_all);
+        StoreMaskedAVX2(d.z1 + i, iz, write, write_all);
+        StoreMaskedAVX2(d.l1 + i, _mm256_mul_pd(ox, o_inv), write, write_all);
+        StoreMaskedAVX2(d.m1 + i, _mm256_mul_pd(oy, o_inv), write, write_all);
+        StoreMaskedAVX2(d.n1 + i, _mm256_mul_pd(oz, o_inv), write, write_all);
+        StoreMaskedAVX2(d.dist + i, dist, write, write_all);
+        StoreMaskedAVX2(d.opl + i, opl, write, write_all);
+
+        const int missed_bits = _mm256_movemask_pd(missed);
+        const int tir_bits    = _mm256_movemask_pd(tir);
+        for(int j = 0; j < width; j++){
+            if(!(live_bits & (1 << j))){
+                continue;
+            }
+            if(missed_bits & (1 << j)){
+                d.result[i + j] = TRACE_MISSEDSURFACE_ERROR;
+            }else if(tir_bits & (1 << j)){
+                d.result[i + j] = TRACE_TIR_ERROR;
+            }else{
+                d.result[i + j] = TRACE_SUCCESS;
+            }
+        }
+    }
+
+    return end;
+}
+
+
+/** Square root without an undefined pass-through operand */
+GEOPTER_TARGET_AVX512
+inline __m512d SqrtAVX512(__m512d v)
+{
+    return _mm512_maskz_sqrt_pd(0xFF, v);
+}
+
+GEOPTER_TARGET_AVX512
+int IntersectAndRefractAVX512(const KernelData& d, const ConicKernel::Parameters& prm, int num_rays)
+{
+    constexpr int width = 8;
+    const int end = num_rays - num_rays % width;
+
+    const __m512d r0 = _mm512_set1_pd(prm.rotation[0]);
+    const __m512d r1 = _mm512_set1_pd(prm.rotation[1]);
+    const __m512d r2 = _mm512_set1_pd(prm.rotation[2]);
+    const __m512d r3 = _mm512_set1_pd(prm.rotation[3]);
+    const __m512d r4 = _mm512_set1_pd(prm.rotation[4]);
+    const __m512d r5 = _mm512_set1_pd(prm.rotation[5]);
+    const __m512d r6 = _mm512_set1_pd(prm.rotation[6]);
+    const __m512d r7 = _mm512_set1_pd(prm.rotation[7]);
+    const __m512d r8 = _mm512_set1_pd(prm.rotation[8]);
+    const __m512d tx = _mm512_set1_pd(prm.transfer[0]);
+    const __m512d ty = _mm512_set1_pd(prm.transfer[1]);
+    const __m512d tz = _mm512_set1_pd(prm.transfer[2]);
+    const __m512d cv = _mm512_set1_pd(prm.cv);
+    const __m512d k  = _mm512_set1_pd(prm.conic);
+    const __m512d cv_ec = _mm512_set1_pd(prm.cv*(1.0 + prm.conic));
+    const __m512d n_in  = _mm512_set1_pd(prm.n_in);
+    const __m512d n_out = _mm512_set1_pd(prm.n_out);
+    const __m512d n_out2 = _mm512_set1_pd(prm.n_out*prm.n_out);
+    const __m512d n_in2  = _mm512_set1_pd(prm.n_in*prm.n_in);
+    const __m512d zero = _mm512_setzero_pd();
+    const __m512d one  = _mm512_set1_pd(1.0);
+    const __m512d two  = _mm512_set1_pd(2.0);
+
+    for(int i = 0; i < end; i += width)
+    {
+        __mmask8 live = 0;
+        for(int j = 0; j < width; j++){
+            if(d.status[i + j] == TRACE_SUCCESS){
+                live |= (1 << j);
+            }
+        }
+        if(live == 0){
+            continue;
+        }
+
+        const __m512d px = _mm512_sub_pd(_mm512_loadu_pd(d.x0 + i), tx);
+        const __m512d py = _mm512_sub_pd(_mm512_loadu_pd(d.y0 + i), ty);
+        const __m512d pz = _mm512_sub_pd(_mm512_loadu_pd(d.z0 + i), tz);
+        const __m512d l  = _mm512_loadu_pd(d.l0 + i);
+        const __m512d m  = _mm512_loadu_pd(d.m0 + i);
+        const __m512d n  = _mm512_loadu_pd(d.n0 + i);
+
+        const __m512d rpx = _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(r0, px), _mm512_mul_pd(r1, py)), _mm512_mul_pd(r2, pz));
+        const __m512d rpy = _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(r3, px), _mm512_mul_pd(r4, py)), _mm512_mul_pd(r5, pz));
+        const __m512d rpz = _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(r6, px), _mm512_mul_pd(r7, py)), _mm512_mul_pd(r8, pz));
+        const __m512d rdx = _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(r0, l), _mm512_mul_pd(r1, m)), _mm512_mul_pd(r2, n));
+        const __m512d rdy = _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(r3, l), _mm512_mul_pd(r4, m)), _mm512_mul_pd(r5, n));
+        const __m512d rdz = _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(r6, l), _mm512_mul_pd(r7, m)), _mm512_mul_pd(r8, n));
+
+        const __m512d s0 = _mm512_sub_pd(zero, _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(rpx, rdx), _mm512_mul_pd(rpy, rdy)), _mm512_mul_pd(rpz, rdz)));
+        const __m512d fx = _mm512_add_pd(rpx, _mm512_mul_pd(s0, rdx));
+        const __m512d fy = _mm512_add_pd(rpy, _mm512_mul_pd(s0, rdy));
+        const __m512d fz = _mm512_add_pd(rpz, _mm512_mul_pd(s0, rdz));
+
+        const __m512d a  = _mm512_mul_pd(cv, _mm512_add_pd(one, _mm512_mul_pd(k, _mm512_mul_pd(rdz, rdz))));
+        const __m512d dp = _mm512_add_pd(_mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(rdx, fx), _mm512_mul_pd(rdy, fy)), _mm512_mul_pd(rdz, fz)), _mm512_mul_pd(k, _mm512_mul_pd(rdz, fz)));
+        const __m512d b  = _mm512_sub_pd(_mm512_mul_pd(cv, dp), rdz);
+        const __m512d pp = _mm512_add_pd(_mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(fx, fx), _mm512_mul_pd(fy, fy)), _mm512_mul_pd(fz, fz)), _mm512_mul_pd(k, _mm512_mul_pd(fz, fz)));
+        const __m512d cc = _mm512_sub_pd(_mm512_mul_pd(cv, pp), _mm512_mul_pd(two, fz));
+
+        const __m512d inside_sqrt = _mm512_sub_pd(_mm512_mul_pd(b, b), _mm512_mul_pd(a, cc));
+        const __mmask8 missed = _mm512_cmp_pd_mask(inside_sqrt, zero, _CMP_LT_OQ);
+
+        const __m512d s1 = _mm512_div_pd(cc, _mm512_sub_pd(SqrtAVX512(inside_sqrt), b));
+        const __m512d ix = _mm512_add_pd(fx, _mm512_mul_pd(s1, rdx));
+        const __m512d iy = _mm512_add_pd(fy, _mm512_mul_pd(s1, rdy));
+        const __m512d iz = _mm512_add_pd(fz, _mm512_mul_pd(s1, rdz));
+
+        __m512d gx = _mm512_sub_pd(zero, _mm512_mul_pd(cv, ix));
+        __m512d gy = _mm512_sub_pd(zero, _mm512_mul_pd(cv, iy));
+        __m512d gz = _mm512_sub_pd(one, _mm512_mul_pd(cv_ec, iz));
+        const __m512d g_inv = _mm512_div_pd(one, SqrtAVX512(_mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(gx, gx), _mm512_mul_pd(gy, gy)), _mm512_mul_pd(gz, gz))));
+        gx = _mm512_mul_pd(gx, g_inv);
+        gy = _mm512_mul_pd(gy, g_inv);
+        gz = _mm512_mul_pd(gz, g_inv);
+
+        const __m512d cosI = _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(l, gx), _mm512_mul_pd(m, gy)), _mm512_mul_pd(n, gz));
+        const __m512d inside_sqrt_bend = _mm512_sub_pd(n_out2, _mm512_mul_pd(n_in2, _mm512_sub_pd(one, _mm512_mul_pd(cosI, cosI))));
+        const __mmask8 tir = _mm512_cmp_pd_mask(inside_sqrt_bend, zero, _CMP_LT_OQ);
+
+        const __m512d root = SqrtAVX512(inside_sqrt_bend);
+        __m512d n_cosIp = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(cosI, zero, _CMP_GT_OQ), zero, root);
+        n_cosIp = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(cosI, zero, _CMP_LT_OQ), n_cosIp, _mm512_sub_pd(zero, root));
+        const __m512d alpha = _mm512_sub_pd(n_cosIp, _mm512_mul_pd(n_in, cosI));
+
+        __m512d ox = _mm512_div_pd(_mm512_add_pd(_mm512_mul_pd(n_in, l), _mm512_mul_pd(alpha, gx)), n_out);
+        __m512d oy = _mm512_div_pd(_mm512_add_pd(_mm512_mul_pd(n_in, m), _mm512_mul_pd(alpha, gy)), n_out);
+        __m512d oz = _mm512_div_pd(_mm512_add_pd(_mm512_mul_pd(n_in, n), _mm512_mul_pd(alpha, gz)), n_out);
+        ox = _mm512_mask_blend_pd(tir, ox, l);
+        oy = _mm512_mask_blend_pd(tir, oy, m);
+        oz = _mm512_mask_blend_pd(tir, oz, n);
+        const __m512d o_inv = _mm512_div_pd(one, SqrtAVX512(_mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(ox, ox), _mm512_mul_pd(oy, oy)), _mm512_mul_pd(oz, oz))));
+
+        const __m512d dist = _mm512_add_pd(s0, s1);
+        const __m512d opl  = _mm512_mask_blend_pd(tir, _mm512_mul_pd(n_in, dist), _mm512_loadu_pd(d.opl0 + i));
+
+        // rays missing the surface are not written, as in the scalar path
+        const __mmask8 write = live & ~missed;
+
+        _mm512_mask_storeu_pd(d.x1 + i, write, ix);
+        _mm512_mask_storeu_pd(d.y1 + i, write, iy);
+        _mm512_mask_storeu_pd(d.z1 + i, write, iz);
+        _mm512_mask_storeu_pd(d.l1 + i, write, _mm512_mul_pd(ox, o_inv));
+        _mm512_mask_storeu_pd(d.m1 + i, write, _mm512_mul_pd(oy, o_inv));
+        _mm512_mask_storeu_pd(d.n1 + i, write, _mm512_mul_pd(oz, o_inv));
+        _mm512_mask_storeu_pd(d.dist + i, write, dist);
+        _mm512_mask_storeu_pd(d.opl + i, write, opl);
+
+        for(int j = 0; j < width; j++){
+            if(!(live & (1 << j))){
+                continue;
+            }
+            if(missed & (1 << j)){
+                d.result[i + j] = TRACE_MISSEDSURFACE_ERROR;
+            }else if(tir & (1 << j)){
+                d.result[i + j] = TRACE_TIR_ERROR;
+            }else{
+                d.result[i + j] = TRACE_SUCCESS;
+            }
+        }
+    }
+
+    return end;
+}
+
+#endif // GEOPTER_X86_SIMD
+
+
+SimdInstructionSet DetectInstructionSetImpl()
+{
+#if defined(GEOPTER_X86_SIMD) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f")){
+        return SimdInstructionSet::AVX512;
+    }
+    if(__builtin_cpu_supports("avx2")){
+        return SimdInstructionSet::AVX2;
+    }
+#elif defined(GEOPTER_X86_SIMD) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    const int max_leaf = info[0];
+
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx     = (info[2] & (1 << 28)) != 0;
+    if(max_leaf >= 7 && osxsave && avx){
+        const unsigned long long xcr0 = _xgetbv(0);
+        __cpuidex(info, 7, 0);
+        const bool avx2    = (info[1] & (1 << 5)) != 0;
+        const bool avx512f = (info[1] & (1 << 16)) != 0;
+        if(avx512f && (xcr0 & 0xE6) == 0xE6){
+            return SimdInstructionSet::AVX512;
+        }
+        if(avx2 && (xcr0 & 0x6) == 0x6){
+            return SimdInstructionSet::AVX2;
+        }
+    }
+#endif
+    return SimdInstructionSet::Scalar;
+}
+
+std::atomic<int> active_isa(-1);
+
+} // anonymous namespace
+
+
+ConicKernel::Parameters ConicKernel::CreateParameters(const CompiledSurface &before_srf, const CompiledSurface &cur_srf)
+{
+    Parameters prm;
+
+    for(int i = 0; i < 9; i++){
+        prm.rotation[i] = before_srf.rotation[i];
+    }
+    for(int i = 0; i < 3; i++){
+        prm.transfer[i] = before_srf.transfer[i];
+    }
+
+    prm.cv    = cur_srf.cv;
+    prm.conic = cur_srf.conic;
+    prm.n_in  = before_srf.refractive_index;
+    prm.n_out = cur_srf.refractive_index;
+
+    return prm;
+}
+
+void ConicKernel::IntersectAndRefract(RayBundle &bundle, int srf_index, const Parameters &prm, TraceError *result)
+{
+    KernelData d;
+    d.x0 = bundle.XData(srf_index - 1);
+    d.y0 = bundle.YData(srf_index - 1);
+    d.z0 = bundle.ZData(srf_index - 1);
+    d.l0 = bundle.LData(srf_index - 1);
+    d.m0 = bundle.MData(srf_index - 1);
+    d.n0 = bundle.NData(srf_index - 1);
+    d.opl0 = bundle.OpticalPathLengthData(srf_index - 1);
+    d.x1 = bundle.XData(srf_index);
+    d.y1 = bundle.YData(srf_index);
+    d.z1 = bundle.ZData(srf_index);
+    d.l1 = bundle.LData(srf_index);
+    d.m1 = bundle.MData(srf_index);
+    d.n1 = bundle.NData(srf_index);
+    d.dist = bundle.PathLengthData(srf_index);
+    d.opl  = bundle.OpticalPathLengthData(srf_index);
+    d.status = bundle.StatusData();
+    d.result = result;
+
+    const int num_rays = bundle.NumberOfRays();
+    int done = 0;
+
+#ifdef GEOPTER_X86_SIMD
+    switch (InstructionSet()) {
+    case SimdInstructionSet::AVX512:
+        done = IntersectAndRefractAVX512(d, prm, num_rays);
+        break;
+    case SimdInstructionSet::AVX2:
+        done = IntersectAndRefractAVX2(d, prm, num_rays);
+        break;
+    default:
+        break;
+    }
+#endif
+
+    IntersectAndRefractScalar(d, prm, done, num_rays);
+}
+
+SimdInstructionSet ConicKernel::DetectInstructionSet()
+{
+    static const SimdInstructionSet detected = DetectInstructionSetImpl();
+    return detected;
+}
+
+SimdInstructionSet ConicKernel::InstructionSet()
+{
+    int isa = active_isa.load(std::memory_order_relaxed);
+    if(isa < 0){
+        isa = static_cast<int>(DetectInstructionSet());
+        active_isa.store(isa, std::memory_order_relaxed);
+    }
+    return static_cast<SimdInstructionSet>(isa);
+}
+
+void ConicKernel::SetInstructionSet(SimdInstructionSet isa)
+{
+    const int detected = static_cast<int>(DetectInstructionSet());
+    active_isa.store(std::min(static_cast<int>(isa), detected), std::memory_order_relaxed);
+}
+
+std::string ConicKernel::InstructionSetName(SimdInstructionSet isa)
+{
+    switch (isa) {
+    case SimdInstructionSet::AVX512:
+        return "AVX-512";
+    case SimdInstructionSet::AVX2:
+        return "AVX2";
+    default:
+        return "Scalar";
+    }
+}
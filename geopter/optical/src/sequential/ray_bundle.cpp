@@ -0,0 +1,157 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#include <algorithm>
+
+#include "sequential/ray_bundle.h"
+
+using namespace geopter;
+
+RayBundle::RayBundle() :
+    num_rays_(0),
+    num_srfs_(0),
+    image_only_(false),
+    wvl_(0.0)
+{
+
+}
+
+RayBundle::RayBundle(int num_rays, int num_srfs, bool image_only) :
+    num_rays_(0),
+    num_srfs_(0),
+    image_only_(false),
+    wvl_(0.0)
+{
+    this->Allocate(num_rays, num_srfs, image_only);
+}
+
+RayBundle::~RayBundle()
+{
+    this->Clear();
+}
+
+void RayBundle::Allocate(int num_rays, int num_srfs, bool image_only)
+{
+    num_rays_   = num_rays;
+    num_srfs_   = num_srfs;
+    image_only_ = image_only;
+
+    const size_t num_rows = image_only ? std::min(2, num_srfs) : num_srfs;
+    const size_t n = (size_t)num_rays * num_rows;
+
+    x_.assign(n, 0.0);
+    y_.assign(n, 0.0);
+    z_.assign(n, 0.0);
+    l_.assign(n, 0.0);
+    m_.assign(n, 0.0);
+    n_.assign(n, 0.0);
+    dist_.assign(n, 0.0);
+    opl_.assign(n, 0.0);
+    opl_tot_.assign(num_rays, 0.0);
+
+    status_.assign(num_rays, TRACE_NOT_REACHED_ERROR);
+    reached_.assign(num_rays, 0);
+    px_.assign(num_rays, 0.0);
+    py_.assign(num_rays, 0.0);
+}
+
+void RayBundle::Clear()
+{
+    x_.clear();
+    y_.clear();
+    z_.clear();
+    l_.clear();
+    m_.clear();
+    n_.clear();
+    dist_.clear();
+    opl_.clear();
+    opl_tot_.clear();
+    status_.clear();
+    reached_.clear();
+    px_.clear();
+    py_.clear();
+
+    num_rays_ = 0;
+    num_srfs_ = 0;
+}
+
+void RayBundle::SetInitialRay(int ray_index, const Eigen::Vector3d &pt0, const Eigen::Vector3d &dir0)
+{
+    this->SetData(ray_index, 0, pt0, dir0, 0.0, 0.0);
+    opl_tot_[ray_index] = 0.0;
+    status_[ray_index]  = TRACE_NOT_REACHED_ERROR;
+    reached_[ray_index] = 0;
+}
+
+void RayBundle::SetPupilCoordinate(int ray_index, const Eigen::Vector2d &pupil)
+{
+    px_[ray_index] = pupil(0);
+    py_[ray_index] = pupil(1);
+}
+
+Eigen::Vector2d RayBundle::PupilCoordinate(int ray_index) const
+{
+    return Eigen::Vector2d(px_[ray_index], py_[ray_index]);
+}
+
+Eigen::Vector3d RayBundle::IntersectPt(int ray_index, int srf_index) const
+{
+    const size_t k = Offset(ray_index, srf_index);
+    return Eigen::Vector3d(x_[k], y_[k], z_[k]);
+}
+
+Eigen::Vector3d RayBundle::Direction(int ray_index, int srf_index) const
+{
+    const size_t k = Offset(ray_index, srf_index);
+    return Eigen::Vector3d(l_[k], m_[k], n_[k]);
+}
+
+void RayBundle::SetData(int ray_index, int srf_index, const Eigen::Vector3d &pt, const Eigen::Vector3d &dir, double dist, double opl)
+{
+    const size_t k = Offset(ray_index, srf_index);
+    x_[k] = pt(0);
+    y_[k] = pt(1);
+    z_[k] = pt(2);
+    l_[k] = dir(0);
+    m_[k] = dir(1);
+    n_[k] = dir(2);
+    dist_[k] = dist;
+    opl_[k]  = opl;
+}
+
+double RayBundle::OpticalPathLength(int ray_index) const
+{
+    if(image_only_){
+        return opl_tot_[ray_index];
+    }
+
+    // unreached rows hold no data of this ray
+    double opl_tot = 0.0;
+    const int last = std::min(num_srfs_ - 1, reached_[ray_index] + 1);
+    for(int si = 2; si < last; si++){
+        opl_tot += opl_[Offset(ray_index, si)];
+    }
+    return opl_tot;
+}
@@ -0,0 +1,115 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#include "sequential/ray_derivative.h"
+#include "sequential/compiled_sequential_path.h"
+
+using namespace geopter;
+
+bool TraceParameter::Check(const CompiledSequentialPath &path) const
+{
+    const int path_size = path.Size();
+
+    switch (type) {
+    case Curvature:
+        return (index >= 0 && index < path_size);
+    case Thickness:
+    {
+        if(index < 0 || index >= path_size - 1){
+            return false;
+        }
+        // only the axial transfer is seeded, so the gap must not be decentered or tilted
+        const CompiledSurface& srf = path.At(index);
+        for(int i = 0; i < 3; i++){
+            for(int j = 0; j < 3; j++){
+                if(srf.rotation[3*i + j] != ((i == j) ? 1.0 : 0.0)){
+                    return false;
+                }
+            }
+        }
+        return (srf.transfer[0] == 0.0 && srf.transfer[1] == 0.0);
+    }
+    case Conic:
+    case PolynomialTerm:
+    {
+        if(index < 0 || index >= path_size){
+            return false;
+        }
+        const CompiledSurface& srf = path.At(index);
+        if(srf.profile == CompiledProfileType::Spherical){
+            return false;
+        }
+        return (type == Conic) || (term >= 0 && term < CompiledSurface::max_terms);
+    }
+    default:
+        return false;
+    }
+}
+
+
+RayDerivative::RayDerivative() :
+    num_params_(0)
+{
+
+}
+
+RayDerivative::~RayDerivative()
+{
+    this->Clear();
+}
+
+void RayDerivative::Allocate(int num_segments, int num_params)
+{
+    num_params_ = num_params;
+    pts_.assign(num_segments, Eigen::Matrix3Xd::Zero(3, num_params));
+    dirs_.assign(num_segments, Eigen::Matrix3Xd::Zero(3, num_params));
+    opl_ = Eigen::MatrixXd::Zero(num_segments, num_params);
+}
+
+void RayDerivative::Clear()
+{
+    pts_.clear();
+    dirs_.clear();
+    opl_.resize(0, 0);
+    num_params_ = 0;
+}
+
+void RayDerivative::SetData(int srf_index, int col, const Eigen::Matrix3Xd &pt, const Eigen::Matrix3Xd &dir, const Eigen::RowVectorXd &opl)
+{
+    const int n = pt.cols();
+    pts_[srf_index].middleCols(col, n)  = pt;
+    dirs_[srf_index].middleCols(col, n) = dir;
+    opl_.row(srf_index).segment(col, n) = opl;
+}
+
+Eigen::RowVectorXd RayDerivative::OpticalPathLength() const
+{
+    Eigen::RowVectorXd opl_tot = Eigen::RowVectorXd::Zero(num_params_);
+    const int last = pts_.size() - 1;
+    for(int i = 2; i < last; i++){
+        opl_tot += opl_.row(i);
+    }
+    return opl_tot;
+}
@@ -29,12 +29,14 @@
 #include "sequential/sequential_path.h"
 #include "common/geopter_error.h"
 #include "spec/spectral_line.h"
+#include "common/revision_counter.h"
 
 using namespace geopter;
 
 SequentialPath::SequentialPath() :
     wvl_(SpectralLine::d),
-    array_size_(0)
+    array_size_(0),
+    revision_(RevisionCounter::Current())
 {
 
 }
@@ -53,22 +55,26 @@ int SequentialPath::Size() const
 void SequentialPath::Clear()
 {
     seq_path_comps_.clear();
+    compiled_.Clear();
     array_size_ = 0;
+    revision_ = RevisionCounter::Current();
 }
 
 void SequentialPath::Append(SequentialPathComponent seq_path_comp)
 {
     seq_path_comps_.push_back(seq_path_comp);
+    compiled_.Append(seq_path_comp.surface, seq_path_comp.distance, seq_path_comp.refractive_index);
     array_size_ += 1;
 }
 
 void SequentialPath::Append(Surface *s, double thi, double n)
 {
     seq_path_comps_.emplace_back( SequentialPathComponent(s, thi, n) );
+    compiled_.Append(s, thi, n);
     array_size_ += 1;
 }
 
-SequentialPathComponent SequentialPath::At(int i) const
+const SequentialPathComponent& SequentialPath::At(int i) const
 {
     assert(array_size_ == (int)seq_path_comps_.size());
 
@@ -30,13 +30,169 @@
 
 #include <limits>
 #include <iostream>
+#include <algorithm>
 
 #include "paraxial/paraxial_trace.h"
+#include "sequential/conic_kernel.h"
 
 using namespace geopter;
 
+namespace {
+
+/** Same as Eigen's normalized(), written out for dual numbers */
+template<typename T>
+Eigen::Matrix<T,3,1> normalized(const Eigen::Matrix<T,3,1>& v)
+{
+    using std::sqrt;
+    const T len2 = v.squaredNorm();
+    if(ScalarValue(len2) > 0.0){
+        return v/sqrt(len2);
+    }
+    return v;
+}
+
+/** Writes the trace result into a Ray */
+class RayOutput
+{
+public:
+    explicit RayOutput(Ray* ray) : ray_(ray){}
+
+    void SetData(int i, const Eigen::Vector3d& pt, const Eigen::Vector3d& normal, const Eigen::Vector3d& dir, double dist, double opl){
+        ray_->GetSegmentAt(i)->SetData(pt, normal, dir, dist, opl);
+    }
+    void SetSegmentStatus(int i, TraceError s){
+        ray_->GetSegmentAt(i)->SetStatus(s);
+    }
+    void SetStatus(TraceError s, int reached){
+        ray_->SetStatus(s);
+        ray_->SetReachedSurfaceIndex(reached);
+    }
+
+private:
+    Ray* ray_;
+};
+
+/** Writes the values of the dual number trace into a Ray, and the derivatives into a RayDerivative */
+class DualRayOutput
+{
+public:
+    using Vector3 = Eigen::Matrix<DualNumber,3,1>;
+
+    DualRayOutput(Ray* ray, RayDerivative* deriv, int col, int num_cols) :
+        values_(ray),
+        deriv_(deriv),
+        col_(col),
+        pt_(3, num_cols),
+        dir_(3, num_cols),
+        opl_(num_cols)
+    {}
+
+    void SetData(int i, const Vector3& pt, const Vector3& normal, const Vector3& dir, const DualNumber& dist, const DualNumber& opl){
+        values_.SetData(i, value_of(pt), value_of(normal), value_of(dir), dist.value(), opl.value());
+
+        for(int r = 0; r < 3; r++){
+            pt_.row(r)  = derivatives_of(pt(r));
+            dir_.row(r) = derivatives_of(dir(r));
+        }
+        opl_ = derivatives_of(opl);
+        deriv_->SetData(i, col_, pt_, dir_, opl_);
+    }
+    void SetSegmentStatus(int i, TraceError s){
+        values_.SetSegmentStatus(i, s);
+    }
+    void SetStatus(TraceError s, int reached){
+        values_.SetStatus(s, reached);
+    }
+
+private:
+    static Eigen::Vector3d value_of(const Vector3& v){
+        return Eigen::Vector3d(v(0).value(), v(1).value(), v(2).value());
+    }
+
+    /** constants keep empty derivatives */
+    Eigen::RowVectorXd derivatives_of(const DualNumber& x) const{
+        if(x.derivatives().size() == 0){
+            return Eigen::RowVectorXd::Zero(opl_.size());
+        }
+        return x.derivatives().transpose();
+    }
+
+    RayOutput values_;
+    RayDerivative* deriv_;
+    int col_;
+    Eigen::Matrix3Xd pt_;
+    Eigen::Matrix3Xd dir_;
+    Eigen::RowVectorXd opl_;
+};
+
+DualNumber promote_scalar(double x, int num_cols)
+{
+    return DualNumber(x, DualVector::Zero(num_cols));
+}
+
+Eigen::Matrix<DualNumber,3,1> promote_vector(const Eigen::Vector3d& v, int num_cols)
+{
+    return Eigen::Matrix<DualNumber,3,1>(promote_scalar(v(0), num_cols), promote_scalar(v(1), num_cols), promote_scalar(v(2), num_cols));
+}
+
+/** Copy of the compiled surface with zero derivatives */
+BasicCompiledSurface<DualNumber> promote_surface(const CompiledSurface& srf, int num_cols)
+{
+    BasicCompiledSurface<DualNumber> dual_srf;
+
+    dual_srf.profile   = srf.profile;
+    dual_srf.cv        = promote_scalar(srf.cv, num_cols);
+    dual_srf.conic     = promote_scalar(srf.conic, num_cols);
+    dual_srf.tolerance = srf.tolerance;
+    dual_srf.num_terms = srf.num_terms;
+    for(int i = 0; i < CompiledSurface::max_terms; i++){
+        dual_srf.terms[i] = promote_scalar(srf.terms[i], num_cols);
+    }
+    for(int i = 0; i < 9; i++){
+        dual_srf.rotation[i] = srf.rotation[i];
+    }
+    for(int i = 0; i < 3; i++){
+        dual_srf.transfer[i] = promote_scalar(srf.transfer[i], num_cols);
+    }
+    dual_srf.distance         = srf.distance;
+    dual_srf.refractive_index = srf.refractive_index;
+    dual_srf.aperture         = srf.aperture;
+    dual_srf.aperture_radius  = srf.aperture_radius;
+    dual_srf.surface          = srf.surface;
+
+    return dual_srf;
+}
+
+/** Give the k-th unit derivative to the parameter */
+void seed_parameter(BasicCompiledSurface<DualNumber>* dual_path, const TraceParameter& prm, int num_cols, int k)
+{
+    BasicCompiledSurface<DualNumber>& srf = dual_path[prm.index];
+
+    switch (prm.type) {
+    case TraceParameter::Curvature:
+        srf.cv = DualNumber(srf.cv.value(), num_cols, k);
+        break;
+    case TraceParameter::Conic:
+        srf.conic = DualNumber(srf.conic.value(), num_cols, k);
+        break;
+    case TraceParameter::PolynomialTerm:
+        srf.terms[prm.term] = DualNumber(srf.terms[prm.term].value(), num_cols, k);
+        srf.num_terms = std::max(srf.num_terms, prm.term + 1); // trailing zero terms are skipped on compile
+        break;
+    case TraceParameter::Thickness:
+        // transfer to the next surface, along the axis as TraceParameter::Check rejects decentered gaps
+        srf.transfer[2] = DualNumber(srf.transfer[2].value(), num_cols, k);
+        break;
+    default:
+        break;
+    }
+}
+
+}
+
 SequentialTrace::SequentialTrace(OpticalSystem* sys):
-    opt_sys_(sys)
+    opt_sys_(sys),
+    stats_(TraceStatisticsScope::Current(sys))
 {
     do_aperture_check_ = false;
     do_apply_vig_ = true;
@@ -85,9 +241,31 @@ TraceError SequentialTrace::TracePupilRay(RayPtr ray, const SequentialPath &seq_
     return TraceRayThroughoutPath(ray, seq_path, pt0, dir0);
 }
 
+std::vector<Eigen::Vector2d> SequentialTrace::GridPupils(int nrd)
+{
+    if(nrd < 2){
+        return std::vector<Eigen::Vector2d>({Eigen::Vector2d::Zero()});
+    }
+
+    std::vector<Eigen::Vector2d> pupils;
+    pupils.reserve(nrd*nrd);
+
+    const double step = 2.0/static_cast<double>(nrd - 1);
+    for(int i = 0; i < nrd; i++){
+        for(int j = 0; j < nrd; j++){
+            Eigen::Vector2d pupil(-1.0 + step*static_cast<double>(j), -1.0 + step*static_cast<double>(i));
+            if(pupil.norm() <= 1.0){
+                pupils.push_back(pupil);
+            }
+        }
+    }
+    return pupils;
+}
+
 RayPtr SequentialTrace::CreatePupilRay(const Eigen::Vector2d &pupil_crd, const Field *fld, double wvl)
 {
-    SequentialPath seq_path = CreateSequentialPath(wvl);
+    auto seq_path_ptr = GetSequentialPath(wvl);
+    const SequentialPath& seq_path = *seq_path_ptr;
     auto ray = std::make_shared<Ray>(seq_path.Size());
     TracePupilRay(ray, seq_path, pupil_crd, fld, wvl);
 
@@ -98,7 +276,9 @@ bool SequentialTrace::TraceReferenceRays(std::vector<RayPtr> &ref_rays, const Fi
 {
     const int num_srfs = opt_sys_->GetOpticalAssembly()->NumberOfSurfaces();
 
-    SequentialPath seq_path = CreateSequentialPath(wvl);
+    auto seq_path_ptr = GetSequentialPath(wvl);
+
+    const SequentialPath& seq_path = *seq_path_ptr;
 
     ref_rays.clear();
 
@@ -125,79 +305,169 @@ bool SequentialTrace::TraceReferenceRays(std::vector<RayPtr> &ref_rays, const Fi
 
 TraceError SequentialTrace::TraceRayThroughoutPath(RayPtr ray, const SequentialPath &seq_path, const Eigen::Vector3d &pt0, const Eigen::Vector3d &dir0)
 {
-    const int path_size = seq_path.Size();
+    if(!stats_){
+        return TraceRay(ray, seq_path, pt0, dir0, nullptr);
+    }
+
+    TraceStatistics::StageTimer timer(stats_.get(), TraceStatistics::Tracing);
+
+    const int path_size = seq_path.Compiled().Size();
+    // reused over the calls to keep single ray traces free of allocation
+    static thread_local std::vector<long long> iterations;
+    iterations.assign(path_size, 0);
+    const TraceError result = TraceRay(ray, seq_path, pt0, dir0, iterations.data());
+    const int reached = ray->GetReachedSurfaceIndex();
+    stats_->RecordTrace(&result, &reached, 1, path_size, iterations.data());
+
+    return result;
+}
+
+TraceError SequentialTrace::TraceRay(RayPtr ray, const SequentialPath &seq_path, const Eigen::Vector3d &pt0, const Eigen::Vector3d &dir0, long long* iterations)
+{
+    assert(seq_path.Revision() >= opt_sys_->Revision()); // path built before the last edit, see OpticalSystem::GetSequentialPath()
+
+    const CompiledSequentialPath& path = seq_path.Compiled();
+    const int path_size = path.Size();
+
+    if(ray->NumberOfSegments() != path_size){
+        ray->Allocate(path_size);
+    }
+
+    RayOutput output(ray.get());
+
+    return trace_path(path.Data(), path_size, pt0, dir0, output, iterations);
+}
+
+TraceError SequentialTrace::TraceRayDerivative(RayPtr ray, RayDerivative &deriv, const SequentialPath &seq_path, const Eigen::Vector3d &pt0, const Eigen::Vector3d &dir0,
+                                               const std::vector<TraceParameter> &params)
+{
+    assert(seq_path.Revision() >= opt_sys_->Revision()); // path built before the last edit, see OpticalSystem::GetSequentialPath()
+
+    const CompiledSequentialPath& path = seq_path.Compiled();
+    const int path_size  = path.Size();
+    const int num_params = params.size();
+
+    for(const auto& prm : params){
+        if( !prm.Check(path) ){
+            std::cerr << "Invalid trace parameter" << std::endl;
+            return TRACE_NOT_REACHED_ERROR;
+        }
+    }
 
     if(ray->NumberOfSegments() != path_size){
         ray->Allocate(path_size);
     }
+    deriv.Allocate(path_size, num_params);
+
+    TraceStatistics::StageTimer timer(stats_.get(), TraceStatistics::Tracing);
+
+    std::vector< BasicCompiledSurface<DualNumber> > dual_path(path_size);
+    TraceError result = TRACE_NOT_REACHED_ERROR;
+
+    // the derivatives are carried in chunks up to the capacity of DualNumber
+    int col = 0;
+    do{
+        const int num_cols = std::min(max_dual_parameters, num_params - col);
+
+        for(int i = 0; i < path_size; i++){
+            dual_path[i] = promote_surface(path.At(i), num_cols);
+        }
+        for(int k = 0; k < num_cols; k++){
+            seed_parameter(dual_path.data(), params[col + k], num_cols, k);
+        }
+
+        const Eigen::Matrix<DualNumber,3,1> dual_pt0  = promote_vector(pt0, num_cols);
+        const Eigen::Matrix<DualNumber,3,1> dual_dir0 = promote_vector(dir0, num_cols);
+
+        DualRayOutput output(ray.get(), &deriv, col, num_cols);
+        result = trace_path(dual_path.data(), path_size, dual_pt0, dual_dir0, output, nullptr);
+
+        col += num_cols;
+    }while(col < num_params);
+
+    if(stats_){
+        const int reached = ray->GetReachedSurfaceIndex();
+        stats_->RecordTrace(&result, &reached, 1, path_size, nullptr);
+    }
+
+    return result;
+}
 
-    Eigen::Vector3d before_pt  = pt0;
-    Eigen::Vector3d before_dir = dir0;
-    Eigen::Vector3d intersect_pt;
-    Eigen::Vector3d after_dir;
-    double distance_from_before = 0.0;
-    double n_out = seq_path.At(0).refractive_index;
+template<typename T, class Output>
+TraceError SequentialTrace::trace_path(const BasicCompiledSurface<T>* path, int path_size, const Eigen::Matrix<T,3,1>& pt0, const Eigen::Matrix<T,3,1>& dir0,
+                                       Output& output, long long* iterations)
+{
+    using Vector3 = Eigen::Matrix<T,3,1>;
+
+    Vector3 before_pt  = pt0;
+    Vector3 before_dir = dir0;
+    Vector3 intersect_pt;
+    Vector3 after_dir;
+    T distance_from_before = T(0.0);
+    double n_out = path[0].refractive_index;
     double n_in  = n_out;
-    Transformation transformation_from_before = seq_path.At(0).surface->LocalTransform();
     //double op_delta = 0.0;
-    double opl = 0.0;
+    T opl = T(0.0);
 
     //constexpr double z_dir = 1.0; // used for reflection, not yet implemented
 
 
     // first surface
-    Eigen::Vector3d srf_normal_1st = seq_path.At(0).surface->Normal(pt0);
-    ray->GetSegmentAt(0)->SetData(pt0, srf_normal_1st, dir0, 0.0, 0.0);
+    Vector3 srf_normal_1st = path[0].Normal(pt0);
+    output.SetData(0, pt0, srf_normal_1st, dir0, T(0.0), T(0.0));
 
 
     // trace ray throughout the path till the image
-    Eigen::Matrix3d rt;
-    Eigen::Vector3d t, rel_before_pt, rel_before_dir, foot_of_perpendicular_pt, srf_normal;
+    Vector3 rel_before_pt, rel_before_dir, foot_of_perpendicular_pt, srf_normal;
     int cur_srf_idx = 1;
 
     for(cur_srf_idx = 1; cur_srf_idx < path_size; cur_srf_idx++) {
 
-        rt = transformation_from_before.rotation;
-        t  = transformation_from_before.transfer;
+        const BasicCompiledSurface<T>& before_srf = path[cur_srf_idx - 1];
+        Eigen::Map<const Eigen::Matrix<double, 3, 3, Eigen::RowMajor>> rt(before_srf.rotation);
+        Eigen::Map<const Vector3> t(before_srf.transfer);
 
-        rel_before_pt = rt*(before_pt - t); // relative source point looked from current surface
-        rel_before_dir = rt*before_dir;     // relative ray direction looked from current surface
+        rel_before_pt = rt.template cast<T>()*(before_pt - t); // relative source point looked from current surface
+        rel_before_dir = rt.template cast<T>()*before_dir;     // relative ray direction looked from current surface
 
-        double dist_from_before_to_perpendicular = -rel_before_pt.dot(rel_before_dir); // distance from previous point to foot of perpendicular
+        T dist_from_before_to_perpendicular = -rel_before_pt.dot(rel_before_dir); // distance from previous point to foot of perpendicular
         foot_of_perpendicular_pt = rel_before_pt + dist_from_before_to_perpendicular*rel_before_dir; // foot of perpendicular from the current surface apex to the incident ray line
 
-        Surface* cur_srf = seq_path.At(cur_srf_idx).surface;
-        double dist_from_perpendicular_to_intersect_pt; // distance from the foot of perpendicular to the intersect point
+        const BasicCompiledSurface<T>& cur_srf = path[cur_srf_idx];
+        T dist_from_perpendicular_to_intersect_pt; // distance from the foot of perpendicular to the intersect point
 
-        if( ! cur_srf->Intersect(intersect_pt, dist_from_perpendicular_to_intersect_pt, foot_of_perpendicular_pt, rel_before_dir) ){
-            ray->SetStatus(TRACE_MISSEDSURFACE_ERROR);
-            ray->SetReachedSurfaceIndex(cur_srf_idx - 1);
-            ray->GetSegmentAt(cur_srf_idx)->SetStatus(TRACE_MISSEDSURFACE_ERROR);
+        int num_iter = 0;
+        const bool intersected = cur_srf.Intersect(intersect_pt, dist_from_perpendicular_to_intersect_pt, foot_of_perpendicular_pt, rel_before_dir, iterations ? &num_iter : nullptr);
+        if(iterations){
+            iterations[cur_srf_idx] += num_iter;
+        }
+
+        if( ! intersected ){
+            output.SetStatus(TRACE_MISSEDSURFACE_ERROR, cur_srf_idx - 1);
+            output.SetSegmentStatus(cur_srf_idx, TRACE_MISSEDSURFACE_ERROR);
             return TRACE_MISSEDSURFACE_ERROR;
         }
 
         distance_from_before = dist_from_before_to_perpendicular + dist_from_perpendicular_to_intersect_pt; // distance between before and current intersect point
 
-        n_out = seq_path.At(cur_srf_idx).refractive_index;
-        srf_normal = cur_srf->Normal(intersect_pt); // surface normal at the intersect point
+        n_out = cur_srf.refractive_index;
+        srf_normal = cur_srf.Normal(intersect_pt); // surface normal at the intersect point
         if( ! Bend(after_dir ,before_dir, srf_normal, n_in, n_out) ){
-            ray->SetStatus(TRACE_TIR_ERROR);
-            ray->SetReachedSurfaceIndex(cur_srf_idx);
-            ray->GetSegmentAt(cur_srf_idx)->SetData(intersect_pt, srf_normal, after_dir.normalized(),distance_from_before, opl);
-            ray->GetSegmentAt(cur_srf_idx)->SetStatus(TRACE_TIR_ERROR);
+            output.SetStatus(TRACE_TIR_ERROR, cur_srf_idx);
+            output.SetData(cur_srf_idx, intersect_pt, srf_normal, normalized(after_dir), distance_from_before, opl);
+            output.SetSegmentStatus(cur_srf_idx, TRACE_TIR_ERROR);
             return TRACE_TIR_ERROR;
         }
 
         opl = n_in * distance_from_before;
 
-        ray->GetSegmentAt(cur_srf_idx)->SetData(intersect_pt, srf_normal, after_dir.normalized(),distance_from_before, opl);
-        ray->GetSegmentAt(cur_srf_idx)->SetStatus(TRACE_SUCCESS);
+        output.SetData(cur_srf_idx, intersect_pt, srf_normal, normalized(after_dir), distance_from_before, opl);
+        output.SetSegmentStatus(cur_srf_idx, TRACE_SUCCESS);
 
         if(do_aperture_check_) {
-            if( !cur_srf->PointInside(intersect_pt(0),intersect_pt(1)) ){
-                ray->SetStatus(TRACE_BLOCKED_ERROR);
-                ray->SetReachedSurfaceIndex(cur_srf_idx);
-                ray->GetSegmentAt(cur_srf_idx)->SetStatus(TRACE_BLOCKED_ERROR);
+            if( !cur_srf.PointInside(ScalarValue(intersect_pt(0)), ScalarValue(intersect_pt(1))) ){
+                output.SetStatus(TRACE_BLOCKED_ERROR, cur_srf_idx);
+                output.SetSegmentStatus(cur_srf_idx, TRACE_BLOCKED_ERROR);
                 return TRACE_BLOCKED_ERROR;
             }
         }
@@ -205,20 +475,187 @@ TraceError SequentialTrace::TraceRayThroughoutPath(RayPtr ray, const SequentialP
         before_pt  = intersect_pt;
         before_dir = after_dir;
         n_in       = n_out;
-        transformation_from_before = cur_srf->LocalTransform();
     }
 
     //op_delta += opl;
 
-    ray->SetStatus(TRACE_SUCCESS);
-    ray->SetReachedSurfaceIndex(path_size-1);
-    ray->GetSegmentAt(path_size-1)->SetStatus(TRACE_SUCCESS);
+    output.SetStatus(TRACE_SUCCESS, path_size-1);
+    output.SetSegmentStatus(path_size-1, TRACE_SUCCESS);
 
     return TRACE_SUCCESS;
 }
 
 
 
+int SequentialTrace::TracePupilBundle(RayBundle &bundle, const SequentialPath &seq_path, const std::vector<Eigen::Vector2d> &pupils, const Field *fld, double wvl)
+{
+    const int num_rays = pupils.size();
+
+    if(bundle.NumberOfRays() != num_rays || bundle.NumberOfSurfaces() != seq_path.Size()){
+        bundle.Allocate(num_rays, seq_path.Size(), bundle.IsImageOnly());
+    }
+    bundle.SetWavelength(wvl);
+
+    Eigen::Vector3d pt0;
+    Eigen::Vector3d dir0;
+
+    for(int ri = 0; ri < num_rays; ri++){
+        ConvertCoordinatePupilToObj(pt0, dir0, pupils[ri], fld);
+        bundle.SetPupilCoordinate(ri, pupils[ri]);
+        bundle.SetInitialRay(ri, pt0, dir0);
+    }
+
+    return TraceBundle(bundle, seq_path);
+}
+
+
+int SequentialTrace::TraceBundle(RayBundle &bundle, const SequentialPath &seq_path)
+{
+    assert(seq_path.Revision() >= opt_sys_->Revision()); // path built before the last edit, see OpticalSystem::GetSequentialPath()
+
+    const CompiledSequentialPath& path = seq_path.Compiled();
+    const int path_size = path.Size();
+    const int num_rays  = bundle.NumberOfRays();
+
+    if(bundle.NumberOfSurfaces() != path_size){
+        std::cerr << "Ray bundle does not match the sequential path" << std::endl;
+        return 0;
+    }
+
+    TraceStatistics::StageTimer timer(stats_.get(), TraceStatistics::Tracing);
+
+    std::vector<long long> iterations;
+    if(stats_){
+        iterations.assign(path_size, 0);
+    }
+
+    // rays still alive are marked as TRACE_SUCCESS while tracing
+    TraceError* status = bundle.StatusData();
+    int* reached = bundle.ReachedSurfaceIndexData();
+    for(int ri = 0; ri < num_rays; ri++){
+        status[ri]  = TRACE_SUCCESS;
+        reached[ri] = 0;
+    }
+
+    std::vector<TraceError> kernel_result(num_rays);
+
+    Eigen::Vector3d before_pt, before_dir, rel_before_pt, rel_before_dir, foot_of_perpendicular_pt;
+    Eigen::Vector3d intersect_pt, srf_normal, after_dir;
+
+    for(int cur_srf_idx = 1; cur_srf_idx < path_size; cur_srf_idx++)
+    {
+        const CompiledSurface& before_srf = path.At(cur_srf_idx - 1);
+        const CompiledSurface& cur_srf    = path.At(cur_srf_idx);
+        Eigen::Map<const Eigen::Matrix<double, 3, 3, Eigen::RowMajor>> rt(before_srf.rotation);
+        Eigen::Map<const Eigen::Vector3d> t(before_srf.transfer);
+
+        const double n_in  = before_srf.refractive_index;
+        const double n_out = cur_srf.refractive_index;
+
+        if(cur_srf.IsConic()){
+            ConicKernel::Parameters prm = ConicKernel::CreateParameters(before_srf, cur_srf);
+            ConicKernel::IntersectAndRefract(bundle, cur_srf_idx, prm, kernel_result.data());
+
+            for(int ri = 0; ri < num_rays; ri++)
+            {
+                if(status[ri] != TRACE_SUCCESS){
+                    continue;
+                }
+
+                if(kernel_result[ri] == TRACE_MISSEDSURFACE_ERROR){
+                    status[ri]  = TRACE_MISSEDSURFACE_ERROR;
+                    reached[ri] = cur_srf_idx - 1;
+                    continue;
+                }
+
+                reached[ri] = cur_srf_idx;
+
+                if(kernel_result[ri] == TRACE_TIR_ERROR){
+                    status[ri] = TRACE_TIR_ERROR;
+                }else if(do_aperture_check_){
+                    if( !cur_srf.PointInside(bundle.X(ri, cur_srf_idx), bundle.Y(ri, cur_srf_idx)) ){
+                        status[ri] = TRACE_BLOCKED_ERROR;
+                    }
+                }
+            }
+        }
+        else
+        {
+            for(int ri = 0; ri < num_rays; ri++)
+            {
+                if(status[ri] != TRACE_SUCCESS){
+                    continue;
+                }
+
+                before_pt  = bundle.IntersectPt(ri, cur_srf_idx - 1);
+                before_dir = bundle.Direction(ri, cur_srf_idx - 1);
+
+                rel_before_pt  = rt*(before_pt - t);
+                rel_before_dir = rt*before_dir;
+
+                double dist_from_before_to_perpendicular = -rel_before_pt.dot(rel_before_dir);
+                foot_of_perpendicular_pt = rel_before_pt + dist_from_before_to_perpendicular*rel_before_dir;
+
+                double dist_from_perpendicular_to_intersect_pt;
+                int num_iter = 0;
+                const bool intersected = cur_srf.Intersect(intersect_pt, dist_from_perpendicular_to_intersect_pt, foot_of_perpendicular_pt, rel_before_dir, stats_ ? &num_iter : nullptr);
+                if(stats_){
+                    iterations[cur_srf_idx] += num_iter;
+                }
+
+                if( ! intersected ){
+                    status[ri]  = TRACE_MISSEDSURFACE_ERROR;
+                    reached[ri] = cur_srf_idx - 1;
+                    continue;
+                }
+
+                double distance_from_before = dist_from_before_to_perpendicular + dist_from_perpendicular_to_intersect_pt;
+
+                srf_normal = cur_srf.Normal(intersect_pt);
+                if( ! Bend(after_dir, before_dir, srf_normal, n_in, n_out) ){
+                    // same as the single ray trace, which keeps the direction and the optical path length of the previous segment
+                    bundle.SetData(ri, cur_srf_idx, intersect_pt, before_dir.normalized(), distance_from_before, bundle.SegmentOpticalPathLength(ri, cur_srf_idx - 1));
+                    status[ri]  = TRACE_TIR_ERROR;
+                    reached[ri] = cur_srf_idx;
+                    continue;
+                }
+
+                bundle.SetData(ri, cur_srf_idx, intersect_pt, after_dir.normalized(), distance_from_before, n_in*distance_from_before);
+                reached[ri] = cur_srf_idx;
+
+                if(do_aperture_check_) {
+                    if( !cur_srf.PointInside(intersect_pt(0), intersect_pt(1)) ){
+                        status[ri] = TRACE_BLOCKED_ERROR;
+                    }
+                }
+            }
+        }
+
+        // intermediate rows are overwritten in image-only mode. Rays terminated at this surface have their row written as well.
+        if(bundle.IsImageOnly() && cur_srf_idx >= 2 && cur_srf_idx < path_size - 1){
+            for(int ri = 0; ri < num_rays; ri++){
+                if(reached[ri] == cur_srf_idx){
+                    bundle.AccumulateOpticalPathLength(ri, cur_srf_idx);
+                }
+            }
+        }
+    }
+
+    int num_success = 0;
+    for(int ri = 0; ri < num_rays; ri++){
+        if(status[ri] == TRACE_SUCCESS){
+            num_success++;
+        }
+    }
+
+    if(stats_){
+        stats_->RecordTrace(status, reached, num_rays, path_size, iterations.data());
+    }
+
+    return num_success;
+}
+
+
 bool SequentialTrace::TraceCoddington(Eigen::Vector2d &s_t, const std::shared_ptr<Ray> ray, const SequentialPath& path)
 {
     /* R. Kingslake, "Lens Design Fundamentals", p292 */
@@ -335,8 +772,15 @@ SequentialPath SequentialTrace::CreateSequentialPath(double wvl)
     return CreateSequentialPath(0, img, wvl);
 }
 
+std::shared_ptr<const SequentialPath> SequentialTrace::GetSequentialPath(double wvl)
+{
+    return opt_sys_->GetSequentialPath(wvl);
+}
+
 SequentialPath SequentialTrace::CreateSequentialPath(int start, int end, double wvl)
 {
+    TraceStatistics::StageTimer timer(stats_.get(), TraceStatistics::PathCreation);
+
     const int img = opt_sys_->GetOpticalAssembly()->ImageIndex();
 
     assert(end <= img);
@@ -376,7 +820,9 @@ bool SequentialTrace::AimChiefRay(Eigen::Vector2d& aim_pt, Eigen::Vector3d& obj_
     int stop = opt_sys_->GetOpticalAssembly()->StopIndex();
     Eigen::Vector2d xy_target({0.0, 0.0});
 
-    SequentialPath seq_path = CreateSequentialPath(wvl);
+    auto seq_path_ptr = GetSequentialPath(wvl);
+
+    const SequentialPath& seq_path = *seq_path_ptr;
 
     auto ray = std::make_shared<Ray>(seq_path.Size());
     bool result = SearchRayAimingAtSurface(ray, aim_pt, fld, stop, xy_target);
@@ -395,13 +841,17 @@ bool SequentialTrace::AimChiefRay(Eigen::Vector2d& aim_pt, Eigen::Vector3d& obj_
 
 bool SequentialTrace::SearchRayAimingAtSurface(RayPtr ray, Eigen::Vector2d& aim_pt, const Field *fld, int target_srf_idx, const Eigen::Vector2d &xy_target)
 {
+    TraceStatistics::StageTimer timer(stats_.get(), TraceStatistics::Aiming);
+
     //const int fld_type = opt_sys_->optical_spec()->field_of_view()->field_type();
     double ref_wvl = opt_sys_->GetOpticalSpec()->GetWavelengthSpec()->ReferenceWavelength();
 
     double obj_dist = opt_sys_->GetOpticalAssembly()->GetGap(0)->Thickness();
     double enp_dist = opt_sys_->GetFirstOrderData()->entrance_pupil_distance;
 
-    SequentialPath seq_path = CreateSequentialPath(ref_wvl);
+    auto seq_path_ptr = GetSequentialPath(ref_wvl);
+
+    const SequentialPath& seq_path = *seq_path_ptr;
 
     Eigen::Vector3d pt0 = this->GetDefaultObjectPt(fld);
     Eigen::Vector3d pt1;
@@ -501,27 +951,6 @@ bool SequentialTrace::SearchRayAimingAtSurface(RayPtr ray, Eigen::Vector2d& aim_
 
 }
 
-bool SequentialTrace::Bend(Eigen::Vector3d& d_out, const Eigen::Vector3d& d_in, const Eigen::Vector3d& normal, double n_in, double n_out)
-{
-
-    double normal_len = normal.norm();
-    double cosI = d_in.dot(normal)/normal_len;
-    double sinI_sqr = 1.0 - cosI*cosI;
-
-    double inside_sqrt = n_out*n_out - n_in*n_in*sinI_sqr;
-    if(inside_sqrt < 0.0){
-        return false;
-    }
-
-    double cosI_sgn = (cosI > 0.0) - (cosI < 0.0);
-    //double n_cosIp = sqrt(n_out*n_out - n_in*n_in*sinI_sqr) * cosI_sgn;
-    double n_cosIp = sqrt( inside_sqrt ) * cosI_sgn;
-    double alpha = n_cosIp - n_in*cosI;
-    d_out = (n_in*d_in + alpha*normal)/n_out;
-
-    return true;
-}
-
 Eigen::Vector3d SequentialTrace::GetDefaultObjectPt(const Field* fld)
 {
     Eigen::Vector3d obj_pt;
@@ -622,7 +1051,8 @@ double SequentialTrace::ComputeVignettingFactorForPupil(const Eigen::Vector2d& f
     const double stop_radius = opt_sys_->GetOpticalAssembly()->GetSurface(stop_index)->MaxAperture();
 
     const double ref_wvl = opt_sys_->GetOpticalSpec()->GetWavelengthSpec()->ReferenceWavelength();
-    SequentialPath path = CreateSequentialPath(ref_wvl);
+    auto path_ptr = GetSequentialPath(ref_wvl);
+    const SequentialPath& path = *path_ptr;
 
     Eigen::Vector2d vig_pupil = full_pupil;
 
@@ -0,0 +1,392 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <cassert>
+
+#include "sequential/trace_statistics.h"
+#include "system/optical_system.h"
+
+using namespace geopter;
+
+namespace {
+
+std::atomic<uint64_t> next_statistics_id(0);
+
+void add_counters(TraceStatistics::SurfaceCounters& dst, const TraceStatistics::SurfaceCounters& src)
+{
+    dst.intersections += src.intersections;
+    dst.iterations    += src.iterations;
+    dst.tir           += src.tir;
+    dst.missed        += src.missed;
+    dst.blocked       += src.blocked;
+}
+
+}
+
+
+thread_local TraceStatistics::StageTimer* TraceStatistics::StageTimer::active_ = nullptr;
+
+TraceStatistics::StageTimer::StageTimer(TraceStatistics *stats, Stage stage) :
+    stats_(stats),
+    stage_(stage),
+    parent_(nullptr),
+    elapsed_(std::chrono::steady_clock::duration::zero())
+{
+    if(stats_){
+        start_ = std::chrono::steady_clock::now();
+
+        // pause the enclosing timer
+        parent_ = active_;
+        if(parent_){
+            parent_->elapsed_ += start_ - parent_->start_;
+        }
+        active_ = this;
+    }
+}
+
+TraceStatistics::StageTimer::~StageTimer()
+{
+    if(stats_){
+        const auto now = std::chrono::steady_clock::now();
+        elapsed_ += now - start_;
+        stats_->RecordTime(stage_, elapsed_);
+
+        // resume the enclosing timer
+        active_ = parent_;
+        if(parent_){
+            parent_->start_ = now;
+        }
+    }
+}
+
+
+void TraceStatistics::Counters::Add(const Counters &other)
+{
+    num_rays += other.num_rays;
+    if(srf_counters.size() < other.srf_counters.size()){
+        srf_counters.resize(other.srf_counters.size());
+    }
+    for(size_t si = 0; si < other.srf_counters.size(); si++){
+        add_counters(srf_counters[si], other.srf_counters[si]);
+    }
+    for(int i = 0; i < NumberOfStages; i++){
+        stage_ns[i]    += other.stage_ns[i];
+        stage_calls[i] += other.stage_calls[i];
+    }
+}
+
+
+TraceStatistics::TraceStatistics() :
+    id_(next_statistics_id++)
+{
+
+}
+
+TraceStatistics::TraceStatistics(const TraceStatistics &other) :
+    id_(next_statistics_id++)
+{
+    std::lock_guard<std::mutex> lk(other.mtx_);
+    merged_ = other.collect();
+}
+
+TraceStatistics& TraceStatistics::operator=(const TraceStatistics &other)
+{
+    if(this != &other){
+        Counters tmp;
+        {
+            std::lock_guard<std::mutex> lk(other.mtx_);
+            tmp = other.collect();
+        }
+        this->Clear();
+        std::lock_guard<std::mutex> lk(mtx_);
+        merged_ = std::move(tmp);
+    }
+    return *this;
+}
+
+TraceStatistics::~TraceStatistics()
+{
+
+}
+
+void TraceStatistics::Clear()
+{
+    // the thread slots are kept since their owners may hold them
+    std::lock_guard<std::mutex> lk(mtx_);
+    merged_ = Counters();
+    for(auto &t : threads_){
+        static_cast<Counters&>(*t.second) = Counters();
+    }
+}
+
+TraceStatistics::ThreadCounters* TraceStatistics::local_counters()
+{
+    // one entry cache, as a thread usually records into the same statistics in a row.
+    // Ids are never reused, so the entry of a destroyed instance never matches.
+    static thread_local uint64_t cached_id = std::numeric_limits<uint64_t>::max();
+    static thread_local ThreadCounters* cached = nullptr;
+
+    if(cached_id != id_){
+        std::lock_guard<std::mutex> lk(mtx_);
+        auto& slot = threads_[std::this_thread::get_id()];
+        if(!slot){
+            slot = std::make_unique<ThreadCounters>();
+        }
+        cached    = slot.get();
+        cached_id = id_;
+    }
+    return cached;
+}
+
+TraceStatistics::Counters TraceStatistics::collect() const
+{
+    Counters total = merged_;
+    for(auto &t : threads_){
+        total.Add(*t.second);
+    }
+    return total;
+}
+
+void TraceStatistics::RecordTrace(const TraceError *status, const int *reached, int num_rays, int path_size, const long long *iterations)
+{
+    if(num_rays <= 0 || path_size <= 0){
+        return;
+    }
+
+    ThreadCounters* local = local_counters();
+    if((int)local->srf_counters.size() < path_size){
+        local->srf_counters.resize(path_size);
+    }
+    std::vector<SurfaceCounters>& counters = local->srf_counters;
+
+    // rays intersecting surface si are those whose last attempted surface is si or later
+    std::vector<long long>& last_attempt = local->last_attempt;
+    last_attempt.assign(path_size, 0);
+
+    for(int ri = 0; ri < num_rays; ri++){
+        const int r = std::clamp(reached[ri], 0, path_size - 1);
+        int last = r;
+        switch(status[ri]){
+        case TRACE_MISSEDSURFACE_ERROR:
+            last = std::min(r + 1, path_size - 1);
+            counters[last].missed++;
+            break;
+        case TRACE_TIR_ERROR:
+            counters[r].tir++;
+            break;
+        case TRACE_BLOCKED_ERROR:
+            counters[r].blocked++;
+            break;
+        default:
+            break;
+        }
+        last_attempt[last]++;
+    }
+
+    long long num_attempts = 0;
+    for(int si = path_size - 1; si >= 1; si--){
+        num_attempts += last_attempt[si];
+        counters[si].intersections += num_attempts;
+    }
+
+    if(iterations){
+        for(int si = 0; si < path_size; si++){
+            counters[si].iterations += iterations[si];
+        }
+    }
+
+    local->num_rays += num_rays;
+}
+
+void TraceStatistics::RecordTime(Stage stage, std::chrono::steady_clock::duration elapsed)
+{
+    ThreadCounters* local = local_counters();
+    local->stage_ns[stage] += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    local->stage_calls[stage]++;
+}
+
+void TraceStatistics::Merge(const TraceStatistics &other)
+{
+    if(this == &other){
+        return;
+    }
+
+    Counters tmp;
+    {
+        std::lock_guard<std::mutex> lk(other.mtx_);
+        tmp = other.collect();
+    }
+
+    std::lock_guard<std::mutex> lk(mtx_);
+    merged_.Add(tmp);
+}
+
+long long TraceStatistics::NumberOfRays() const
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    return collect().num_rays;
+}
+
+int TraceStatistics::NumberOfSurfaces() const
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    return collect().srf_counters.size();
+}
+
+TraceStatistics::SurfaceCounters TraceStatistics::Surface(int srf_index) const
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    const Counters total = collect();
+    if(srf_index < 0 || srf_index >= (int)total.srf_counters.size()){
+        return SurfaceCounters();
+    }
+    return total.srf_counters[srf_index];
+}
+
+TraceStatistics::SurfaceCounters TraceStatistics::Total() const
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    SurfaceCounters total;
+    for(auto &c : collect().srf_counters){
+        add_counters(total, c);
+    }
+    return total;
+}
+
+double TraceStatistics::Time(Stage stage) const
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    return collect().stage_ns[stage]*1.0e-6;
+}
+
+long long TraceStatistics::Calls(Stage stage) const
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    return collect().stage_calls[stage];
+}
+
+std::string TraceStatistics::StageName(Stage stage)
+{
+    switch(stage){
+    case PathCreation:  return "PathCreation";
+    case Aiming:        return "Aiming";
+    case Tracing:       return "Tracing";
+    case Opd:           return "OPD";
+    case Fft:           return "FFT";
+    default:            return "";
+    }
+}
+
+void TraceStatistics::Print(std::ostringstream &oss) const
+{
+    Counters tmp;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        tmp = collect();
+    }
+
+    const int idx_w = 8;
+    const int val_w = 14;
+
+    oss << "Rays: " << tmp.num_rays << std::endl;
+
+    oss << std::setw(idx_w) << std::right << "Surface";
+    oss << std::setw(val_w) << std::right << "Intersect";
+    oss << std::setw(val_w) << std::right << "Iteration";
+    oss << std::setw(val_w) << std::right << "TIR";
+    oss << std::setw(val_w) << std::right << "Missed";
+    oss << std::setw(val_w) << std::right << "Blocked";
+    oss << std::endl;
+
+    for(size_t si = 0; si < tmp.srf_counters.size(); si++){
+        const SurfaceCounters& c = tmp.srf_counters[si];
+        oss << std::setw(idx_w) << std::right << si;
+        oss << std::setw(val_w) << std::right << c.intersections;
+        oss << std::setw(val_w) << std::right << c.iterations;
+        oss << std::setw(val_w) << std::right << c.tir;
+        oss << std::setw(val_w) << std::right << c.missed;
+        oss << std::setw(val_w) << std::right << c.blocked;
+        oss << std::endl;
+    }
+
+    oss << std::endl;
+    oss << std::setw(idx_w + 6) << std::left << "Stage";
+    oss << std::setw(val_w) << std::right << "Calls";
+    oss << std::setw(val_w) << std::right << "Time(ms)";
+    oss << std::endl;
+
+    for(int i = 0; i < NumberOfStages; i++){
+        oss << std::setw(idx_w + 6) << std::left << StageName(static_cast<Stage>(i));
+        oss << std::setw(val_w) << std::right << tmp.stage_calls[i];
+        oss << std::setw(val_w) << std::right << std::fixed << std::setprecision(3) << tmp.stage_ns[i]*1.0e-6;
+        oss << std::endl;
+    }
+}
+
+void TraceStatistics::Print() const
+{
+    std::ostringstream oss;
+    Print(oss);
+    std::cout << oss.str() << std::endl;
+}
+
+
+thread_local TraceStatisticsScope* TraceStatisticsScope::innermost_ = nullptr;
+
+TraceStatisticsScope::TraceStatisticsScope(OpticalSystem *opt_sys) :
+    opt_sys_(opt_sys),
+    outer_(innermost_)
+{
+    parent_ = Current(opt_sys_);
+    if(parent_){
+        stats_ = std::make_shared<TraceStatistics>();
+    }
+    innermost_ = this;
+}
+
+TraceStatisticsScope::~TraceStatisticsScope()
+{
+    assert(innermost_ == this); // scopes must close in the reverse order of opening
+    innermost_ = outer_;
+
+    if(parent_){
+        parent_->Merge(*stats_);
+    }
+}
+
+std::shared_ptr<TraceStatistics> TraceStatisticsScope::Current(const OpticalSystem *opt_sys)
+{
+    for(const TraceStatisticsScope* scope = innermost_; scope; scope = scope->outer_){
+        if(scope->opt_sys_ == opt_sys){
+            return scope->stats_;
+        }
+    }
+    return opt_sys->GetTraceStatistics();
+}
@@ -0,0 +1,280 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+#include "solve/best_focus_solve.h"
+#include "system/optical_system.h"
+#include "sequential/sequential_trace.h"
+#include "analysis/wave_aberration.h"
+#include "common/thread_pool.h"
+
+using namespace geopter;
+
+namespace {
+
+/** Weighted sums over the final ray segments, from which the best defocus is solved */
+struct FocusMoments
+{
+    double numer = 0.0;
+    double denom = 0.0;
+};
+
+/** Traced rays of one wavelength and their weight in the RMS wavefront */
+struct WavefrontSamples
+{
+    WavefrontContext ctx;
+    std::vector<std::shared_ptr<Ray>> rays;
+    double ray_wt = 0.0;
+};
+
+/**
+ * Defocus minimizing the weighted RMS wavefront about the mean of each wavelength, by Gauss-Newton iterations
+ * on the wavefront error evaluated at the defocus. The rate of change is taken by central differences.
+ * @return NaN if the wavefront does not change with the defocus
+ */
+double SolveWavefrontDefocus(const WaveAberration& wave_abr, const std::vector<WavefrontSamples>& wavefronts)
+{
+    constexpr int max_iterations = 20;
+    constexpr double step = 1.0e-4;
+    constexpr double tolerance = 1.0e-10;
+
+    double defocus = 0.0;
+
+    for(int iter = 0; iter < max_iterations; iter++){
+        FocusMoments moments;
+
+        for(const auto& samples : wavefronts){
+            const int num_valid = samples.rays.size();
+            std::vector<double> opds(num_valid), rates(num_valid);
+            double mean_opd = 0.0, mean_rate = 0.0;
+
+            for(int k = 0; k < num_valid; k++){
+                const auto& ray = samples.rays[k];
+                opds[k]  = wave_abr.Opd(samples.ctx, ray, defocus);
+                rates[k] = (wave_abr.Opd(samples.ctx, ray, defocus + step) - wave_abr.Opd(samples.ctx, ray, defocus - step))/(2.0*step);
+                mean_opd  += opds[k];
+                mean_rate += rates[k];
+            }
+            mean_opd  /= static_cast<double>(num_valid);
+            mean_rate /= static_cast<double>(num_valid);
+
+            // minimize sum ((w - w_mean) + (g - g_mean)*dz)^2
+            for(int k = 0; k < num_valid; k++){
+                const double dw = opds[k] - mean_opd;
+                const double dg = rates[k] - mean_rate;
+                moments.numer += samples.ray_wt*dw*dg;
+                moments.denom += samples.ray_wt*dg*dg;
+            }
+        }
+
+        if(moments.denom <= 0.0){
+            return NAN;
+        }
+
+        const double delta = -moments.numer/moments.denom;
+        defocus += delta;
+        if(fabs(delta) <= tolerance*std::max(1.0, fabs(defocus))){
+            break;
+        }
+    }
+
+    return defocus;
+}
+
+}
+
+BestFocusSolve::BestFocusSolve()
+{
+    solve_type_ = SolveType::BestFocus;
+    gap_index_ = 0;
+    criterion_ = Criterion::RmsSpot;
+    field_index_ = 0;
+    nrd_ = 21;
+    last_defocus_ = 0.0;
+}
+
+BestFocusSolve::BestFocusSolve(int gi, int criterion, int field_index, int nrd)
+{
+    solve_type_ = SolveType::BestFocus;
+    gap_index_ = gi;
+    criterion_ = criterion;
+    field_index_ = field_index;
+    nrd_ = nrd;
+    last_defocus_ = 0.0;
+}
+
+bool BestFocusSolve::Check(const OpticalSystem *opt_sys)
+{
+    if(gap_index_ != opt_sys->GetOpticalAssembly()->NumberOfSurfaces() - 2) return false;
+    if(field_index_ < 0 || field_index_ >= opt_sys->GetOpticalSpec()->GetFieldSpec()->NumberOfFields()) return false;
+    if(nrd_ < 2) return false;
+
+    return true;
+}
+
+void BestFocusSolve::Apply(OpticalSystem *opt_sys)
+{
+    last_defocus_ = 0.0;
+
+    if( !Check(opt_sys) ){
+        std::cerr << "Invalid best focus solve" << std::endl;
+        return;
+    }
+
+    WavelengthSpec* wvl_spec = opt_sys->GetOpticalSpec()->GetWavelengthSpec();
+    const int num_wvls = wvl_spec->NumberOfWavelengths();
+    Field* fld = opt_sys->GetOpticalSpec()->GetFieldSpec()->GetField(field_index_);
+
+    const std::vector<Eigen::Vector2d> pupils = SequentialTrace::GridPupils(nrd_);
+    const int num_rays = pupils.size();
+
+    SequentialTrace tracer(opt_sys);
+    tracer.SetApertureCheck(true);
+    tracer.SetApplyVig(false);
+
+    // spot positions and slopes of all wavelengths, taken about the polychromatic centroid
+    std::vector<Eigen::Vector2d> spot_positions, spot_slopes;
+    std::vector<double> spot_wts;
+
+    // traced rays of each wavelength, whose wavefront error is evaluated at any defocus without re-tracing
+    WaveAberration wave_abr(opt_sys);
+    std::vector<WavefrontSamples> wavefronts;
+
+    for(int wi = 0; wi < num_wvls; wi++){
+        const double wvl = wvl_spec->GetWavelength(wi)->Value();
+        const double wt  = wvl_spec->GetWavelength(wi)->Weight();
+        auto seq_path_ptr = tracer.GetSequentialPath(wvl);
+        const SequentialPath& seq_path = *seq_path_ptr;
+
+        auto chief_ray = std::make_shared<Ray>(seq_path.Size());
+        if(TRACE_SUCCESS != tracer.TracePupilRay(chief_ray, seq_path, Eigen::Vector2d({0.0, 0.0}), fld, wvl)){
+            continue;
+        }
+
+        // position on the plane z=0 and slope for the spot, the traced ray for the wavefront
+        std::vector<Eigen::Vector2d> positions(num_rays), slopes(num_rays);
+        std::vector<std::shared_ptr<Ray>> rays(num_rays);
+
+        ThreadPool::Global()->ParallelFor(num_rays, [&](int k){
+            auto ray = std::make_shared<Ray>(seq_path.Size());
+            if(TRACE_SUCCESS != tracer.TracePupilRay(ray, seq_path, pupils[k], fld, wvl)){
+                return;
+            }
+
+            const RaySegment* seg = ray->GetBack();
+            if(seg->N() == 0.0){
+                return;
+            }
+
+            if(Criterion::RmsSpot == criterion_){
+                slopes[k] = Eigen::Vector2d(seg->L()/seg->N(), seg->M()/seg->N());
+                positions[k] = Eigen::Vector2d(seg->X(), seg->Y()) - slopes[k]*seg->Z();
+            }
+            rays[k] = ray;
+        });
+
+        if(Criterion::RmsSpot == criterion_){
+            for(int k = 0; k < num_rays; k++){
+                if(rays[k]){
+                    spot_positions.push_back(positions[k]);
+                    spot_slopes.push_back(slopes[k]);
+                    spot_wts.push_back(wt);
+                }
+            }
+            continue;
+        }
+
+        WavefrontSamples samples;
+        samples.ctx = wave_abr.CreateWavefrontContext(chief_ray, wvl);
+        for(auto& ray : rays){
+            if(ray) samples.rays.push_back(ray);
+        }
+        if(samples.rays.empty()){
+            continue;
+        }
+        // in waves, as MeritOperand::RmsOpd
+        const double to_waves = 1.0/(1.0e-6*wvl);
+        samples.ray_wt = wt*to_waves*to_waves/static_cast<double>(samples.rays.size());
+        wavefronts.push_back(std::move(samples));
+    }
+
+    double defocus = NAN;
+
+    if(Criterion::RmsSpot == criterion_){
+        // weighted polychromatic centroid, as MeritOperand::RmsSpot, which moves with the defocus as well
+        double sum_wt = 0.0;
+        Eigen::Vector2d mean_pos = Eigen::Vector2d::Zero(), mean_slope = Eigen::Vector2d::Zero();
+        for(size_t k = 0; k < spot_wts.size(); k++){
+            mean_pos   += spot_wts[k]*spot_positions[k];
+            mean_slope += spot_wts[k]*spot_slopes[k];
+            sum_wt     += spot_wts[k];
+        }
+        if(sum_wt > 0.0){
+            mean_pos   /= sum_wt;
+            mean_slope /= sum_wt;
+
+            // minimize sum w*|(p - p_mean) + (t - t_mean)*dz|^2
+            FocusMoments moments;
+            for(size_t k = 0; k < spot_wts.size(); k++){
+                const Eigen::Vector2d dp = spot_positions[k] - mean_pos;
+                const Eigen::Vector2d dt = spot_slopes[k] - mean_slope;
+                moments.numer += spot_wts[k]*dp.dot(dt);
+                moments.denom += spot_wts[k]*dt.dot(dt);
+            }
+            if(moments.denom > 0.0){
+                defocus = -moments.numer/moments.denom;
+            }
+        }
+    }else{
+        defocus = SolveWavefrontDefocus(wave_abr, wavefronts);
+    }
+
+    if(std::isnan(defocus)){
+        std::cerr << "Best focus could not be solved" << std::endl;
+        return;
+    }
+
+    last_defocus_ = defocus;
+
+    Gap* gap = opt_sys->GetOpticalAssembly()->GetGap(gap_index_);
+    gap->SetThickness(gap->Thickness() + last_defocus_);
+}
+
+void BestFocusSolve::SetParameters(double param1, double param2, double param3, double /*param4*/)
+{
+    criterion_   = static_cast<int>(param1);
+    field_index_ = static_cast<int>(param2);
+    nrd_         = static_cast<int>(param3);
+}
+
+void BestFocusSolve::GetParameters(double *param1, double *param2, double *param3, double */*param4*/)
+{
+    if(param1) *param1 = static_cast<double>(criterion_);
+    if(param2) *param2 = static_cast<double>(field_index_);
+    if(param3) *param3 = static_cast<double>(nrd_);
+}
@@ -68,7 +68,8 @@ void MarginalHeightSolve::Apply(OpticalSystem* opt_sys)
 
     }else{
         SequentialTrace *tracer = new SequentialTrace(opt_sys);
-        SequentialPath seq_path = tracer->CreateSequentialPath(ref_wvl);
+        auto seq_path_ptr = tracer->GetSequentialPath(ref_wvl);
+        const SequentialPath& seq_path = *seq_path_ptr;
         Eigen::Vector2d pupil({0.0, pupil_zone_});
         Field* fld = opt_sys->GetOpticalSpec()->GetFieldSpec()->GetField(0);
         auto ray = std::make_shared<Ray>(seq_path.Size());
@@ -105,6 +105,18 @@ void FieldSpec::clear()
     max_field_ = 0.0;
 }
 
+void FieldSpec::CopyFrom(const FieldSpec &other)
+{
+    clear();
+
+    field_type_ = other.field_type_;
+    for(const auto &f : other.fields_){
+        fields_.push_back(std::make_unique<Field>(*f));
+    }
+    num_fields_ = other.num_fields_;
+    max_field_  = other.max_field_;
+}
+
 
 void FieldSpec::print()
 {
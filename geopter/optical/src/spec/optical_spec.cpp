@@ -64,6 +64,13 @@ void OpticalSpec::Clear()
     field_spec_->clear();
 }
 
+void OpticalSpec::CopyFrom(const OpticalSpec &other)
+{
+    *pupil_ = *other.pupil_;
+    field_spec_->CopyFrom(*other.field_spec_);
+    wavelength_spec_->CopyFrom(*other.wavelength_spec_);
+}
+
 void OpticalSpec::update()
 {
     // update object coords
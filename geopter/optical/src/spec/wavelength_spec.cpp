@@ -115,6 +115,20 @@ void WavelengthSpec::clear()
     max_weight_ = 1.0;
 }
 
+void WavelengthSpec::CopyFrom(const WavelengthSpec &other)
+{
+    clear();
+
+    for(const auto &w : other.wvls_){
+        wvls_.push_back(std::make_unique<Wavelength>(*w));
+    }
+    num_wvls_        = other.num_wvls_;
+    reference_index_ = other.reference_index_;
+    higher_          = other.higher_;
+    lower_           = other.lower_;
+    max_weight_      = other.max_weight_;
+}
+
 void WavelengthSpec::update()
 {
     assert( !wvls_.empty());
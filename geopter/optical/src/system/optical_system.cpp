@@ -39,6 +39,8 @@
 #include "paraxial/paraxial_trace.h"
 #include "sequential/sequential_trace.h"
 #include "sequential/trace_error.h"
+#include "environment/environment.h"
+#include "common/revision_counter.h"
 
 
 using namespace geopter;
@@ -68,6 +70,24 @@ void OpticalSystem::Clear()
     note_ = "";
     opt_assembly_->Clear();
     opt_spec_->Clear();
+
+    std::lock_guard<std::mutex> lk(path_cache_mtx_);
+    path_cache_.clear();
+}
+
+
+std::unique_ptr<OpticalSystem> OpticalSystem::Clone() const
+{
+    auto sys = std::make_unique<OpticalSystem>();
+
+    sys->title_ = title_;
+    sys->note_  = note_;
+    sys->opt_spec_->CopyFrom(*opt_spec_);
+    sys->opt_assembly_->CopyFrom(*opt_assembly_);
+    sys->fod_->CopyFrom(*fod_);
+    sys->trace_stats_ = trace_stats_;
+
+    return sys;
 }
 
 
@@ -90,6 +110,36 @@ void OpticalSystem::UpdateModel()
     opt_assembly_->UpdateSemiDiameters();
 }
 
+uint64_t OpticalSystem::Revision() const
+{
+    return std::max(opt_assembly_->Revision(), Environment::Revision());
+}
+
+std::shared_ptr<const SequentialPath> OpticalSystem::GetSequentialPath(double wvl)
+{
+    constexpr size_t max_cached_paths = 32;
+
+    std::lock_guard<std::mutex> lk(path_cache_mtx_);
+
+    const uint64_t model_rev = Revision();
+
+    auto itr = path_cache_.find(wvl);
+    if(itr != path_cache_.end() && model_rev <= itr->second.revision){
+        return itr->second.path;
+    }
+
+    if(path_cache_.size() >= max_cached_paths){
+        path_cache_.clear();
+    }
+
+    // stamp taken before building, so that edits made meanwhile invalidate the entry
+    const uint64_t build_rev = RevisionCounter::Current();
+    auto path = std::make_shared<const SequentialPath>(SequentialTrace(this).CreateSequentialPath(wvl));
+    path_cache_[wvl] = CachedPath{build_rev, path};
+
+    return path;
+}
+
 
 void OpticalSystem::SetVignettingFactors()
 {
@@ -115,6 +165,15 @@ void OpticalSystem::SetVignettingFactors()
 
 
 void OpticalSystem::SaveToFile(const std::string &filepath)
+{
+    nlohmann::json json_data = this->ToJson();
+
+    /* output to file */
+    std::ofstream fout(filepath, std::ios::out);
+    fout << json_data.dump(4) << std::endl;
+}
+
+nlohmann::json OpticalSystem::ToJson() const
 {
     nlohmann::json json_data;
 
@@ -234,9 +293,7 @@ void OpticalSystem::SaveToFile(const std::string &filepath)
 
     }
 
-    /* output to file */
-    std::ofstream fout(filepath, std::ios::out);
-    fout << json_data.dump(4) << std::endl;
+    return json_data;
 }
 
 void OpticalSystem::LoadFile(const std::string &filepath)
@@ -250,6 +307,11 @@ void OpticalSystem::LoadFile(const std::string &filepath)
     nlohmann::json json_data;
     ifs >> json_data;
 
+    this->FromJson(std::move(json_data));
+}
+
+void OpticalSystem::FromJson(nlohmann::json json_data)
+{
     this->Clear();
 
     // ---> title, note
@@ -322,7 +384,7 @@ void OpticalSystem::LoadFile(const std::string &filepath)
                                                             fld_wt[fi],
                                                             color,
                                                             fld_vuy[fi], fld_vly[fi],
-                                                            fld_vux[fi], fld_vux[fi]);
+                                                            fld_vux[fi], fld_vlx[fi]);
         }
     }
     catch(...)
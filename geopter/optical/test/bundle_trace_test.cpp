@@ -0,0 +1,265 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 16th, 2026
+********************************************************************************/
+
+/**
+ * bundle_trace_test
+ *
+ * Checks the bundle trace against the single ray trace over the example lenses, for every instruction set of the conic kernel
+ * supported by the machine. Both the full storage and the image-only bundles are compared, with and without aperture check.
+ * The pupil grid overfills the pupil so that blocked, missed and TIR rays are covered as well.
+ *
+ * Compared per ray:
+ *   status and reached surface index (exact),
+ *   intersection point, direction and total optical path length at the reached surface (tolerance below).
+ *
+ * Usage: bundle_trace_test EXAMPLE_DIR AGF_DIR
+ */
+
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+#include <cmath>
+
+#include "optical.h"
+
+using namespace geopter;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/** Absolute tolerance, relative to the magnitude for values larger than 1 */
+constexpr double tolerance = 1.0e-9;
+
+constexpr int nrd = 21;
+constexpr double pupil_extent = 1.5;
+
+struct TestCounter
+{
+    long long rays   = 0;
+    long long failed = 0; // rays not reaching the image
+    int errors = 0;
+};
+
+bool IsClose(double a, double b)
+{
+    if(std::isnan(a) || std::isnan(b)){
+        return std::isnan(a) && std::isnan(b);
+    }
+    return std::fabs(a - b) <= tolerance*std::max(1.0, std::max(std::fabs(a), std::fabs(b)));
+}
+
+bool IsClose(const Eigen::Vector3d& a, const Eigen::Vector3d& b)
+{
+    return IsClose(a(0), b(0)) && IsClose(a(1), b(1)) && IsClose(a(2), b(2));
+}
+
+std::vector<std::string> FindLenses(const fs::path& dir)
+{
+    std::vector<std::string> lenses;
+    std::error_code ec;
+    for(auto& e : fs::recursive_directory_iterator(dir, ec)){
+        if(e.is_regular_file() && e.path().extension() == ".json"){
+            lenses.push_back(e.path().u8string());
+        }
+    }
+    std::sort(lenses.begin(), lenses.end());
+    return lenses;
+}
+
+std::vector<std::string> FindAgfFiles(const fs::path& dir)
+{
+    std::vector<std::string> agfs;
+    std::error_code ec;
+    for(auto& e : fs::directory_iterator(dir, ec)){
+        std::string ext = e.path().extension().u8string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        if(e.is_regular_file() && ext == ".agf"){
+            agfs.push_back(e.path().u8string());
+        }
+    }
+    std::sort(agfs.begin(), agfs.end());
+    return agfs;
+}
+
+std::vector<Eigen::Vector2d> CreateGridPupils()
+{
+    std::vector<Eigen::Vector2d> pupils;
+    const double step = 2.0*pupil_extent/(double)(nrd - 1);
+    for(int i = 0; i < nrd; i++){
+        for(int j = 0; j < nrd; j++){
+            pupils.push_back(Eigen::Vector2d(-pupil_extent + step*j, -pupil_extent + step*i));
+        }
+    }
+    return pupils;
+}
+
+void ReportError(TestCounter& counter, const std::string& label, int ri, const std::string& what)
+{
+    if(counter.errors < 20){
+        std::cerr << label << ", ray " << ri << ": " << what << std::endl;
+    }
+    counter.errors++;
+}
+
+/** Compare the rows of the bundle at the reached surfaces to the reference */
+void CompareBundle(TestCounter& counter, const std::string& label, const RayBundle& bundle, const RayBundle& ref)
+{
+    for(int ri = 0; ri < ref.NumberOfRays(); ri++){
+        const int reached = ref.ReachedSurfaceIndex(ri);
+        if(bundle.Status(ri) != ref.Status(ri) || bundle.ReachedSurfaceIndex(ri) != reached){
+            ReportError(counter, label, ri, "status/reached mismatch");
+            continue;
+        }
+        if(!IsClose(bundle.IntersectPt(ri, reached), ref.IntersectPt(ri, reached))){
+            ReportError(counter, label, ri, "intersect point mismatch at surface " + std::to_string(reached));
+        }
+        if(!IsClose(bundle.Direction(ri, reached), ref.Direction(ri, reached))){
+            ReportError(counter, label, ri, "direction mismatch at surface " + std::to_string(reached));
+        }
+        if(!IsClose(bundle.OpticalPathLength(ri), ref.OpticalPathLength(ri))){
+            ReportError(counter, label, ri, "optical path length mismatch");
+        }
+    }
+}
+
+/** Compare the full storage bundle to the single ray trace */
+void CompareRays(TestCounter& counter, const std::string& label, const RayBundle& bundle, const std::vector<RayPtr>& rays, const std::vector<TraceError>& results)
+{
+    for(int ri = 0; ri < bundle.NumberOfRays(); ri++){
+        const RayPtr& ray = rays[ri];
+        const int reached = ray->GetReachedSurfaceIndex();
+
+        counter.rays++;
+        if(results[ri] != TRACE_SUCCESS){
+            counter.failed++;
+        }
+
+        if(bundle.Status(ri) != results[ri] || bundle.ReachedSurfaceIndex(ri) != reached){
+            ReportError(counter, label, ri, "status/reached mismatch with single ray trace");
+            continue;
+        }
+        if(!IsClose(bundle.IntersectPt(ri, reached), ray->GetSegmentAt(reached)->IntersectPt())){
+            ReportError(counter, label, ri, "intersect point mismatch with single ray trace");
+        }
+        if(!IsClose(bundle.Direction(ri, reached), ray->GetSegmentAt(reached)->Direction())){
+            ReportError(counter, label, ri, "direction mismatch with single ray trace");
+        }
+        if(!IsClose(bundle.OpticalPathLength(ri), ray->OpticalPathLength())){
+            ReportError(counter, label, ri, "optical path length mismatch with single ray trace");
+        }
+    }
+}
+
+void TestLens(TestCounter& counter, OpticalSystem& sys, const std::string& lens_path)
+{
+    sys.LoadFile(lens_path);
+
+    const std::string lens = fs::path(lens_path).stem().u8string();
+    const std::vector<Eigen::Vector2d> pupils = CreateGridPupils();
+    const int num_rays = pupils.size();
+
+    FieldSpec* fld_spec = sys.GetOpticalSpec()->GetFieldSpec();
+    WavelengthSpec* wvl_spec = sys.GetOpticalSpec()->GetWavelengthSpec();
+
+    SequentialTrace tracer(&sys);
+
+    for(int wi = 0; wi < wvl_spec->NumberOfWavelengths(); wi++){
+        const double wvl = wvl_spec->GetWavelength(wi)->Value();
+        auto p = tracer.GetSequentialPath(wvl);
+        const SequentialPath& seq_path = *p;
+
+        for(int fi = 0; fi < fld_spec->NumberOfFields(); fi++){
+            const Field* fld = fld_spec->GetField(fi);
+
+            for(bool aperture_check : {false, true}){
+                tracer.SetApertureCheck(aperture_check);
+
+                // reference, traced one by one
+                std::vector<RayPtr> rays(num_rays);
+                std::vector<TraceError> results(num_rays);
+                for(int ri = 0; ri < num_rays; ri++){
+                    rays[ri] = std::make_shared<Ray>(seq_path.Size());
+                    results[ri] = tracer.TracePupilRay(rays[ri], seq_path, pupils[ri], fld, wvl);
+                }
+
+                for(int isa = 0; isa <= static_cast<int>(ConicKernel::DetectInstructionSet()); isa++){
+                    ConicKernel::SetInstructionSet(static_cast<SimdInstructionSet>(isa));
+
+                    const std::string label = lens + " W" + std::to_string(wi) + " F" + std::to_string(fi)
+                            + (aperture_check ? " (aperture check) " : " ")
+                            + ConicKernel::InstructionSetName(static_cast<SimdInstructionSet>(isa));
+
+                    RayBundle full(num_rays, seq_path.Size(), false);
+                    tracer.TracePupilBundle(full, seq_path, pupils, fld, wvl);
+                    CompareRays(counter, label, full, rays, results);
+
+                    RayBundle image_only(num_rays, seq_path.Size(), true);
+                    tracer.TracePupilBundle(image_only, seq_path, pupils, fld, wvl);
+                    CompareBundle(counter, label + " image-only", image_only, full);
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+    if(argc < 3){
+        std::cerr << "Usage: bundle_trace_test EXAMPLE_DIR AGF_DIR" << std::endl;
+        return 1;
+    }
+
+    const std::vector<std::string> lenses = FindLenses(argv[1]);
+    const std::vector<std::string> agfs   = FindAgfFiles(argv[2]);
+    if(lenses.empty() || agfs.empty()){
+        std::cerr << "No lens or AGF file found" << std::endl;
+        return 1;
+    }
+
+    // leave the source tree untouched
+    GlassCatalog::SetCacheEnabled(false);
+
+    OpticalSystem sys;
+    sys.GetMaterialLib()->LoadAgfFiles(agfs);
+
+    const SimdInstructionSet detected = ConicKernel::DetectInstructionSet();
+    std::cout << "Instruction sets up to " << ConicKernel::InstructionSetName(detected) << ", tolerance " << tolerance << std::endl;
+
+    TestCounter counter;
+    for(auto& lens_path : lenses){
+        TestLens(counter, sys, lens_path);
+    }
+
+    ConicKernel::SetInstructionSet(detected);
+
+    std::cout << counter.rays << " rays compared, " << counter.failed << " of them not reaching the image, "
+              << counter.errors << " mismatches" << std::endl;
+
+    return (counter.errors == 0) ? 0 : 1;
+}
@@ -0,0 +1,244 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 17th, 2026
+********************************************************************************/
+
+/**
+ * clone_test
+ *
+ * Checks that OpticalSystem::Clone gives an independent system. The clone must trace like the original without
+ * UpdateModel. Edits of the prescription, the specifications and a solve of the clone must not reach the original,
+ * and edits of the original must not reach the clone. Compared are the prescription, the first order data and
+ * real rays traced through the path cache of each system.
+ *
+ * Usage: clone_test EXAMPLE_DIR AGF_DIR
+ */
+
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+#include <cmath>
+
+#include "optical.h"
+
+using namespace geopter;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr double tolerance = 1.0e-12;
+
+bool IsClose(double a, double b, double tol = tolerance)
+{
+    return std::fabs(a - b) <= tol*std::max(1.0, std::max(std::fabs(a), std::fabs(b)));
+}
+
+std::vector<std::string> FindAgfFiles(const fs::path& dir)
+{
+    std::vector<std::string> agfs;
+    std::error_code ec;
+    for(auto& e : fs::directory_iterator(dir, ec)){
+        std::string ext = e.path().extension().u8string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        if(e.is_regular_file() && ext == ".agf"){
+            agfs.push_back(e.path().u8string());
+        }
+    }
+    std::sort(agfs.begin(), agfs.end());
+    return agfs;
+}
+
+/** Prescription, specifications, first order data and ray intercepts on the image */
+std::vector<double> Snapshot(OpticalSystem& sys)
+{
+    std::vector<double> values;
+
+    OpticalAssembly* assembly = sys.GetOpticalAssembly();
+    for(int i = 0; i < assembly->NumberOfSurfaces(); i++){
+        values.push_back(assembly->GetSurface(i)->Curvature());
+        values.push_back(assembly->GetGap(i)->Thickness());
+    }
+
+    FieldSpec* fld_spec = sys.GetOpticalSpec()->GetFieldSpec();
+    WavelengthSpec* wvl_spec = sys.GetOpticalSpec()->GetWavelengthSpec();
+    for(int fi = 0; fi < fld_spec->NumberOfFields(); fi++){
+        values.push_back(fld_spec->GetField(fi)->Y());
+    }
+    for(int wi = 0; wi < wvl_spec->NumberOfWavelengths(); wi++){
+        values.push_back(wvl_spec->GetWavelength(wi)->Value());
+    }
+
+    values.push_back(sys.GetFirstOrderData()->effective_focal_length);
+    values.push_back(sys.GetFirstOrderData()->image_distance);
+
+    SequentialTrace tracer(&sys);
+    tracer.SetApertureCheck(true);
+
+    const std::vector<Eigen::Vector2d> pupils = {{0.0, 0.0}, {0.0, 1.0}, {0.0, -1.0}, {1.0, 0.0}, {0.5, 0.5}};
+    for(int wi = 0; wi < wvl_spec->NumberOfWavelengths(); wi++){
+        const double wvl = wvl_spec->GetWavelength(wi)->Value();
+        auto seq_path = tracer.GetSequentialPath(wvl);
+        auto ray = std::make_shared<Ray>(seq_path->Size());
+        for(int fi = 0; fi < fld_spec->NumberOfFields(); fi++){
+            for(auto& pupil : pupils){
+                if(TRACE_SUCCESS == tracer.TracePupilRay(ray, *seq_path, pupil, fld_spec->GetField(fi), wvl)){
+                    values.push_back(ray->GetBack()->X());
+                    values.push_back(ray->GetBack()->Y());
+                }else{
+                    values.push_back(NAN);
+                    values.push_back(NAN);
+                }
+            }
+        }
+    }
+
+    return values;
+}
+
+/** Number of differing values. NaN matches NaN. */
+int CountDifferences(const std::vector<double>& a, const std::vector<double>& b)
+{
+    if(a.size() != b.size()){
+        return std::max(a.size(), b.size());
+    }
+    int count = 0;
+    for(size_t i = 0; i < a.size(); i++){
+        if(std::isnan(a[i]) && std::isnan(b[i])){
+            continue;
+        }
+        if( !IsClose(a[i], b[i]) ){
+            count++;
+        }
+    }
+    return count;
+}
+
+int TestClone(OpticalSystem& sys, const std::string& lens)
+{
+    OpticalAssembly* assembly = sys.GetOpticalAssembly();
+    const int ns = assembly->NumberOfSurfaces();
+    const int gi = ns - 2;
+
+    // paraxial focus by a solve on the image distance, which must be applied to the system owning it
+    Solve* solve = assembly->GetGap(gi)->CreateSolve<MarginalHeightSolve>();
+    solve->SetGapIndex(gi);
+    solve->SetParameters(0.0, 1.0, 0.0, 0.0);
+    sys.UpdateModel();
+
+    const std::vector<double> original = Snapshot(sys);
+
+    auto clone = sys.Clone();
+
+    int errors = 0;
+
+    const int initial_diffs = CountDifferences(Snapshot(*clone), original);
+    if(initial_diffs > 0){
+        std::cerr << lens << ": clone differs from the original in " << initial_diffs << " values" << std::endl;
+        errors++;
+    }
+    if(clone->GetOpticalAssembly()->GetGap(gi)->GetSolve() == solve){
+        std::cerr << lens << ": solve is shared with the clone" << std::endl;
+        errors++;
+    }
+
+    // edit the clone
+    const double img_thi = assembly->GetGap(gi)->Thickness();
+    Surface* last_srf = clone->GetOpticalAssembly()->GetSurface(ns - 2);
+    last_srf->SetCurvature(1.1*last_srf->Curvature());
+    Field* last_fld = clone->GetOpticalSpec()->GetFieldSpec()->GetField(clone->GetOpticalSpec()->GetFieldSpec()->NumberOfFields() - 1);
+    last_fld->SetY(0.5*last_fld->Y());
+    Wavelength* first_wvl = clone->GetOpticalSpec()->GetWavelengthSpec()->GetWavelength(0);
+    first_wvl->SetValue(first_wvl->Value() + 10.0);
+    clone->UpdateModel();
+
+    const std::vector<double> edited_clone = Snapshot(*clone);
+
+    if(IsClose(clone->GetOpticalAssembly()->GetGap(gi)->Thickness(), img_thi)){
+        std::cerr << lens << ": solve of the clone did not follow the edit" << std::endl;
+        errors++;
+    }
+    if( !IsClose(assembly->GetGap(gi)->Thickness(), img_thi) ){
+        std::cerr << lens << ": solve of the clone moved the original image to " << assembly->GetGap(gi)->Thickness() << std::endl;
+        errors++;
+    }
+
+    const int original_diffs = CountDifferences(Snapshot(sys), original);
+    if(original_diffs > 0){
+        std::cerr << lens << ": edit of the clone changed " << original_diffs << " values of the original" << std::endl;
+        errors++;
+    }
+
+    // edit the original
+    Gap* gap = assembly->GetGap(ns - 3);
+    gap->SetThickness(gap->Thickness() + 0.5);
+    sys.UpdateModel();
+
+    const int clone_diffs = CountDifferences(Snapshot(*clone), edited_clone);
+    if(clone_diffs > 0){
+        std::cerr << lens << ": edit of the original changed " << clone_diffs << " values of the clone" << std::endl;
+        errors++;
+    }
+
+    return errors;
+}
+
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+    if(argc < 3){
+        std::cerr << "Usage: clone_test EXAMPLE_DIR AGF_DIR" << std::endl;
+        return 1;
+    }
+
+    const fs::path example_dir = argv[1];
+    const std::vector<std::string> lenses = { (example_dir / "dbgauss.json").u8string(), (example_dir / "book" / "kingslake_doublet.json").u8string() };
+    const std::vector<std::string> agfs = FindAgfFiles(argv[2]);
+    if(agfs.empty()){
+        std::cerr << "No AGF file found" << std::endl;
+        return 1;
+    }
+
+    // leave the source tree untouched
+    GlassCatalog::SetCacheEnabled(false);
+
+    OpticalSystem sys;
+    sys.GetMaterialLib()->LoadAgfFiles(agfs);
+
+    int errors = 0;
+    for(auto& lens_path : lenses){
+        if(!fs::exists(lens_path)){
+            std::cerr << "Missing " << lens_path << std::endl;
+            errors++;
+            continue;
+        }
+        sys.LoadFile(lens_path);
+        errors += TestClone(sys, fs::path(lens_path).stem().u8string());
+    }
+
+    std::cout << lenses.size() << " lenses compared, " << errors << " mismatches" << std::endl;
+
+    return (errors == 0) ? 0 : 1;
+}
@@ -0,0 +1,218 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 17th, 2026
+********************************************************************************/
+
+/**
+ * diffraction_mtf_test
+ *
+ * Checks the diffraction MTF computed from the matrix Fourier transform PSF and by AutocorrelationMTF, on every field of a doublet.
+ * The system is reduced to its reference wavelength, as DiffractiveMTF sums the amplitudes of the wavelengths.
+ *
+ * The MFT PSF is sampled on the same 0.1mm window and pixels as DiffractiveMTF and transformed in the same way,
+ * so the curves differ only by the pupil sampling.
+ * DiffractiveMTF pixels are coarser than the Nyquist pitch of the PSF, which aliases its MTF at high frequencies.
+ * AutocorrelationMTF is therefore compared to it at low frequencies only, and over the whole range to the MTF of an MFT PSF
+ * sampled finely enough.
+ *
+ * Usage: diffraction_mtf_test EXAMPLE_DIR AGF_DIR
+ */
+
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+#include <cmath>
+
+#include "optical.h"
+#include "common/fft_engine.h"
+
+using namespace geopter;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/** Absolute tolerance on the MTF */
+constexpr double tolerance = 0.02;
+
+/** DiffractiveMTF samples, of which the first M frequencies are compared */
+constexpr int M = 64;
+
+/** Pixels of the MFT PSF of the autocorrelation reference, finer than the Nyquist pitch of the doublet */
+constexpr int fine_pixels = 4*M;
+
+/** Highest frequency at which DiffractiveMTF is free enough from aliasing */
+constexpr double max_alias_free_freq = 100.0;
+
+/** Image window of DiffractiveMTF */
+constexpr double L = 0.1;
+
+constexpr int pupil_samples = 128;
+
+struct Mtf
+{
+    std::vector<double> sag;
+    std::vector<double> tan;
+};
+
+std::vector<std::string> FindAgfFiles(const fs::path& dir)
+{
+    std::vector<std::string> agfs;
+    std::error_code ec;
+    for(auto& e : fs::directory_iterator(dir, ec)){
+        std::string ext = e.path().extension().u8string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        if(e.is_regular_file() && ext == ".agf"){
+            agfs.push_back(e.path().u8string());
+        }
+    }
+    std::sort(agfs.begin(), agfs.end());
+    return agfs;
+}
+
+int Compare(const std::string& label, const std::vector<double>& freqs, const std::vector<double>& mtf, const std::vector<double>& ref, double max_freq)
+{
+    int errors = 0;
+    for(int i = 0; i < M && freqs[i] <= max_freq; i++){
+        if(!(std::fabs(mtf[i] - ref[i]) <= tolerance)){
+            if(errors < 5){
+                std::cerr << label << " at " << freqs[i] << ": " << mtf[i] << " vs " << ref[i] << std::endl;
+            }
+            errors++;
+        }
+    }
+    return errors;
+}
+
+/** MTF of the MFT PSF over the DiffractiveMTF window, zero padded and transformed like DiffractiveMTF */
+bool MftMtf(OpticalSystem& sys, const Field* fld, double wvl, int num_pixels, Mtf& mtf)
+{
+    DiffractivePSF psf(&sys);
+    auto psf_grid = psf.CreateByMft(fld, wvl, pupil_samples, num_pixels, L/num_pixels);
+    if(!psf_grid){
+        return false;
+    }
+
+    const int N = num_pixels;
+    Eigen::MatrixXd padded = Eigen::MatrixXd::Zero(2*N, 2*N);
+    padded.block(N/2, N/2, N, N) = psf_grid->ValueData();
+
+    Eigen::MatrixXcd spectrum;
+    FftEngine::ForwardReal(spectrum, padded);
+
+    const double mtf0 = std::abs(spectrum(0,0));
+    mtf.sag.resize(M);
+    mtf.tan.resize(M);
+    for(int i = 0; i < M; i++){
+        mtf.sag[i] = std::abs(spectrum(0,i))/mtf0;
+        mtf.tan[i] = std::abs(spectrum(i,0))/mtf0;
+    }
+    return true;
+}
+
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+    if(argc < 3){
+        std::cerr << "Usage: diffraction_mtf_test EXAMPLE_DIR AGF_DIR" << std::endl;
+        return 1;
+    }
+
+    const std::string lens_path = (fs::path(argv[1]) / "book" / "kingslake_doublet.json").u8string();
+    const std::vector<std::string> agfs = FindAgfFiles(argv[2]);
+    if(!fs::exists(lens_path) || agfs.empty()){
+        std::cerr << "No lens or AGF file found" << std::endl;
+        return 1;
+    }
+
+    // leave the source tree untouched
+    GlassCatalog::SetCacheEnabled(false);
+
+    OpticalSystem sys;
+    sys.GetMaterialLib()->LoadAgfFiles(agfs);
+    sys.LoadFile(lens_path);
+
+    WavelengthSpec* wvl_spec = sys.GetOpticalSpec()->GetWavelengthSpec();
+    const double wvl = wvl_spec->ReferenceWavelength();
+    wvl_spec->clear();
+    wvl_spec->AddWavelength(wvl, 1.0);
+    wvl_spec->SetReferenceIndex(0);
+    sys.UpdateModel();
+
+    FieldSpec* fld_spec = sys.GetOpticalSpec()->GetFieldSpec();
+    const int num_flds = fld_spec->NumberOfFields();
+
+    // reference, sagittal and tangential graphs for each field
+    DiffractiveMTF diff_mtf(&sys);
+    auto ref_plot = diff_mtf.plot(&sys, M);
+    if(ref_plot->NumberOfGraphs() != 2*num_flds){
+        std::cerr << "Unexpected number of DiffractiveMTF graphs" << std::endl;
+        return 1;
+    }
+    const std::vector<double> freqs(ref_plot->GetGraph(0)->XData().begin(), ref_plot->GetGraph(0)->XData().begin() + M);
+
+    int errors = 0;
+
+    for(int fi = 0; fi < num_flds; fi++){
+        const Field* fld = fld_spec->GetField(fi);
+        const std::vector<double>& ref_sag = ref_plot->GetGraph(2*fi)->YData();
+        const std::vector<double>& ref_tan = ref_plot->GetGraph(2*fi + 1)->YData();
+        const std::string label = "F" + std::to_string(fi);
+
+        Mtf mft, mft_fine;
+        if(!MftMtf(sys, fld, wvl, M, mft) || !MftMtf(sys, fld, wvl, fine_pixels, mft_fine)){
+            std::cerr << label << ": MFT PSF failed" << std::endl;
+            errors++;
+            continue;
+        }
+        errors += Compare(label + " MFT sagittal", freqs, mft.sag, ref_sag, freqs.back());
+        errors += Compare(label + " MFT tangential", freqs, mft.tan, ref_tan, freqs.back());
+
+        Mtf acf;
+        AutocorrelationMTF acf_mtf(&sys);
+        acf_mtf.Compute(fld, freqs, pupil_samples, acf.tan, acf.sag);
+        errors += Compare(label + " autocorrelation sagittal", freqs, acf.sag, ref_sag, max_alias_free_freq);
+        errors += Compare(label + " autocorrelation tangential", freqs, acf.tan, ref_tan, max_alias_free_freq);
+        errors += Compare(label + " autocorrelation sagittal to fine MFT", freqs, acf.sag, mft_fine.sag, freqs.back());
+        errors += Compare(label + " autocorrelation tangential to fine MFT", freqs, acf.tan, mft_fine.tan, freqs.back());
+    }
+
+    // invalid sampling is rejected
+    DiffractivePSF psf(&sys);
+    if(psf.CreateByMft(fld_spec->GetField(0), wvl, 1, M, L/M) != nullptr){
+        std::cerr << "MFT PSF accepted a single pupil sample" << std::endl;
+        errors++;
+    }
+
+    AutocorrelationMTF acf_mtf(&sys);
+    if(acf_mtf.plot(pupil_samples, 100.0, 0.0)->NumberOfGraphs() != 0){
+        std::cerr << "Autocorrelation MTF accepted a zero frequency step" << std::endl;
+        errors++;
+    }
+
+    std::cout << num_flds << " fields compared up to " << freqs.back() << " cycles, " << errors << " mismatches" << std::endl;
+
+    return (errors == 0) ? 0 : 1;
+}
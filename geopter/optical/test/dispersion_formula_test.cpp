@@ -0,0 +1,223 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 17th, 2026
+********************************************************************************/
+
+/**
+ * dispersion_formula_test
+ *
+ * Checks the batch dispersion formulas against the scalar ones.
+ *   DispersionFormula::Evaluate over wavelengths and over glasses, for every formula type with synthetic coefficients.
+ *   Glass::RefractiveIndices against Glass::RefractiveIndex, for every catalog glass at two temperatures.
+ *
+ * Usage: dispersion_formula_test AGF_DIR
+ */
+
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+#include <cmath>
+
+#include "optical.h"
+
+using namespace geopter;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr double tolerance = 1.0e-11;
+
+using ScalarFormula = double (*)(double, const std::vector<double>&);
+
+struct FormulaCase
+{
+    std::string name;
+    DispersionFormula::Type type;
+    ScalarFormula scalar;
+    std::vector<double> coefs;
+};
+
+/** Coefficients close to those of real glasses, so that every term contributes */
+std::vector<FormulaCase> CreateFormulaCases()
+{
+    using Type = DispersionFormula::Type;
+    return {
+        {"Schott",            Type::Schott,            DispersionFormula::Schott,            {2.27, -1.0e-2, 1.1e-2, 2.0e-4, -1.0e-5, 1.0e-6}},
+        {"Sellmeier1",        Type::Sellmeier1,        DispersionFormula::Sellmeier1,        {1.04, 6.0e-3, 0.23, 2.0e-2, 1.01, 103.6}},
+        {"Herzberger",        Type::Herzberger,        DispersionFormula::Herzberger,        {1.50, 4.0e-3, 1.0e-4, -3.0e-3, 1.0e-5, -2.0e-7}},
+        {"Sellmeier2",        Type::Sellmeier2,        DispersionFormula::Sellmeier2,        {0.1, 1.0, 1.0e-2, 0.9, 100.0}},
+        {"Conrady",           Type::Conrady,           DispersionFormula::Conrady,           {1.49, 5.0e-3, 1.0e-4}},
+        {"Sellmeier3",        Type::Sellmeier3,        DispersionFormula::Sellmeier3,        {1.0, 6.0e-3, 0.2, 2.0e-2, 0.9, 100.0, 0.1, 5.0e-3}},
+        {"HandbookOfOptics1", Type::HandbookOfOptics1, DispersionFormula::HandbookOfOptics1, {2.2, 1.2e-2, 1.5e-2, 1.0e-2}},
+        {"HandbookOfOptics2", Type::HandbookOfOptics2, DispersionFormula::HandbookOfOptics2, {1.3, 0.9, 1.0e-2, 1.0e-2}},
+        {"Sellmeier4",        Type::Sellmeier4,        DispersionFormula::Sellmeier4,        {1.1, 1.0, 1.0e-2, 0.9, 100.0}},
+        {"Extended1",         Type::Extended1,         DispersionFormula::Extended1,         {2.27, -1.0e-2, 1.1e-2, 2.0e-4, -1.0e-5, 1.0e-6, -1.0e-7, 1.0e-8}},
+        {"Sellmeier5",        Type::Sellmeier5,        DispersionFormula::Sellmeier5,        {1.0, 6.0e-3, 0.2, 2.0e-2, 0.9, 100.0, 0.1, 5.0e-3, 0.05, 200.0}},
+        {"Extended2",         Type::Extended2,         DispersionFormula::Extended2,         {2.27, -1.0e-2, 1.1e-2, 2.0e-4, -1.0e-5, 1.0e-6, 1.0e-4, -1.0e-5}},
+        {"Nikon_Hikari",      Type::Nikon_Hikari,      DispersionFormula::Nikon_Hikari,      {2.27, -1.0e-2, 1.0e-4, 1.1e-2, -1.0e-5, 1.0e-6, 2.0e-7, -1.0e-7, 1.0e-8}},
+    };
+}
+
+/** Glasses used outside of their range give NaN on both paths */
+bool IsClose(double a, double b)
+{
+    if(std::isnan(a) || std::isnan(b)){
+        return std::isnan(a) && std::isnan(b);
+    }
+    return std::fabs(a - b) <= tolerance*std::max(1.0, std::fabs(b));
+}
+
+std::vector<std::string> FindAgfFiles(const fs::path& dir)
+{
+    std::vector<std::string> agfs;
+    std::error_code ec;
+    for(auto& e : fs::directory_iterator(dir, ec)){
+        std::string ext = e.path().extension().u8string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        if(e.is_regular_file() && ext == ".agf"){
+            agfs.push_back(e.path().u8string());
+        }
+    }
+    std::sort(agfs.begin(), agfs.end());
+    return agfs;
+}
+
+/** Both batch overloads against the scalar formula */
+int TestFormula(const FormulaCase& fc, const std::vector<double>& lambdas)
+{
+    const int num_wvls = lambdas.size();
+    int errors = 0;
+
+    std::vector<double> c = fc.coefs;
+    c.resize(12, 0.0);
+
+    std::vector<double> n(num_wvls);
+    DispersionFormula::Evaluate(fc.type, c, lambdas.data(), n.data(), num_wvls);
+
+    for(int i = 0; i < num_wvls; i++){
+        const double ref = fc.scalar(lambdas[i], c);
+        if(!IsClose(n[i], ref)){
+            std::cerr << fc.name << " over wavelengths at " << lambdas[i] << ": " << n[i] << " vs " << ref << std::endl;
+            errors++;
+        }
+    }
+
+    // glasses with the coefficients scaled slightly apart from each other
+    constexpr int num_glasses = 5;
+    constexpr int stride = 12;
+    std::vector<double> coefs(num_glasses*stride);
+    for(int g = 0; g < num_glasses; g++){
+        for(int k = 0; k < stride; k++){
+            coefs[g*stride + k] = c[k]*(1.0 + 0.01*g);
+        }
+    }
+
+    std::vector<double> ng(num_glasses);
+    for(double l : lambdas){
+        DispersionFormula::Evaluate(fc.type, coefs.data(), stride, l, ng.data(), num_glasses);
+        for(int g = 0; g < num_glasses; g++){
+            const std::vector<double> cg(coefs.begin() + g*stride, coefs.begin() + (g+1)*stride);
+            const double ref = fc.scalar(l, cg);
+            if(!IsClose(ng[g], ref)){
+                std::cerr << fc.name << " over glasses, glass " << g << " at " << l << ": " << ng[g] << " vs " << ref << std::endl;
+                errors++;
+            }
+        }
+    }
+
+    return errors;
+}
+
+/** Glass::RefractiveIndices against Glass::RefractiveIndex for all catalog glasses */
+int TestCatalogs(const MaterialLibrary& lib, const std::vector<double>& wvls_nm, long long& num_indices)
+{
+    int errors = 0;
+    for(int ci = 0; ci < lib.NumberOfCatalogs(); ci++){
+        GlassCatalog* cat = MaterialLibrary::GetGlassCatalog(ci);
+        for(int gi = 0; gi < cat->NumberOfGlasses(); gi++){
+            auto glass = cat->GetGlass(gi);
+            const std::vector<double> n = glass->RefractiveIndices(wvls_nm);
+            for(size_t i = 0; i < wvls_nm.size(); i++){
+                const double ref = glass->RefractiveIndex(wvls_nm[i]);
+                num_indices++;
+                if(!IsClose(n[i], ref)){
+                    if(errors < 20){
+                        std::cerr << glass->Name() << " at " << wvls_nm[i] << "nm: " << n[i] << " vs " << ref << std::endl;
+                    }
+                    errors++;
+                }
+            }
+        }
+    }
+    return errors;
+}
+
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+    if(argc < 2){
+        std::cerr << "Usage: dispersion_formula_test AGF_DIR" << std::endl;
+        return 1;
+    }
+
+    const std::vector<std::string> agfs = FindAgfFiles(argv[1]);
+    if(agfs.empty()){
+        std::cerr << "No AGF file found" << std::endl;
+        return 1;
+    }
+
+    // 365nm to 1014nm, within the range of every catalog
+    std::vector<double> wvls_nm;
+    for(int i = 0; i < 40; i++){
+        wvls_nm.push_back(365.0 + 650.0*i/39.0);
+    }
+    std::vector<double> lambdas(wvls_nm.size());
+    std::transform(wvls_nm.begin(), wvls_nm.end(), lambdas.begin(), [](double w){ return w/1000.0; });
+
+    int errors = 0;
+    for(auto& fc : CreateFormulaCases()){
+        errors += TestFormula(fc, lambdas);
+    }
+    std::cout << "Formulas: " << errors << " mismatches" << std::endl;
+
+    // leave the source tree untouched
+    GlassCatalog::SetCacheEnabled(false);
+
+    MaterialLibrary lib;
+    lib.LoadAgfFiles(agfs);
+
+    const double T0 = Environment::Temperature();
+    long long num_indices = 0;
+    for(double T : {T0, 40.0}){
+        Environment::SetTemperature(T);
+        errors += TestCatalogs(lib, wvls_nm, num_indices);
+    }
+    Environment::SetTemperature(T0);
+
+    std::cout << num_indices << " catalog indices compared, " << errors << " mismatches in total" << std::endl;
+
+    return (errors == 0) ? 0 : 1;
+}
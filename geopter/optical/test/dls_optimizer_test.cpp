@@ -0,0 +1,219 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 17th, 2026
+********************************************************************************/
+
+/**
+ * dls_optimizer_test
+ *
+ * Checks DlsOptimizer on the Kingslake doublet, whose glasses are model glasses.
+ * The Jacobian is compared with central differences. A focal length target on the last curvature must be met,
+ * and the optimum of the focal length and the RMS spot over the last curvature and the image distance
+ * must be a local minimum of the merit function. The result must be written back to the system.
+ *
+ * Usage: dls_optimizer_test EXAMPLE_DIR
+ */
+
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+#include <cmath>
+
+#include "optical.h"
+
+using namespace geopter;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr double efl_tolerance = 1.0e-6;
+constexpr double jacobian_tolerance = 1.0e-4;
+
+/** Probe step relative to the scale of each variable, around the optimum */
+constexpr double probe = 1.0e-3;
+
+bool IsClose(double a, double b, double tol)
+{
+    return std::fabs(a - b) <= tol*std::max(1.0, std::max(std::fabs(a), std::fabs(b)));
+}
+
+/** Last curvature and the image distance */
+void AddVariables(DlsOptimizer& opt, const OpticalSystem& sys)
+{
+    const int ns = sys.GetOpticalAssembly()->NumberOfSurfaces();
+    opt.AddVariable(OptimizationVariable(OptimizationVariable::Curvature, ns - 2));
+    opt.AddVariable(OptimizationVariable(OptimizationVariable::Thickness, ns - 2));
+}
+
+int TestJacobian(OpticalSystem& sys)
+{
+    DlsOptimizer opt(&sys);
+    AddVariables(opt, sys);
+    MeritFunction* merit = opt.GetMeritFunction();
+    merit->AddOperand(MeritOperand(MeritOperand::EffectiveFocalLength, 0.0));
+    merit->AddOperand(MeritOperand(MeritOperand::RmsSpot, 0.0, 1.0, 1));
+
+    const Eigen::MatrixXd jac = opt.Jacobian();
+
+    int errors = 0;
+    for(int j = 0; j < opt.NumberOfVariables(); j++){
+        const OptimizationVariable& var = opt.GetVariable(j);
+        const double x = var.Value(&sys);
+        const double h = 1.0e-4*var.Scale(&sys);
+
+        var.SetValue(&sys, x + h);
+        sys.UpdateModel();
+        const Eigen::VectorXd r_plus = merit->Residuals(&sys);
+        var.SetValue(&sys, x - h);
+        sys.UpdateModel();
+        const Eigen::VectorXd r_minus = merit->Residuals(&sys);
+        var.SetValue(&sys, x);
+        sys.UpdateModel();
+
+        const Eigen::VectorXd col = (r_plus - r_minus)/(2.0*h);
+        const double scale = std::max(1.0e-12, col.cwiseAbs().maxCoeff());
+        if( (jac.col(j) - col).cwiseAbs().maxCoeff() > jacobian_tolerance*scale ){
+            std::cerr << "Jacobian column of " << var.Name() << ": " << jac.col(j).transpose() << " vs " << col.transpose() << std::endl;
+            errors++;
+        }
+    }
+
+    return errors;
+}
+
+int TestFocalLength(OpticalSystem& sys)
+{
+    const double efl0 = sys.GetFirstOrderData()->effective_focal_length;
+    const double target = 1.05*efl0;
+
+    DlsOptimizer opt(&sys);
+    const int ns = sys.GetOpticalAssembly()->NumberOfSurfaces();
+    opt.AddVariable(OptimizationVariable(OptimizationVariable::Curvature, ns - 2));
+    opt.GetMeritFunction()->AddOperand(MeritOperand(MeritOperand::EffectiveFocalLength, target));
+
+    const DlsOptimizer::Result result = opt.Optimize();
+
+    int errors = 0;
+    if( !result.converged || result.stalled ){
+        std::cerr << "EFL: not converged in " << result.iterations << " iterations" << std::endl;
+        errors++;
+    }
+
+    const double efl = sys.GetFirstOrderData()->effective_focal_length;
+    if( !IsClose(efl, target, efl_tolerance) ){
+        std::cerr << "EFL: " << efl << " vs the target " << target << std::endl;
+        errors++;
+    }
+    if( !(result.final_merit < result.initial_merit) ){
+        std::cerr << "EFL: merit " << result.final_merit << " from " << result.initial_merit << std::endl;
+        errors++;
+    }
+
+    return errors;
+}
+
+int TestLocalMinimum(OpticalSystem& sys)
+{
+    const double efl0 = sys.GetFirstOrderData()->effective_focal_length;
+
+    DlsOptimizer opt(&sys);
+    AddVariables(opt, sys);
+    MeritFunction* merit = opt.GetMeritFunction();
+    merit->AddOperand(MeritOperand(MeritOperand::EffectiveFocalLength, efl0, 1.0e-2));
+    merit->AddOperand(MeritOperand(MeritOperand::RmsSpot, 0.0, 1.0, 0));
+    merit->AddOperand(MeritOperand(MeritOperand::RmsSpot, 0.0, 1.0, 1));
+
+    const DlsOptimizer::Result result = opt.Optimize();
+
+    int errors = 0;
+    if( !result.converged || result.stalled ){
+        std::cerr << "EFL and spot: not converged in " << result.iterations << " iterations" << std::endl;
+        errors++;
+    }
+
+    // written back to the system
+    const double value = merit->Value(&sys);
+    if( !IsClose(value, result.final_merit, 1.0e-12) ){
+        std::cerr << "EFL and spot: merit of the system " << value << " vs the result " << result.final_merit << std::endl;
+        errors++;
+    }
+    if( !(value < result.initial_merit) ){
+        std::cerr << "EFL and spot: merit " << value << " from " << result.initial_merit << std::endl;
+        errors++;
+    }
+
+    // no lower merit around the optimum
+    for(int j = 0; j < opt.NumberOfVariables(); j++){
+        const OptimizationVariable& var = opt.GetVariable(j);
+        const double x = var.Value(&sys);
+        const double h = probe*var.Scale(&sys);
+        for(double d : {-h, h}){
+            var.SetValue(&sys, x + d);
+            sys.UpdateModel();
+            const double probed = merit->Value(&sys);
+            if(probed < value){
+                std::cerr << "EFL and spot: " << probed << " with " << var.Name() << " moved by " << d << " is lower than " << value << std::endl;
+                errors++;
+            }
+        }
+        var.SetValue(&sys, x);
+        sys.UpdateModel();
+    }
+
+    return errors;
+}
+
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+    if(argc < 2){
+        std::cerr << "Usage: dls_optimizer_test EXAMPLE_DIR" << std::endl;
+        return 1;
+    }
+
+    const fs::path lens_path = fs::path(argv[1]) / "book" / "kingslake_doublet.json";
+    if(!fs::exists(lens_path)){
+        std::cerr << "Missing " << lens_path.u8string() << std::endl;
+        return 1;
+    }
+
+    OpticalSystem sys;
+
+    int errors = 0;
+
+    sys.LoadFile(lens_path.u8string());
+    errors += TestJacobian(sys);
+
+    sys.LoadFile(lens_path.u8string());
+    errors += TestFocalLength(sys);
+
+    sys.LoadFile(lens_path.u8string());
+    errors += TestLocalMinimum(sys);
+
+    std::cout << "3 optimizations compared, " << errors << " mismatches" << std::endl;
+
+    return (errors == 0) ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 17th, 2026
+********************************************************************************/
+
+/**
+ * fft_engine_test
+ *
+ * Checks FftEngine against a naive discrete Fourier transform, for power-of-two and other sizes.
+ * The complex and the real transforms are compared forward, and the inverse transforms must give back the input.
+ *
+ * Usage: fft_engine_test
+ */
+
+#define _USE_MATH_DEFINES
+#include <iostream>
+#include <cmath>
+#include <complex>
+#include <random>
+
+#include "Eigen/Core"
+#include "common/fft_engine.h"
+
+using namespace geopter;
+
+namespace {
+
+/** Tolerance relative to the largest magnitude of the matrix */
+constexpr double tolerance = 1.0e-10;
+
+/** Unscaled forward DFT, summed directly */
+Eigen::MatrixXcd NaiveDft(const Eigen::MatrixXcd& in)
+{
+    const int rows = in.rows();
+    const int cols = in.cols();
+    Eigen::MatrixXcd out = Eigen::MatrixXcd::Zero(rows, cols);
+    for(int u = 0; u < rows; u++){
+        for(int v = 0; v < cols; v++){
+            std::complex<double> sum = 0.0;
+            for(int r = 0; r < rows; r++){
+                for(int c = 0; c < cols; c++){
+                    const double phase = -2.0*M_PI*( (double)(u*r)/rows + (double)(v*c)/cols );
+                    sum += in(r,c)*std::polar(1.0, phase);
+                }
+            }
+            out(u,v) = sum;
+        }
+    }
+    return out;
+}
+
+bool IsClose(const Eigen::MatrixXcd& a, const Eigen::MatrixXcd& b)
+{
+    if(a.rows() != b.rows() || a.cols() != b.cols()){
+        return false;
+    }
+    const double scale = std::max(1.0, b.cwiseAbs().maxCoeff());
+    return (a - b).cwiseAbs().maxCoeff() <= tolerance*scale;
+}
+
+int TestSize(int rows, int cols, std::mt19937& rng)
+{
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    const std::string label = std::to_string(rows) + "x" + std::to_string(cols);
+    int errors = 0;
+
+    Eigen::MatrixXcd in(rows, cols);
+    Eigen::MatrixXd in_real(rows, cols);
+    for(int r = 0; r < rows; r++){
+        for(int c = 0; c < cols; c++){
+            in(r,c) = std::complex<double>(dist(rng), dist(rng));
+            in_real(r,c) = dist(rng);
+        }
+    }
+
+    // complex
+    const Eigen::MatrixXcd ref = NaiveDft(in);
+    Eigen::MatrixXcd data = in;
+    FftEngine::Forward(data);
+    if(!IsClose(data, ref)){
+        std::cerr << label << ": forward transform differs from the DFT" << std::endl;
+        errors++;
+    }
+
+    FftEngine::Inverse(data);
+    if(!IsClose(data, in)){
+        std::cerr << label << ": inverse transform does not restore the input" << std::endl;
+        errors++;
+    }
+
+    // real, the first rows/2+1 rows of the full spectrum
+    const Eigen::MatrixXcd ref_real = NaiveDft(in_real.cast< std::complex<double> >());
+    Eigen::MatrixXcd half;
+    FftEngine::ForwardReal(half, in_real);
+    if(!IsClose(half, ref_real.topRows(rows/2 + 1))){
+        std::cerr << label << ": real forward transform differs from the DFT" << std::endl;
+        errors++;
+    }
+
+    Eigen::MatrixXd out_real;
+    FftEngine::InverseReal(out_real, half, rows);
+    if(out_real.rows() != rows || out_real.cols() != cols || (out_real - in_real).cwiseAbs().maxCoeff() > tolerance){
+        std::cerr << label << ": real inverse transform does not restore the input" << std::endl;
+        errors++;
+    }
+
+    return errors;
+}
+
+} // namespace
+
+
+int main()
+{
+    std::mt19937 rng(1234);
+
+    // powers of two, odd, prime and mixed sizes, and a size large enough to be split over the thread pool
+    const int sizes[][2] = {{1, 1}, {2, 2}, {8, 8}, {16, 4}, {7, 5}, {12, 20}, {13, 13}, {9, 32}, {64, 64}};
+
+    int errors = 0;
+    for(auto& s : sizes){
+        errors += TestSize(s[0], s[1], rng);
+    }
+
+    std::cout << (sizeof(sizes)/sizeof(sizes[0])) << " sizes compared, " << errors << " mismatches" << std::endl;
+
+    return (errors == 0) ? 0 : 1;
+}
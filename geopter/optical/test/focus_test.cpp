@@ -0,0 +1,278 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 17th, 2026
+********************************************************************************/
+
+/**
+ * focus_test
+ *
+ * Checks ThroughFocus against tracing the system again with the image surface moved by each defocus,
+ * on the last field of the example lenses. Compared per defocus plane are the RMS and geometric spot radius,
+ * the spot centroid and the geometric MTF.
+ *
+ * Checks BestFocusSolve on a known defocus. The image surface is moved away from the solved focus,
+ * and the solve must bring it back. The solved focus must be a minimum of the corresponding MeritOperand.
+ *
+ * Usage: focus_test EXAMPLE_DIR AGF_DIR
+ */
+
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+#include <cmath>
+
+#include "optical.h"
+
+using namespace geopter;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/** Absolute tolerance on lengths and MTF, relative to the magnitude for values larger than 1 */
+constexpr double tolerance = 1.0e-9;
+
+constexpr int nrd = 21;
+constexpr double mtf_freq = 30.0;
+
+/** Tolerance on the focus found by the iterative RMS wavefront solve */
+constexpr double wavefront_focus_tolerance = 1.0e-8;
+
+bool IsClose(double a, double b, double tol = tolerance)
+{
+    return std::fabs(a - b) <= tol*std::max(1.0, std::max(std::fabs(a), std::fabs(b)));
+}
+
+std::vector<std::string> FindAgfFiles(const fs::path& dir)
+{
+    std::vector<std::string> agfs;
+    std::error_code ec;
+    for(auto& e : fs::directory_iterator(dir, ec)){
+        std::string ext = e.path().extension().u8string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        if(e.is_regular_file() && ext == ".agf"){
+            agfs.push_back(e.path().u8string());
+        }
+    }
+    std::sort(agfs.begin(), agfs.end());
+    return agfs;
+}
+
+/** Spot metrics of the field on the current image surface, traced like ThroughFocus */
+std::vector<double> TraceMetrics(OpticalSystem& sys, const Field* fld)
+{
+    std::vector<double> metrics(ThroughFocus::NumberOfMetrics, 0.0);
+
+    SequentialTrace tracer(&sys);
+    tracer.SetApertureCheck(true);
+    tracer.SetApplyVig(false);
+
+    WavelengthSpec* wvl_spec = sys.GetOpticalSpec()->GetWavelengthSpec();
+    const double ref_wvl = wvl_spec->ReferenceWavelength();
+
+    auto ref_path = tracer.GetSequentialPath(ref_wvl);
+    auto chief_ray = std::make_shared<Ray>(ref_path->Size());
+    if(TRACE_SUCCESS != tracer.TracePupilRay(chief_ray, *ref_path, Eigen::Vector2d(0.0, 0.0), fld, ref_wvl)){
+        return metrics;
+    }
+
+    const std::vector<Eigen::Vector2d> pupils = SequentialTrace::GridPupils(nrd);
+    std::vector<double> us, vs;
+    auto ray = std::make_shared<Ray>(ref_path->Size());
+    for(int wi = 0; wi < wvl_spec->NumberOfWavelengths(); wi++){
+        const double wvl = wvl_spec->GetWavelength(wi)->Value();
+        auto seq_path = tracer.GetSequentialPath(wvl);
+        for(auto& pupil : pupils){
+            if(TRACE_SUCCESS == tracer.TracePupilRay(ray, *seq_path, pupil, fld, wvl)){
+                us.push_back(ray->GetBack()->X() - chief_ray->GetBack()->X());
+                vs.push_back(ray->GetBack()->Y() - chief_ray->GetBack()->Y());
+            }
+        }
+    }
+
+    const double n = static_cast<double>(us.size());
+    double cu = 0.0, cv = 0.0;
+    for(size_t i = 0; i < us.size(); i++){
+        cu += us[i]/n;
+        cv += vs[i]/n;
+    }
+
+    double sum_r2 = 0.0, max_r2 = 0.0;
+    for(size_t i = 0; i < us.size(); i++){
+        const double r2 = (us[i] - cu)*(us[i] - cu) + (vs[i] - cv)*(vs[i] - cv);
+        sum_r2 += r2;
+        max_r2 = std::max(max_r2, r2);
+    }
+
+    metrics[ThroughFocus::RmsSpotRadius] = sqrt(sum_r2/n);
+    metrics[ThroughFocus::GeoSpotRadius] = sqrt(max_r2);
+    metrics[ThroughFocus::CentroidX] = cu;
+    metrics[ThroughFocus::CentroidY] = cv;
+    metrics[ThroughFocus::MtfSagittal]   = GeometricalMTF::LineSpreadMtf({mtf_freq}, us, 16)[0];
+    metrics[ThroughFocus::MtfTangential] = GeometricalMTF::LineSpreadMtf({mtf_freq}, vs, 16)[0];
+    return metrics;
+}
+
+int TestThroughFocus(OpticalSystem& sys, const std::string& lens)
+{
+    constexpr double focus_min = -0.2;
+    constexpr double focus_max = 0.2;
+    constexpr int num_steps = 5;
+
+    FieldSpec* fld_spec = sys.GetOpticalSpec()->GetFieldSpec();
+    const Field* fld = fld_spec->GetField(fld_spec->NumberOfFields() - 1);
+
+    ThroughFocus through_focus(&sys);
+    auto grid = through_focus.Compute(fld, nrd, focus_min, focus_max, num_steps, mtf_freq);
+
+    Gap* img_gap = sys.GetOpticalAssembly()->ImageSpaceGap();
+    const double thi = img_gap->Thickness();
+
+    int errors = 0;
+
+    for(int s = 0; s < num_steps; s++){
+        const double dz = grid->GetValueAt(s, ThroughFocus::Defocus);
+        if(!IsClose(dz, focus_min + (focus_max - focus_min)*s/(num_steps - 1))){
+            std::cerr << lens << ": unexpected defocus " << dz << std::endl;
+            errors++;
+        }
+
+        img_gap->SetThickness(thi + dz);
+        sys.UpdateModel();
+        const std::vector<double> ref = TraceMetrics(sys, fld);
+
+        for(int k = ThroughFocus::RmsSpotRadius; k < ThroughFocus::NumberOfMetrics; k++){
+            if(!IsClose(grid->GetValueAt(s, k), ref[k])){
+                std::cerr << lens << " defocus " << dz << ", metric " << k << ": " << grid->GetValueAt(s, k) << " vs " << ref[k] << std::endl;
+                errors++;
+            }
+        }
+    }
+
+    img_gap->SetThickness(thi);
+    sys.UpdateModel();
+
+    return errors;
+}
+
+/** Focus shifted by a known defocus is brought back by the solve */
+int TestBestFocus(OpticalSystem& sys, const std::string& lens, int criterion)
+{
+    constexpr double shift = 0.1;
+    constexpr double probe = 1.0e-3;
+
+    const std::string label = lens + ((criterion == BestFocusSolve::RmsSpot) ? " RMS spot" : " RMS wavefront");
+    const int fi = sys.GetOpticalSpec()->GetFieldSpec()->NumberOfFields() - 1;
+    const int gi = sys.GetOpticalAssembly()->NumberOfSurfaces() - 2;
+    const double tol = (criterion == BestFocusSolve::RmsSpot) ? tolerance : wavefront_focus_tolerance;
+
+    Gap* img_gap = sys.GetOpticalAssembly()->ImageSpaceGap();
+    const double thi = img_gap->Thickness();
+
+    BestFocusSolve solve(gi, criterion, fi, nrd);
+
+    solve.Apply(&sys);
+    sys.UpdateModel();
+    const double best = img_gap->Thickness();
+
+    int errors = 0;
+
+    img_gap->SetThickness(best + shift);
+    sys.UpdateModel();
+    solve.Apply(&sys);
+    sys.UpdateModel();
+    if(!IsClose(solve.LastDefocus(), -shift, tol)){
+        std::cerr << label << ": defocus " << solve.LastDefocus() << " for a shift of " << shift << std::endl;
+        errors++;
+    }
+
+    if(!IsClose(img_gap->Thickness(), best, tol)){
+        std::cerr << label << ": focus " << img_gap->Thickness() << " vs " << best << std::endl;
+        errors++;
+    }
+
+    // minimum of the merit operand
+    MeritOperand op((criterion == BestFocusSolve::RmsSpot) ? MeritOperand::RmsSpot : MeritOperand::RmsOpd, 0.0, 1.0, fi, -1);
+    op.SetGridSize(nrd);
+
+    img_gap->SetThickness(best);
+    sys.UpdateModel();
+    const double value = op.Evaluate(&sys);
+    for(double d : {-probe, probe}){
+        img_gap->SetThickness(best + d);
+        sys.UpdateModel();
+        const double probed = op.Evaluate(&sys);
+        if(!(probed > value)){
+            std::cerr << label << ": " << probed << " at " << d << " from the focus is not larger than " << value << std::endl;
+            errors++;
+        }
+    }
+
+    img_gap->SetThickness(thi);
+    sys.UpdateModel();
+
+    return errors;
+}
+
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+    if(argc < 3){
+        std::cerr << "Usage: focus_test EXAMPLE_DIR AGF_DIR" << std::endl;
+        return 1;
+    }
+
+    const fs::path example_dir = argv[1];
+    const std::vector<std::string> lenses = { (example_dir / "dbgauss.json").u8string(), (example_dir / "book" / "kingslake_doublet.json").u8string() };
+    const std::vector<std::string> agfs = FindAgfFiles(argv[2]);
+    if(agfs.empty()){
+        std::cerr << "No AGF file found" << std::endl;
+        return 1;
+    }
+
+    // leave the source tree untouched
+    GlassCatalog::SetCacheEnabled(false);
+
+    OpticalSystem sys;
+    sys.GetMaterialLib()->LoadAgfFiles(agfs);
+
+    int errors = 0;
+    for(auto& lens_path : lenses){
+        if(!fs::exists(lens_path)){
+            std::cerr << "Missing " << lens_path << std::endl;
+            errors++;
+            continue;
+        }
+        sys.LoadFile(lens_path);
+        const std::string lens = fs::path(lens_path).stem().u8string();
+        errors += TestThroughFocus(sys, lens);
+        errors += TestBestFocus(sys, lens, BestFocusSolve::RmsSpot);
+        errors += TestBestFocus(sys, lens, BestFocusSolve::RmsWavefront);
+    }
+
+    std::cout << lenses.size() << " lenses compared, " << errors << " mismatches" << std::endl;
+
+    return (errors == 0) ? 0 : 1;
+}
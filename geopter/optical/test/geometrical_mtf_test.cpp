@@ -0,0 +1,191 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 17th, 2026
+********************************************************************************/
+
+/**
+ * geometrical_mtf_test
+ *
+ * Checks the line spread histogram MTF of GeometricalMTF against the direct sum over the rays.
+ *   LineSpreadMtf on a synthetic Gaussian spot, against the direct sum and the analytic MTF exp(-2 pi^2 sigma^2 f^2).
+ *   GeometricalMTF::plot with both methods, on every field of the example lenses.
+ *
+ * Usage: geometrical_mtf_test EXAMPLE_DIR AGF_DIR
+ */
+
+#define _USE_MATH_DEFINES
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+#include <random>
+#include <cmath>
+
+#include "optical.h"
+
+using namespace geopter;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/** Absolute tolerance between the histogram and the direct sum */
+constexpr double tolerance = 2.0e-3;
+
+/** Absolute tolerance against the analytic MTF, which the finite number of rays only approximates */
+constexpr double sampling_tolerance = 1.0e-2;
+
+constexpr int nrd = 32;
+
+std::vector<std::string> FindAgfFiles(const fs::path& dir)
+{
+    std::vector<std::string> agfs;
+    std::error_code ec;
+    for(auto& e : fs::directory_iterator(dir, ec)){
+        std::string ext = e.path().extension().u8string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        if(e.is_regular_file() && ext == ".agf"){
+            agfs.push_back(e.path().u8string());
+        }
+    }
+    std::sort(agfs.begin(), agfs.end());
+    return agfs;
+}
+
+/** MTF along x summed over every ray */
+double DirectSum(double freq, const std::vector<double>& coords)
+{
+    double rc = 0.0, rs = 0.0;
+    for(double x : coords){
+        rc += cos(2.0*M_PI*freq*x);
+        rs += sin(2.0*M_PI*freq*x);
+    }
+    return std::hypot(rc, rs)/static_cast<double>(coords.size());
+}
+
+int TestGaussianSpot()
+{
+    constexpr double sigma = 0.005;
+    constexpr int num_rays = 20000;
+
+    std::mt19937 rng(1234);
+    std::normal_distribution<double> dist(0.01, sigma);
+    std::vector<double> coords(num_rays);
+    for(auto& x : coords){
+        x = dist(rng);
+    }
+
+    std::vector<double> freqs;
+    for(int i = 0; i <= 20; i++){
+        freqs.push_back(5.0*i);
+    }
+
+    const std::vector<double> mtf = GeometricalMTF::LineSpreadMtf(freqs, coords, 16);
+
+    int errors = 0;
+    for(size_t i = 0; i < freqs.size(); i++){
+        const double direct = DirectSum(freqs[i], coords);
+        const double analytic = exp(-2.0*M_PI*M_PI*sigma*sigma*freqs[i]*freqs[i]);
+        if(std::fabs(mtf[i] - direct) > tolerance){
+            std::cerr << "Gaussian spot at " << freqs[i] << ": " << mtf[i] << " vs direct sum " << direct << std::endl;
+            errors++;
+        }
+        if(std::fabs(mtf[i] - analytic) > sampling_tolerance){
+            std::cerr << "Gaussian spot at " << freqs[i] << ": " << mtf[i] << " vs analytic " << analytic << std::endl;
+            errors++;
+        }
+    }
+    return errors;
+}
+
+int TestLens(OpticalSystem& sys, const std::string& lens_path)
+{
+    sys.LoadFile(lens_path);
+    const std::string lens = fs::path(lens_path).stem().u8string();
+
+    GeometricalMTF histogram;
+    GeometricalMTF direct;
+    direct.SetMethod(GeometricalMTF::Method::DirectSum);
+
+    auto plot = histogram.plot(&sys, nrd);
+    auto ref_plot = direct.plot(&sys, nrd);
+
+    if(plot->NumberOfGraphs() != ref_plot->NumberOfGraphs() || plot->NumberOfGraphs() == 0){
+        std::cerr << lens << ": number of graphs differs" << std::endl;
+        return 1;
+    }
+
+    int errors = 0;
+    for(int gi = 0; gi < plot->NumberOfGraphs(); gi++){
+        auto g = plot->GetGraph(gi);
+        auto ref = ref_plot->GetGraph(gi);
+        for(int i = 0; i < ref->NumberOfData(); i++){
+            if(!(std::fabs(g->YData()[i] - ref->YData()[i]) <= tolerance)){
+                if(errors < 5){
+                    std::cerr << lens << " " << g->Name() << " at " << ref->XData()[i] << ": " << g->YData()[i] << " vs " << ref->YData()[i] << std::endl;
+                }
+                errors++;
+            }
+        }
+    }
+    return errors;
+}
+
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+    if(argc < 3){
+        std::cerr << "Usage: geometrical_mtf_test EXAMPLE_DIR AGF_DIR" << std::endl;
+        return 1;
+    }
+
+    const fs::path example_dir = argv[1];
+    const std::vector<std::string> lenses = { (example_dir / "dbgauss.json").u8string(), (example_dir / "book" / "kingslake_doublet.json").u8string() };
+    const std::vector<std::string> agfs = FindAgfFiles(argv[2]);
+    if(agfs.empty()){
+        std::cerr << "No AGF file found" << std::endl;
+        return 1;
+    }
+
+    int errors = TestGaussianSpot();
+
+    // leave the source tree untouched
+    GlassCatalog::SetCacheEnabled(false);
+
+    OpticalSystem sys;
+    sys.GetMaterialLib()->LoadAgfFiles(agfs);
+
+    for(auto& lens_path : lenses){
+        if(!fs::exists(lens_path)){
+            std::cerr << "Missing " << lens_path << std::endl;
+            errors++;
+            continue;
+        }
+        errors += TestLens(sys, lens_path);
+    }
+
+    std::cout << lenses.size() << " lenses compared, " << errors << " mismatches" << std::endl;
+
+    return (errors == 0) ? 0 : 1;
+}
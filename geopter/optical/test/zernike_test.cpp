@@ -0,0 +1,205 @@
+/*******************************************************************************
+** Geopter
+** Copyright (C) 2021 Hiiragi
+**
+** This file is part of Geopter.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public
+** License as published by the Free Software Foundation; either
+** version 2.1 of the License, or (at your option) any later version.
+**
+** This library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public
+** License along with this library; If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************
+**           Author: Hiiragi
+**          Website: https://github.com/heterophyllus/Geopter
+**          Contact: heterophyllus.work@gmail.com
+**             Date: October 17th, 2026
+********************************************************************************/
+
+/**
+ * zernike_test
+ *
+ * Checks the Fringe and Noll index tables of ZernikeFit against the published orderings, and a few terms against
+ * their polynomials. A wavefront built from known coefficients on a circular grid must be recovered by the fit,
+ * also from the cached basis. Invalid term indices must be rejected.
+ *
+ * Usage: zernike_test
+ */
+
+#define _USE_MATH_DEFINES
+#include <iostream>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "Eigen/Core"
+#include "analysis/zernike.h"
+
+using namespace geopter;
+
+namespace {
+
+constexpr double tolerance = 1.0e-10;
+
+/** (n, m) of the terms j = 1, 2, ..., with negative m for the sine terms */
+const int fringe_table[][2] = {
+    {0, 0}, {1, 1}, {1, -1}, {2, 0}, {2, 2}, {2, -2}, {3, 1}, {3, -1}, {4, 0},
+    {3, 3}, {3, -3}, {4, 2}, {4, -2}, {5, 1}, {5, -1}, {6, 0},
+    {4, 4}, {4, -4}, {5, 3}, {5, -3}, {6, 2}, {6, -2}, {7, 1}, {7, -1}, {8, 0}
+};
+
+const int noll_table[][2] = {
+    {0, 0}, {1, 1}, {1, -1}, {2, 0}, {2, -2}, {2, 2}, {3, -1}, {3, 1}, {3, -3}, {3, 3},
+    {4, 0}, {4, 2}, {4, -2}, {4, 4}, {4, -4}, {5, 1}, {5, -1}, {5, 3}, {5, -3}, {5, 5}, {5, -5},
+    {6, 0}, {6, -2}, {6, 2}, {6, -4}, {6, 4}, {6, -6}, {6, 6}
+};
+
+bool IsClose(double a, double b, double tol = tolerance)
+{
+    return std::fabs(a - b) <= tol*std::max(1.0, std::max(std::fabs(a), std::fabs(b)));
+}
+
+int TestIndices(const std::string& label, ZernikeOrdering ordering, const int (*table)[2], int num_terms)
+{
+    int errors = 0;
+    for(int j = 1; j <= num_terms; j++){
+        int n = -1, m = -1;
+        if( !ZernikeFit::Indices(j, ordering, n, m) || n != table[j-1][0] || m != table[j-1][1] ){
+            std::cerr << label << " j=" << j << ": (" << n << ", " << m << ") vs (" << table[j-1][0] << ", " << table[j-1][1] << ")" << std::endl;
+            errors++;
+        }
+    }
+    return errors;
+}
+
+/** A few terms against their polynomials */
+int TestValues()
+{
+    int errors = 0;
+    for(double rho : {0.0, 0.3, 0.7, 1.0}){
+        for(double theta : {0.0, 0.4, 2.5, -1.2}){
+            const double r2 = rho*rho;
+            const double expected[][3] = {
+                // fringe j, noll j, fringe value (noll value is scaled below)
+                {4.0,  4.0, 2.0*r2 - 1.0},
+                {5.0,  6.0, r2*cos(2.0*theta)},
+                {8.0,  7.0, (3.0*r2 - 2.0)*rho*sin(theta)},
+                {9.0, 11.0, 6.0*r2*r2 - 6.0*r2 + 1.0},
+            };
+            const double noll_scale[] = {sqrt(3.0), sqrt(6.0), sqrt(8.0), sqrt(5.0)};
+
+            for(int t = 0; t < 4; t++){
+                const double fringe = ZernikeFit::Evaluate((int)expected[t][0], ZernikeOrdering::Fringe, rho, theta);
+                const double noll   = ZernikeFit::Evaluate((int)expected[t][1], ZernikeOrdering::Noll, rho, theta);
+                if( !IsClose(fringe, expected[t][2]) || !IsClose(noll, noll_scale[t]*expected[t][2]) ){
+                    std::cerr << "term " << t << " at (" << rho << ", " << theta << "): fringe " << fringe << ", noll " << noll
+                              << " vs " << expected[t][2] << std::endl;
+                    errors++;
+                }
+            }
+        }
+    }
+    return errors;
+}
+
+/** Wavefront of known coefficients on a grid masked to the unit circle, recovered by the fit */
+int TestFit(const std::string& label, ZernikeOrdering ordering, int size, int num_terms)
+{
+    std::vector<double> coefs(num_terms);
+    for(int t = 0; t < num_terms; t++){
+        coefs[t] = 0.1*(t + 1)*((t % 2 == 0) ? 1.0 : -1.0);
+    }
+
+    // column index along x and row index along y, as written by WavefrontMap
+    Eigen::MatrixXd grid(size, size);
+    const double step = 2.0/static_cast<double>(size - 1);
+    for(int c = 0; c < size; c++){
+        for(int r = 0; r < size; r++){
+            const double x = -1.0 + step*c;
+            const double y = -1.0 + step*r;
+            const double rho = sqrt(x*x + y*y);
+            if(rho > 1.0){
+                grid(r, c) = NAN;
+                continue;
+            }
+            const double theta = atan2(y, x);
+            double w = 0.0;
+            for(int t = 0; t < num_terms; t++){
+                w += coefs[t]*ZernikeFit::Evaluate(t + 1, ordering, rho, theta);
+            }
+            grid(r, c) = w;
+        }
+    }
+
+    int errors = 0;
+
+    // the second fit uses the cached basis
+    for(int pass = 0; pass < 2; pass++){
+        const std::vector<double> fitted = ZernikeFit::Fit(grid, num_terms, ordering);
+        if((int)fitted.size() != num_terms){
+            std::cerr << label << ": " << fitted.size() << " coefficients for " << num_terms << " terms" << std::endl;
+            errors++;
+            continue;
+        }
+        for(int t = 0; t < num_terms; t++){
+            if( !IsClose(fitted[t], coefs[t], 1.0e-8) ){
+                std::cerr << label << " pass " << pass << " j=" << (t + 1) << ": " << fitted[t] << " vs " << coefs[t] << std::endl;
+                errors++;
+            }
+        }
+    }
+
+    // fewer valid cells than terms
+    const Eigen::MatrixXd small = grid.block(size/2 - 1, size/2 - 1, 2, 2);
+    if( !ZernikeFit::Fit(small, num_terms, ordering).empty() ){
+        std::cerr << label << ": fit of " << num_terms << " terms on 4 cells is not empty" << std::endl;
+        errors++;
+    }
+
+    return errors;
+}
+
+int TestInvalidIndex()
+{
+    int errors = 0;
+    for(int j : {0, -1}){
+        int n, m;
+        if(ZernikeFit::Indices(j, ZernikeOrdering::Fringe, n, m) || ZernikeFit::Indices(j, ZernikeOrdering::Noll, n, m)){
+            std::cerr << "j=" << j << " accepted" << std::endl;
+            errors++;
+        }
+        if( !std::isnan(ZernikeFit::Evaluate(j, ZernikeOrdering::Fringe, 0.5, 0.0)) ){
+            std::cerr << "j=" << j << " evaluated" << std::endl;
+            errors++;
+        }
+    }
+    return errors;
+}
+
+} // namespace
+
+
+int main()
+{
+    int errors = 0;
+
+    errors += TestIndices("fringe", ZernikeOrdering::Fringe, fringe_table, sizeof(fringe_table)/sizeof(fringe_table[0]));
+    errors += TestIndices("noll", ZernikeOrdering::Noll, noll_table, sizeof(noll_table)/sizeof(noll_table[0]));
+    errors += TestValues();
+    errors += TestFit("fringe fit", ZernikeOrdering::Fringe, 65, 25);
+    errors += TestFit("noll fit", ZernikeOrdering::Noll, 64, 28);
+    errors += TestInvalidIndex();
+
+    ZernikeFit::ClearCache();
+
+    std::cout << "Zernike terms and fits compared, " << errors << " mismatches" << std::endl;
+
+    return (errors == 0) ? 0 : 1;
+}